@@ -53,8 +53,6 @@
 #define RVO_SEED_RANDOM_NUMBER_GENERATOR 1
 #endif /* RVO_SEED_RANDOM_NUMBER_GENERATOR */
 
-#include <cmath>
-#include <cstdlib>
 #include <vector>
 
 #if RVO_OUTPUT_TIME_AND_POSITIONS
@@ -72,13 +70,16 @@
 #include "RVO.h"
 
 namespace {
-const float RVO_TWO_PI = 6.28318530717958647692F;
-
 void setupScenario(
     RVO::RVOSimulator *simulator,
     std::vector<RVO::Vector2> &goals) { /* NOLINT(runtime/references) */
+  /* Perturb the preferred velocities a little in each step to avoid deadlocks
+   * due to perfect symmetry. */
 #if RVO_SEED_RANDOM_NUMBER_GENERATOR
-  std::srand(static_cast<unsigned int>(std::time(NULL)));
+  simulator->setPerturbation(0.0001F,
+                             static_cast<unsigned int>(std::time(NULL)));
+#else
+  simulator->setPerturbation(0.0001F, 0U);
 #endif /* RVO_SEED_RANDOM_NUMBER_GENERATOR */
 
   /* Specify the global time step of the simulation. */
@@ -174,16 +175,6 @@ void setPreferredVelocities(RVO::RVOSimulator *simulator,
     }
 
     simulator->setAgentPrefVelocity(i, goalVector);
-
-    /* Perturb a little to avoid deadlocks due to perfect symmetry. */
-    float angle = static_cast<float>(std::rand()) * RVO_TWO_PI /
-                  static_cast<float>(RAND_MAX);
-    float dist = static_cast<float>(std::rand()) * 0.0001F /
-                 static_cast<float>(RAND_MAX);
-
-    simulator->setAgentPrefVelocity(
-        i, simulator->getAgentPrefVelocity(i) +
-               dist * RVO::Vector2(std::cos(angle), std::sin(angle)));
   }
 }
 
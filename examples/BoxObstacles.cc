@@ -0,0 +1,132 @@
+/*
+ * BoxObstacles.cc
+ * RVO2 Library
+ *
+ * SPDX-FileCopyrightText: 2008 University of North Carolina at Chapel Hill
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Please send all bug reports to <geom@cs.unc.edu>.
+ *
+ * The authors may be contacted via:
+ *
+ * Jur van den Berg, Stephen J. Guy, Jamie Snape, Ming C. Lin, Dinesh Manocha
+ * Dept. of Computer Science
+ * 201 S. Columbia St.
+ * Frederick P. Brooks, Jr. Computer Science Bldg.
+ * Chapel Hill, N.C. 27599-3175
+ * United States of America
+ *
+ * <https://gamma.cs.unc.edu/RVO2/>
+ */
+
+/*
+ * @file  BoxObstacles.cc
+ * @brief Example file timing 1000 agents crossing a grid of 400 square
+ *        obstacles, once with the obstacles added as box obstacles and once
+ *        with the same obstacles added as polygonal obstacles.
+ */
+
+#include <cstddef>
+#include <ctime>
+#include <iostream>
+#include <vector>
+
+#include "RVO.h"
+
+namespace {
+/* The number of simulation steps that are timed. */
+const std::size_t RVO_NUM_STEPS = 100U;
+
+void setupScenario(RVO::RVOSimulator *simulator, bool useBoxObstacles) {
+  /* Specify the global time step of the simulation. */
+  simulator->setTimeStep(0.25F);
+
+  /* Specify the default parameters for agents that are subsequently added. */
+  simulator->setAgentDefaults(15.0F, 10U, 5.0F, 5.0F, 1.0F, 2.0F);
+
+  /* Add a grid of 20 by 20 squares with sides of length 4, either as box
+   * obstacles or as polygonal obstacles with the same vertices. */
+  for (std::size_t i = 0U; i < 20U; ++i) {
+    for (std::size_t j = 0U; j < 20U; ++j) {
+      const RVO::Vector2 minCorner(-100.0F + 10.0F * static_cast<float>(i),
+                                   -100.0F + 10.0F * static_cast<float>(j));
+      const RVO::Vector2 maxCorner = minCorner + RVO::Vector2(4.0F, 4.0F);
+
+      if (useBoxObstacles) {
+        simulator->addBoxObstacle(minCorner, maxCorner);
+      } else {
+        std::vector<RVO::Vector2> vertices;
+        vertices.push_back(minCorner);
+        vertices.push_back(RVO::Vector2(maxCorner.x(), minCorner.y()));
+        vertices.push_back(maxCorner);
+        vertices.push_back(RVO::Vector2(minCorner.x(), maxCorner.y()));
+        simulator->addObstacle(vertices);
+      }
+    }
+  }
+
+  simulator->processObstacles();
+
+  /* Add agents along the vertical corridors between the squares, each
+   * preferring to move diagonally across the grid. */
+  for (std::size_t i = 0U; i < 20U; ++i) {
+    for (std::size_t j = 0U; j < 50U; ++j) {
+      const std::size_t agentNo = simulator->addAgent(
+          RVO::Vector2(-93.0F + 10.0F * static_cast<float>(i),
+                       -99.0F + 4.0F * static_cast<float>(j)));
+      simulator->setAgentPrefVelocity(
+          agentNo, (i + j) % 2U == 0U ? RVO::Vector2(1.4F, 1.4F)
+                                      : RVO::Vector2(-1.4F, -1.4F));
+    }
+  }
+}
+
+double timeSteps(bool useBoxObstacles) {
+  /* Create a new simulator instance. */
+  RVO::RVOSimulator *simulator = new RVO::RVOSimulator();
+
+  /* Set up the scenario. */
+  setupScenario(simulator, useBoxObstacles);
+
+  /* Measure the processor time, summed over all threads, of the simulation
+   * steps. */
+  const std::clock_t startTime = std::clock();
+
+  for (std::size_t i = 0U; i < RVO_NUM_STEPS; ++i) {
+    simulator->doStep();
+  }
+
+  const std::clock_t endTime = std::clock();
+
+  delete simulator;
+
+  return static_cast<double>(endTime - startTime) / CLOCKS_PER_SEC;
+}
+} /* namespace */
+
+int main() {
+  const double boxTime = timeSteps(true);
+  const double polygonTime = timeSteps(false);
+
+  /* Output the mean processor time of one simulation step in milliseconds. */
+  std::cout << "box obstacles "
+            << 1000.0 * boxTime / static_cast<double>(RVO_NUM_STEPS) << " ms"
+            << std::endl;
+  std::cout << "polygonal obstacles "
+            << 1000.0 * polygonTime / static_cast<double>(RVO_NUM_STEPS)
+            << " ms" << std::endl;
+
+  return 0;
+}
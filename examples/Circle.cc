@@ -50,10 +50,6 @@
 #include <iostream>
 #endif /* RVO_OUTPUT_TIME_AND_POSITIONS */
 
-#if _OPENMP
-#include <omp.h>
-#endif /* _OPENMP */
-
 #include "RVO.h"
 
 namespace {
@@ -93,22 +89,20 @@ void updateVisualization(RVO::RVOSimulator *simulator) {
 }
 #endif /* RVO_OUTPUT_TIME_AND_POSITIONS */
 
-void setPreferredVelocities(RVO::RVOSimulator *simulator,
-                            const std::vector<RVO::Vector2> &goals) {
-  /* Set the preferred velocity to be a vector of unit magnitude (speed) in the
+RVO::Vector2 computePreferredVelocity(const RVO::RVOSimulator *simulator,
+                                      std::size_t agentNo, void *context) {
+  /* The preferred velocity is a vector of unit magnitude (speed) in the
    * direction of the goal. */
-#ifdef _OPENMP
-#pragma omp parallel for
-#endif /* _OPENMP */
-  for (int i = 0; i < static_cast<int>(simulator->getNumAgents()); ++i) {
-    RVO::Vector2 goalVector = goals[i] - simulator->getAgentPosition(i);
-
-    if (RVO::absSq(goalVector) > 1.0F) {
-      goalVector = RVO::normalize(goalVector);
-    }
+  const std::vector<RVO::Vector2> &goals =
+      *static_cast<const std::vector<RVO::Vector2> *>(context);
+  RVO::Vector2 goalVector =
+      goals[agentNo] - simulator->getAgentPosition(agentNo);
 
-    simulator->setAgentPrefVelocity(i, goalVector);
+  if (RVO::absSq(goalVector) > 1.0F) {
+    goalVector = RVO::normalize(goalVector);
   }
+
+  return goalVector;
 }
 
 bool reachedGoal(RVO::RVOSimulator *simulator,
@@ -135,12 +129,15 @@ int main() {
   /* Set up the scenario. */
   setupScenario(simulator, goals);
 
+  /* Compute the preferred velocities within each simulation step, in parallel
+   * for all agents. */
+  simulator->setPrefVelocityCallback(&computePreferredVelocity, &goals);
+
   /* Perform and manipulate the simulation. */
   do {
 #if RVO_OUTPUT_TIME_AND_POSITIONS
     updateVisualization(simulator);
 #endif /* RVO_OUTPUT_TIME_AND_POSITIONS */
-    setPreferredVelocities(simulator, goals);
     simulator->doStep();
   } while (!reachedGoal(simulator, goals));
 
@@ -0,0 +1,873 @@
+/*
+ * Differential.cc
+ * RVO2 Library
+ *
+ * SPDX-FileCopyrightText: 2008 University of North Carolina at Chapel Hill
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Please send all bug reports to <geom@cs.unc.edu>.
+ *
+ * The authors may be contacted via:
+ *
+ * Jur van den Berg, Stephen J. Guy, Jamie Snape, Ming C. Lin, Dinesh Manocha
+ * Dept. of Computer Science
+ * 201 S. Columbia St.
+ * Frederick P. Brooks, Jr. Computer Science Bldg.
+ * Chapel Hill, N.C. 27599-3175
+ * United States of America
+ *
+ * <https://gamma.cs.unc.edu/RVO2/>
+ */
+
+/*
+ * @file  Differential.cc
+ * @brief Example file showing a differential test harness that runs randomized
+ *        and scenario-based simulations through a reference simulator, which
+ *        uses the plain serial implementation, and through candidate
+ *        simulators, which use alternative implementations, in lock-step.
+ *        After each step, the agent neighbors, obstacle neighbors, ORCA lines,
+ *        velocities and positions of the simulators are compared within a
+ *        tolerance, and the state of the candidate simulator is reset to that
+ *        of the reference simulator so that differences do not accumulate. The
+ *        agent neighbors and the range, nearest-agent, nearest-obstacle and
+ *        raycast queries of the reference simulator are also checked against
+ *        a brute-force search.
+ *        Optimized implementations are validated by adding them as variants,
+ *        and box obstacles by comparing them with polygonal obstacles.
+ *        Lists that a candidate simulator does not retain must be empty. The
+ *        interpolated positions between steps are checked separately.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#if _OPENMP
+#include <omp.h>
+#endif /* _OPENMP */
+
+#include "RVO.h"
+
+namespace {
+const float RVO_TWO_PI = 6.28318530717958647692F;
+
+/* The tolerance within which the simulators must agree, relative to the
+ * magnitude of the values compared. */
+const float RVO_TOLERANCE = 1.0e-4F;
+
+/* The count of simulation steps of each run. */
+const std::size_t RVO_NUM_STEPS = 100U;
+
+/* The maximum count of mismatches reported per run. */
+const std::size_t RVO_MAX_REPORTED_MISMATCHES = 10U;
+
+enum Scenario { RVO_SCENARIO_CIRCLE, RVO_SCENARIO_RANDOM };
+
+enum Variant {
+  RVO_VARIANT_DISTANCE_FIELD,
+  RVO_VARIANT_PARALLEL,
+  RVO_VARIANT_SCRATCH_BUFFERS,
+  RVO_VARIANT_CONSTRAINT_PRUNING,
+  RVO_VARIANT_PERTURBATION,
+  RVO_VARIANT_AUTOMATIC_PARALLELISM,
+  RVO_VARIANT_BUDGETED_STEP,
+  RVO_VARIANT_BOX_OBSTACLES
+};
+
+const char *const RVO_VARIANT_NAMES[] = {"distance field", "parallel",
+                                         "scratch buffers",
+                                         "constraint pruning",
+                                         "perturbation",
+                                         "automatic parallelism",
+                                         "budgeted step", "box obstacles"};
+
+/* Returns a pseudorandom number in [0, 1) from a linear congruential generator
+ * so that runs are reproducible across platforms. */
+float nextRandom(unsigned int &state) { /* NOLINT(runtime/references) */
+  state = 1664525U * state + 1013904223U;
+
+  return static_cast<float>(state >> 8U) / 16777216.0F;
+}
+
+void addSquareObstacle(RVO::RVOSimulator *simulator,
+                       const RVO::Vector2 &center, float halfSize,
+                       float angle) {
+  std::vector<RVO::Vector2> vertices;
+
+  for (std::size_t i = 0U; i < 4U; ++i) {
+    const float vertexAngle =
+        angle + static_cast<float>(i) * 0.25F * RVO_TWO_PI;
+    vertices.push_back(center + halfSize * RVO::Vector2(std::cos(vertexAngle),
+                                                        std::sin(vertexAngle)));
+  }
+
+  simulator->addObstacle(vertices);
+}
+
+/* Adds a box obstacle, or a polygonal obstacle with the same counterclockwise
+ * corners if specified. */
+void addBoxObstacle(RVO::RVOSimulator *simulator,
+                    const RVO::Vector2 &minCorner,
+                    const RVO::Vector2 &maxCorner, bool isPolygon) {
+  if (isPolygon) {
+    std::vector<RVO::Vector2> vertices;
+    vertices.push_back(minCorner);
+    vertices.push_back(RVO::Vector2(maxCorner.x(), minCorner.y()));
+    vertices.push_back(maxCorner);
+    vertices.push_back(RVO::Vector2(minCorner.x(), maxCorner.y()));
+    simulator->addObstacle(vertices);
+  } else {
+    simulator->addBoxObstacle(minCorner, maxCorner);
+  }
+}
+
+void setupCircleScenario(
+    RVO::RVOSimulator *simulator,
+    std::vector<RVO::Vector2> &goals, /* NOLINT(runtime/references) */
+    bool areBoxesPolygons) {
+  simulator->setTimeStep(0.25F);
+  simulator->setAgentDefaults(15.0F, 10U, 10.0F, 5.0F, 1.5F, 2.0F);
+
+  /* Agents cross a circle with obstacles around its center. */
+  for (std::size_t i = 0U; i < 100U; ++i) {
+    simulator->addAgent(
+        60.0F *
+        RVO::Vector2(std::cos(static_cast<float>(i) * RVO_TWO_PI * 0.01F),
+                     std::sin(static_cast<float>(i) * RVO_TWO_PI * 0.01F)));
+    goals.push_back(-simulator->getAgentPosition(i));
+  }
+
+  addSquareObstacle(simulator, RVO::Vector2(-15.0F, 0.0F), 6.0F, 0.0F);
+  addSquareObstacle(simulator, RVO::Vector2(15.0F, 0.0F), 6.0F, 0.3F);
+  addBoxObstacle(simulator, RVO::Vector2(-4.0F, -20.0F),
+                 RVO::Vector2(4.0F, -12.0F), areBoxesPolygons);
+
+  /* Box obstacles in the way of the agents, which reach them within the
+   * steps of a run. */
+  for (std::size_t i = 0U; i < 12U; ++i) {
+    const float angle = (static_cast<float>(i) + 0.3F) * RVO_TWO_PI / 12.0F;
+    const RVO::Vector2 center =
+        48.0F * RVO::Vector2(std::cos(angle), std::sin(angle));
+    addBoxObstacle(simulator, center - RVO::Vector2(1.5F, 1.5F),
+                   center + RVO::Vector2(1.5F, 1.5F), areBoxesPolygons);
+  }
+
+  simulator->processObstacles();
+}
+
+void setupRandomScenario(
+    RVO::RVOSimulator *simulator,
+    std::vector<RVO::Vector2> &goals, /* NOLINT(runtime/references) */
+    unsigned int seed, bool areBoxesPolygons) {
+  unsigned int state = seed;
+
+  simulator->setTimeStep(0.1F + 0.2F * nextRandom(state));
+  simulator->setAgentDefaults(10.0F, 10U, 5.0F, 5.0F, 0.5F, 1.5F);
+
+  /* Agents with random parameters, layers and collision groups. */
+  for (std::size_t i = 0U; i < 300U; ++i) {
+    const std::size_t agentNo = simulator->addAgent(
+        RVO::Vector2(100.0F * nextRandom(state) - 50.0F,
+                     100.0F * nextRandom(state) - 50.0F));
+    simulator->setAgentRadius(agentNo, 0.3F + 0.7F * nextRandom(state));
+    simulator->setAgentMaxSpeed(agentNo, 1.0F + nextRandom(state));
+    simulator->setAgentNeighborDist(agentNo, 5.0F + 10.0F * nextRandom(state));
+    simulator->setAgentMaxNeighbors(
+        agentNo, 5U + static_cast<std::size_t>(10.0F * nextRandom(state)));
+    simulator->setAgentLayer(agentNo, nextRandom(state) < 0.2F ? 1U : 0U);
+    simulator->setAgentCollisionGroups(agentNo,
+                                       nextRandom(state) < 0.2F ? 2U : 1U);
+
+    if (nextRandom(state) < 0.1F) {
+      simulator->setAgentCollisionMask(agentNo, 1U);
+    }
+
+    goals.push_back(RVO::Vector2(100.0F * nextRandom(state) - 50.0F,
+                                 100.0F * nextRandom(state) - 50.0F));
+  }
+
+  /* Random obstacles on both layers. */
+  for (std::size_t i = 0U; i < 10U; ++i) {
+    addSquareObstacle(simulator,
+                      RVO::Vector2(80.0F * nextRandom(state) - 40.0F,
+                                   80.0F * nextRandom(state) - 40.0F),
+                      1.0F + 4.0F * nextRandom(state),
+                      RVO_TWO_PI * nextRandom(state));
+  }
+
+  for (std::size_t i = 0U; i < 5U; ++i) {
+    const RVO::Vector2 minCorner(80.0F * nextRandom(state) - 40.0F,
+                                 80.0F * nextRandom(state) - 40.0F);
+    addBoxObstacle(simulator, minCorner,
+                   minCorner + RVO::Vector2(1.0F + 5.0F * nextRandom(state),
+                                            1.0F + 5.0F * nextRandom(state)),
+                   areBoxesPolygons);
+  }
+
+  std::vector<RVO::Vector2> vertices;
+  vertices.push_back(RVO::Vector2(-10.0F, -10.0F));
+  vertices.push_back(RVO::Vector2(10.0F, -10.0F));
+  vertices.push_back(RVO::Vector2(0.0F, 10.0F));
+  simulator->addObstacle(vertices, 1U);
+  simulator->processObstacles();
+}
+
+void setupScenario(
+    RVO::RVOSimulator *simulator,
+    std::vector<RVO::Vector2> &goals, /* NOLINT(runtime/references) */
+    Scenario scenario, unsigned int seed, bool areBoxesPolygons) {
+  if (scenario == RVO_SCENARIO_CIRCLE) {
+    setupCircleScenario(simulator, goals, areBoxesPolygons);
+  } else {
+    setupRandomScenario(simulator, goals, seed, areBoxesPolygons);
+  }
+}
+
+void setupVariant(RVO::RVOSimulator *simulator, Variant variant) {
+  if (variant == RVO_VARIANT_DISTANCE_FIELD) {
+    simulator->buildObstacleDistanceField(2.0F, 30.0F);
+  } else if (variant == RVO_VARIANT_SCRATCH_BUFFERS) {
+    /* Retain the lists of every other agent only. */
+    simulator->setIntrospectionEnabled(false);
+
+    for (std::size_t i = 1U; i < simulator->getNumAgents(); i += 2U) {
+      simulator->setAgentIntrospectionEnabled(i, true);
+    }
+  } else if (variant == RVO_VARIANT_CONSTRAINT_PRUNING) {
+    simulator->setConstraintPruningEnabled(true);
+  } else if (variant == RVO_VARIANT_PERTURBATION) {
+    simulator->setPerturbation(0.01F, 1U);
+  } else if (variant == RVO_VARIANT_BUDGETED_STEP) {
+    /* Visit the agents out of order. */
+    for (std::size_t i = 0U; i < simulator->getNumAgents(); ++i) {
+      simulator->setAgentPriority(i, static_cast<float>(i % 7U));
+    }
+  }
+}
+
+void setPreferredVelocities(RVO::RVOSimulator *simulator,
+                            const std::vector<RVO::Vector2> &goals) {
+  for (std::size_t i = 0U; i < simulator->getNumAgents(); ++i) {
+    RVO::Vector2 goalVector = goals[i] - simulator->getAgentPosition(i);
+
+    if (RVO::absSq(goalVector) > 1.0F) {
+      goalVector = RVO::normalize(goalVector);
+    }
+
+    simulator->setAgentPrefVelocity(i, goalVector);
+  }
+}
+
+void doStep(RVO::RVOSimulator *simulator, bool isParallel) {
+#if _OPENMP
+  omp_set_num_threads(isParallel ? omp_get_num_procs() : 1);
+#else
+  static_cast<void>(isParallel);
+#endif /* _OPENMP */
+  simulator->doStep();
+}
+
+bool isClose(float value1, float value2) {
+  return std::fabs(value1 - value2) <=
+         RVO_TOLERANCE *
+             std::max(1.0F, std::max(std::fabs(value1), std::fabs(value2)));
+}
+
+bool isClose(const RVO::Vector2 &vector1, const RVO::Vector2 &vector2) {
+  return isClose(vector1.x(), vector2.x()) && isClose(vector1.y(), vector2.y());
+}
+
+void reportMismatch(
+    const char *what, std::size_t step, std::size_t agentNo,
+    std::size_t &numMismatches) { /* NOLINT(runtime/references) */
+  if (numMismatches < RVO_MAX_REPORTED_MISMATCHES) {
+    std::cerr << "  step " << step << ", agent " << agentNo << ": " << what
+              << " differ" << std::endl;
+  }
+
+  ++numMismatches;
+}
+
+/* Performs a budgeted step in parallel with a budget that is never exceeded,
+ * which is expected to defer no agents. */
+void doBudgetedStep(
+    RVO::RVOSimulator *simulator, std::size_t step,
+    std::size_t &numMismatches) { /* NOLINT(runtime/references) */
+#if _OPENMP
+  omp_set_num_threads(omp_get_num_procs());
+#endif /* _OPENMP */
+
+  if (simulator->doBudgetedStep(60.0F) != 0U ||
+      simulator->getNumDeferredAgents() != 0U) {
+    reportMismatch("deferred agents", step, 0U, numMismatches);
+  }
+}
+
+/* Compares the agent neighbors of the reference simulator with a brute-force
+ * search at the positions before the step. Neighbors are compared by distance,
+ * which is robust to ties. */
+void checkAgentNeighbors(
+    const RVO::RVOSimulator *simulator,
+    const std::vector<RVO::Vector2> &positions, std::size_t step,
+    std::size_t &numMismatches) { /* NOLINT(runtime/references) */
+  for (std::size_t i = 0U; i < simulator->getNumAgents(); ++i) {
+    const float neighborDist = simulator->getAgentNeighborDist(i);
+    std::vector<float> distSqs;
+
+    for (std::size_t j = 0U; j < simulator->getNumAgents(); ++j) {
+      const float distSq = RVO::absSq(positions[j] - positions[i]);
+
+      if (j != i &&
+          simulator->getAgentLayer(j) == simulator->getAgentLayer(i) &&
+          (simulator->getAgentCollisionGroups(j) &
+           simulator->getAgentCollisionMask(i)) != 0U &&
+          distSq < neighborDist * neighborDist) {
+        distSqs.push_back(distSq);
+      }
+    }
+
+    std::sort(distSqs.begin(), distSqs.end());
+    distSqs.resize(
+        std::min(distSqs.size(), simulator->getAgentMaxNeighbors(i)));
+
+    bool isEqual = distSqs.size() == simulator->getAgentNumAgentNeighbors(i);
+
+    for (std::size_t k = 0U; isEqual && k < distSqs.size(); ++k) {
+      const std::size_t neighborNo = simulator->getAgentAgentNeighbor(i, k);
+      isEqual = isClose(distSqs[k],
+                        RVO::absSq(positions[neighborNo] - positions[i]));
+    }
+
+    if (!isEqual) {
+      reportMismatch("brute-force agent neighbors", step, i, numMismatches);
+    }
+  }
+}
+
+/* Compares the agents found by the range and nearest-agent queries of the
+ * simulator after the step with a brute-force search around points near every
+ * tenth agent. Agents are compared by distance, which is robust to ties. */
+void checkSpatialQueries(
+    const RVO::RVOSimulator *simulator, std::size_t step,
+    std::size_t &numMismatches) { /* NOLINT(runtime/references) */
+  const float range = 5.0F;
+  const std::size_t numAgents = 10U;
+  std::vector<RVO::Vector2> points;
+
+  for (std::size_t i = 0U; i < simulator->getNumAgents(); i += 10U) {
+    points.push_back(simulator->getAgentPosition(i) + RVO::Vector2(0.5F, 0.5F));
+  }
+
+  /* Batched queries on layers zero and one. */
+  std::vector<std::vector<std::vector<std::size_t> > > rangeAgentNos(2U);
+  std::vector<std::vector<std::vector<std::size_t> > > nearestAgentNos(2U);
+  simulator->queryAgentsInRange(points, range, rangeAgentNos[0U]);
+  simulator->queryAgentsInRange(points, range, 1U, rangeAgentNos[1U]);
+  simulator->queryNearestAgents(points, numAgents, nearestAgentNos[0U]);
+  simulator->queryNearestAgents(points, numAgents, 1U, nearestAgentNos[1U]);
+
+  for (std::size_t i = 0U; i < points.size(); ++i) {
+    for (std::size_t layer = 0U; layer < 2U; ++layer) {
+      std::vector<float> distSqs;
+
+      for (std::size_t j = 0U; j < simulator->getNumAgents(); ++j) {
+        if (simulator->getAgentLayer(j) == layer) {
+          distSqs.push_back(
+              RVO::absSq(simulator->getAgentPosition(j) - points[i]));
+        }
+      }
+
+      std::sort(distSqs.begin(), distSqs.end());
+
+      std::vector<std::size_t> agentNos;
+      simulator->queryNearestAgents(points[i], numAgents, layer, agentNos);
+
+      if (agentNos != nearestAgentNos[layer][i]) {
+        reportMismatch("nearest agents", step, i, numMismatches);
+      }
+
+      bool isEqual = agentNos.size() == std::min(distSqs.size(), numAgents);
+
+      for (std::size_t k = 0U; isEqual && k < agentNos.size(); ++k) {
+        isEqual = isClose(
+            distSqs[k],
+            RVO::absSq(simulator->getAgentPosition(agentNos[k]) - points[i]));
+      }
+
+      if (!isEqual) {
+        reportMismatch("brute-force nearest agents", step, i, numMismatches);
+      }
+
+      distSqs.erase(
+          std::lower_bound(distSqs.begin(), distSqs.end(), range * range),
+          distSqs.end());
+      isEqual = rangeAgentNos[layer][i].size() == distSqs.size();
+
+      for (std::size_t k = 0U; isEqual && k < distSqs.size(); ++k) {
+        isEqual = isClose(distSqs[k],
+                          RVO::absSq(simulator->getAgentPosition(
+                                         rangeAgentNos[layer][i][k]) -
+                                     points[i]));
+      }
+
+      if (!isEqual) {
+        reportMismatch("brute-force agents in range", step, i, numMismatches);
+      }
+    }
+  }
+}
+
+/* Compares the batched nearest-obstacle and raycast queries of the simulator
+ * with a brute-force search over the obstacle edges on layer zero, at points
+ * near every tenth agent with rays of finite and infinite maximum distance.
+ * Edges are compared by distance, which is robust to ties. */
+void checkObstacleQueries(
+    const RVO::RVOSimulator *simulator, std::size_t step,
+    std::size_t &numMismatches) { /* NOLINT(runtime/references) */
+  std::vector<RVO::Vector2> points;
+  std::vector<RVO::Vector2> directions;
+
+  for (std::size_t i = 0U; i < simulator->getNumAgents(); i += 10U) {
+    const float angle = static_cast<float>(i + step);
+    points.push_back(simulator->getAgentPosition(i) + RVO::Vector2(0.5F, 0.5F));
+    directions.push_back(RVO::Vector2(std::cos(angle), std::sin(angle)));
+  }
+
+  std::vector<float> distances;
+  std::vector<std::size_t> obstacleNos;
+  simulator->queryNearestObstacle(points, distances, obstacleNos);
+
+  for (std::size_t i = 0U; i < points.size(); ++i) {
+    float distSq = std::numeric_limits<float>::infinity();
+
+    for (std::size_t j = 0U; j < simulator->getNumObstacleVertices(); ++j) {
+      if (simulator->getObstacleLayer(j) == 0U) {
+        distSq = std::min(
+            distSq, RVO::distSqPointLineSegment(
+                        simulator->getObstacleVertex(j),
+                        simulator->getObstacleVertex(
+                            simulator->getNextObstacleVertexNo(j)),
+                        points[i]));
+      }
+    }
+
+    if (obstacleNos[i] == RVO::RVO_ERROR ||
+        !isClose(distances[i], std::sqrt(distSq))) {
+      reportMismatch("brute-force nearest obstacle", step, i, numMismatches);
+    }
+  }
+
+  const float maxDists[] = {10.0F, std::numeric_limits<float>::infinity()};
+
+  for (std::size_t k = 0U; k < 2U; ++k) {
+    simulator->queryRaycast(points, directions, maxDists[k], distances,
+                            obstacleNos);
+
+    for (std::size_t i = 0U; i < points.size(); ++i) {
+      float distance = maxDists[k];
+
+      for (std::size_t j = 0U; j < simulator->getNumObstacleVertices(); ++j) {
+        if (simulator->getObstacleLayer(j) != 0U) {
+          continue;
+        }
+
+        const RVO::Vector2 &point1 = simulator->getObstacleVertex(j);
+        const RVO::Vector2 &point2 = simulator->getObstacleVertex(
+            simulator->getNextObstacleVertexNo(j));
+        const RVO::Vector2 obstacleVector = point2 - point1;
+        const float denominator = RVO::det(directions[i], obstacleVector);
+
+        if (denominator != 0.0F) {
+          /* Distances along the ray and along the edge to the intersection. */
+          const float t = RVO::det(point1 - points[i], obstacleVector) /
+                          denominator;
+          const float s = RVO::det(point1 - points[i], directions[i]) /
+                          denominator;
+
+          if (t >= 0.0F && t < distance && s >= 0.0F && s <= 1.0F) {
+            distance = t;
+          }
+        }
+      }
+
+      if ((obstacleNos[i] == RVO::RVO_ERROR) != (distance == maxDists[k]) ||
+          !(distances[i] == distance || isClose(distances[i], distance))) {
+        reportMismatch(k == 0U ? "brute-force raycast"
+                               : "brute-force unbounded raycast",
+                       step, i, numMismatches);
+      }
+    }
+  }
+}
+
+void compareAgentLists(
+    const RVO::RVOSimulator *reference, const RVO::RVOSimulator *candidate,
+    std::size_t agentNo, std::size_t step,
+    std::size_t &numMismatches) { /* NOLINT(runtime/references) */
+  /* Agent neighbors. */
+  bool isEqual = reference->getAgentNumAgentNeighbors(agentNo) ==
+                 candidate->getAgentNumAgentNeighbors(agentNo);
+
+  for (std::size_t k = 0U;
+       isEqual && k < reference->getAgentNumAgentNeighbors(agentNo); ++k) {
+    isEqual = reference->getAgentAgentNeighbor(agentNo, k) ==
+              candidate->getAgentAgentNeighbor(agentNo, k);
+  }
+
+  if (!isEqual) {
+    reportMismatch("agent neighbors", step, agentNo, numMismatches);
+  }
+
+  /* Obstacle neighbors, as sets. */
+  std::vector<std::size_t> referenceObstacles;
+  std::vector<std::size_t> candidateObstacles;
+
+  for (std::size_t k = 0U;
+       k < reference->getAgentNumObstacleNeighbors(agentNo); ++k) {
+    referenceObstacles.push_back(
+        reference->getAgentObstacleNeighbor(agentNo, k));
+  }
+
+  for (std::size_t k = 0U;
+       k < candidate->getAgentNumObstacleNeighbors(agentNo); ++k) {
+    candidateObstacles.push_back(
+        candidate->getAgentObstacleNeighbor(agentNo, k));
+  }
+
+  std::sort(referenceObstacles.begin(), referenceObstacles.end());
+  std::sort(candidateObstacles.begin(), candidateObstacles.end());
+
+  if (referenceObstacles != candidateObstacles) {
+    reportMismatch("obstacle neighbors", step, agentNo, numMismatches);
+  }
+
+  /* ORCA lines, of which the candidate simulator may have pruned those whose
+   * half-plane contains the disc of velocities up to the maximum speed. */
+  const std::size_t numCandidateLines =
+      candidate->getAgentNumORCALines(agentNo);
+  const float maxSpeed = reference->getAgentMaxSpeed(agentNo);
+  std::size_t numPrunedLines = 0U;
+  std::size_t k = 0U;
+  isEqual = true;
+
+  for (std::size_t j = 0U;
+       isEqual && j < reference->getAgentNumORCALines(agentNo); ++j) {
+    const RVO::Line &referenceLine = reference->getAgentORCALine(agentNo, j);
+
+    if (k < numCandidateLines &&
+        isClose(referenceLine.point,
+                candidate->getAgentORCALine(agentNo, k).point) &&
+        isClose(referenceLine.direction,
+                candidate->getAgentORCALine(agentNo, k).direction)) {
+      ++k;
+    } else if (candidate->isConstraintPruningEnabled() &&
+               RVO::det(referenceLine.direction, referenceLine.point) +
+                       maxSpeed <=
+                   RVO_TOLERANCE * maxSpeed) {
+      ++numPrunedLines;
+    } else {
+      isEqual = false;
+    }
+  }
+
+  if (!isEqual || k != numCandidateLines ||
+      numPrunedLines != candidate->getAgentNumPrunedORCALines(agentNo)) {
+    reportMismatch("ORCA lines", step, agentNo, numMismatches);
+  }
+}
+
+/* Compares the ORCA lines of simulators whose obstacles are equivalent but of
+ * different kinds, which create the obstacle ORCA lines in different orders.
+ * Every ORCA line must have a match in the other simulator. */
+void compareORCALineSets(
+    const RVO::RVOSimulator *reference, const RVO::RVOSimulator *candidate,
+    std::size_t agentNo, std::size_t step,
+    std::size_t &numMismatches) { /* NOLINT(runtime/references) */
+  const std::size_t numLines = reference->getAgentNumORCALines(agentNo);
+  bool isEqual = numLines == candidate->getAgentNumORCALines(agentNo);
+  std::vector<bool> isMatched(numLines, false);
+
+  for (std::size_t j = 0U; isEqual && j < numLines; ++j) {
+    const RVO::Line &referenceLine = reference->getAgentORCALine(agentNo, j);
+    std::size_t k = 0U;
+
+    while (k < numLines &&
+           (isMatched[k] ||
+            !isClose(referenceLine.point,
+                     candidate->getAgentORCALine(agentNo, k).point) ||
+            !isClose(referenceLine.direction,
+                     candidate->getAgentORCALine(agentNo, k).direction))) {
+      ++k;
+    }
+
+    isEqual = k < numLines;
+
+    if (isEqual) {
+      isMatched[k] = true;
+    }
+  }
+
+  if (!isEqual) {
+    reportMismatch("ORCA lines", step, agentNo, numMismatches);
+  }
+}
+
+void compareSimulators(
+    const RVO::RVOSimulator *reference, const RVO::RVOSimulator *candidate,
+    Scenario scenario, Variant variant, std::size_t step,
+    std::size_t &numMismatches) { /* NOLINT(runtime/references) */
+  for (std::size_t i = 0U; i < reference->getNumAgents(); ++i) {
+    if (variant == RVO_VARIANT_BOX_OBSTACLES) {
+      /* Obstacles overlap in the random scenario, where an obstacle ORCA line
+       * may be skipped as redundant depending on the order of the lines, so
+       * only the velocities and positions are compared. */
+      if (scenario == RVO_SCENARIO_CIRCLE) {
+        compareORCALineSets(reference, candidate, i, step, numMismatches);
+      }
+    } else if (candidate->isAgentIntrospectionEnabled(i)) {
+      compareAgentLists(reference, candidate, i, step, numMismatches);
+    } else if (candidate->getAgentNumAgentNeighbors(i) != 0U ||
+               candidate->getAgentNumObstacleNeighbors(i) != 0U ||
+               candidate->getAgentNumORCALines(i) != 0U) {
+      reportMismatch("discarded lists", step, i, numMismatches);
+    }
+
+    /* Velocities and positions. */
+    if (!isClose(reference->getAgentVelocity(i),
+                 candidate->getAgentVelocity(i))) {
+      reportMismatch("velocities", step, i, numMismatches);
+    }
+
+    if (!isClose(reference->getAgentPosition(i),
+                 candidate->getAgentPosition(i))) {
+      reportMismatch("positions", step, i, numMismatches);
+    }
+  }
+}
+
+void synchronizeSimulators(const RVO::RVOSimulator *reference,
+                           RVO::RVOSimulator *candidate) {
+  for (std::size_t i = 0U; i < reference->getNumAgents(); ++i) {
+    candidate->setAgentPosition(i, reference->getAgentPosition(i));
+    candidate->setAgentVelocity(i, reference->getAgentVelocity(i));
+  }
+}
+
+/* Compares the interpolated positions of all agents at a specified fraction
+ * of the last time step with the expected positions. */
+void checkInterpolatedPositions(
+    const RVO::RVOSimulator *simulator, float alpha,
+    const std::vector<RVO::Vector2> &expectedPositions, const char *what,
+    std::size_t step,
+    std::size_t &numMismatches) { /* NOLINT(runtime/references) */
+  std::vector<RVO::Vector2> positions;
+  simulator->getInterpolatedPositions(alpha, positions);
+
+  for (std::size_t i = 0U; i < expectedPositions.size(); ++i) {
+    if (i >= positions.size() || !isClose(positions[i], expectedPositions[i])) {
+      reportMismatch(what, step, i, numMismatches);
+    }
+  }
+}
+
+/* Checks that the interpolated positions run from the positions before the
+ * last step to the present positions, and that agents moved, added or
+ * resynchronized by enabling interpolation do not slide from stale previous
+ * positions. */
+std::size_t runInterpolationTest() {
+  std::vector<RVO::Vector2> goals;
+
+  RVO::RVOSimulator *simulator = new RVO::RVOSimulator();
+  setupCircleScenario(simulator, goals, false);
+  simulator->setInterpolationEnabled(true);
+
+  std::size_t numMismatches = 0U;
+  std::vector<RVO::Vector2> previousPositions(simulator->getNumAgents());
+  std::vector<RVO::Vector2> presentPositions(simulator->getNumAgents());
+  std::vector<RVO::Vector2> midpoints(simulator->getNumAgents());
+
+  for (std::size_t step = 0U; step < 10U; ++step) {
+    setPreferredVelocities(simulator, goals);
+
+    for (std::size_t i = 0U; i < simulator->getNumAgents(); ++i) {
+      previousPositions[i] = simulator->getAgentPosition(i);
+    }
+
+    doStep(simulator, true);
+
+    for (std::size_t i = 0U; i < simulator->getNumAgents(); ++i) {
+      presentPositions[i] = simulator->getAgentPosition(i);
+      midpoints[i] = 0.5F * (previousPositions[i] + presentPositions[i]);
+    }
+
+    checkInterpolatedPositions(simulator, 0.0F, previousPositions,
+                               "previous positions", step, numMismatches);
+    checkInterpolatedPositions(simulator, 0.5F, midpoints,
+                               "interpolated positions", step, numMismatches);
+    checkInterpolatedPositions(simulator, 1.0F, presentPositions,
+                               "present positions", step, numMismatches);
+  }
+
+  /* Agents that are moved, or added, are at rest between the steps. */
+  simulator->setAgentPosition(0U, presentPositions[0U] +
+                                      RVO::Vector2(3.0F, 0.0F));
+  presentPositions[0U] = simulator->getAgentPosition(0U);
+
+  std::vector<std::size_t> agentNos(1U, 1U);
+  std::vector<RVO::Vector2> positions(1U, presentPositions[1U] +
+                                              RVO::Vector2(0.0F, 3.0F));
+  simulator->setAgentStates(agentNos, positions,
+                            std::vector<RVO::Vector2>(1U));
+  presentPositions[1U] = positions[0U];
+
+  presentPositions.push_back(RVO::Vector2(0.0F, 0.0F));
+  simulator->addAgent(presentPositions.back());
+
+  const std::vector<RVO::Vector2> movedPositions(presentPositions.begin(),
+                                                 presentPositions.begin() + 2);
+  checkInterpolatedPositions(simulator, 0.0F, movedPositions, "moved agents",
+                             10U, numMismatches);
+
+  std::vector<RVO::Vector2> addedPositions;
+  simulator->getInterpolatedPositions(0.0F, addedPositions);
+
+  if (addedPositions.size() != presentPositions.size() ||
+      !isClose(addedPositions.back(), presentPositions.back())) {
+    reportMismatch("added agent", 10U, presentPositions.size() - 1U,
+                   numMismatches);
+  }
+
+  /* Present positions are returned while interpolation is disabled, and
+   * enabling it resets the previous positions. */
+  goals.push_back(presentPositions.back());
+  setPreferredVelocities(simulator, goals);
+  simulator->setInterpolationEnabled(false);
+  doStep(simulator, true);
+
+  for (std::size_t i = 0U; i < simulator->getNumAgents(); ++i) {
+    presentPositions[i] = simulator->getAgentPosition(i);
+  }
+
+  checkInterpolatedPositions(simulator, 0.0F, presentPositions,
+                             "positions without interpolation", 11U,
+                             numMismatches);
+  simulator->setInterpolationEnabled(true);
+  checkInterpolatedPositions(simulator, 0.0F, presentPositions,
+                             "positions once interpolation is enabled", 11U,
+                             numMismatches);
+
+  std::cout << (numMismatches == 0U ? "PASS" : "FAIL")
+            << " circle, interpolation: " << numMismatches << " mismatches"
+            << std::endl;
+
+  delete simulator;
+
+  return numMismatches;
+}
+
+std::size_t runDifferentialTest(Scenario scenario, unsigned int seed,
+                                Variant variant) {
+  std::vector<RVO::Vector2> goals;
+  std::vector<RVO::Vector2> candidateGoals;
+
+  RVO::RVOSimulator *reference = new RVO::RVOSimulator();
+  RVO::RVOSimulator *candidate = new RVO::RVOSimulator();
+  /* The box obstacles of the reference simulator are polygonal obstacles in
+   * the box obstacle variant. */
+  setupScenario(reference, goals, scenario, seed,
+                variant == RVO_VARIANT_BOX_OBSTACLES);
+  setupScenario(candidate, candidateGoals, scenario, seed, false);
+  setupVariant(candidate, variant);
+
+  /* Run the parallel variants on all threads unless the variant lets the
+   * simulator choose. */
+  candidate->setAutomaticParallelismEnabled(
+      variant == RVO_VARIANT_AUTOMATIC_PARALLELISM);
+
+  if (variant == RVO_VARIANT_PERTURBATION) {
+    /* Perturb alike in the reference simulator, which runs in serial. */
+    setupVariant(reference, variant);
+  }
+
+  std::size_t numMismatches = 0U;
+  std::vector<RVO::Vector2> positions(reference->getNumAgents());
+
+  for (std::size_t step = 0U; step < RVO_NUM_STEPS; ++step) {
+    setPreferredVelocities(reference, goals);
+    setPreferredVelocities(candidate, goals);
+
+    for (std::size_t i = 0U; i < reference->getNumAgents(); ++i) {
+      positions[i] = reference->getAgentPosition(i);
+    }
+
+    doStep(reference, false);
+
+    if (variant == RVO_VARIANT_BUDGETED_STEP) {
+      doBudgetedStep(candidate, step, numMismatches);
+    } else {
+      doStep(candidate, variant == RVO_VARIANT_PARALLEL ||
+                            variant == RVO_VARIANT_SCRATCH_BUFFERS ||
+                            variant == RVO_VARIANT_PERTURBATION ||
+                            variant == RVO_VARIANT_AUTOMATIC_PARALLELISM);
+    }
+
+    checkAgentNeighbors(reference, positions, step, numMismatches);
+    checkSpatialQueries(reference, step, numMismatches);
+    checkObstacleQueries(reference, step, numMismatches);
+    compareSimulators(reference, candidate, scenario, variant, step,
+                      numMismatches);
+    synchronizeSimulators(reference, candidate);
+  }
+
+  std::cout << (numMismatches == 0U ? "PASS" : "FAIL") << " "
+            << (scenario == RVO_SCENARIO_CIRCLE ? "circle" : "random");
+
+  if (scenario == RVO_SCENARIO_RANDOM) {
+    std::cout << " (seed " << seed << ")";
+  }
+
+  std::cout << ", " << RVO_VARIANT_NAMES[variant] << ": " << numMismatches
+            << " mismatches" << std::endl;
+
+  delete candidate;
+  delete reference;
+
+  return numMismatches;
+}
+} /* namespace */
+
+int main() {
+  std::size_t numMismatches = 0U;
+
+  for (int variant = RVO_VARIANT_DISTANCE_FIELD;
+       variant <= RVO_VARIANT_BOX_OBSTACLES; ++variant) {
+    numMismatches += runDifferentialTest(RVO_SCENARIO_CIRCLE, 0U,
+                                         static_cast<Variant>(variant));
+
+    for (unsigned int seed = 1U; seed <= 3U; ++seed) {
+      numMismatches += runDifferentialTest(RVO_SCENARIO_RANDOM, seed,
+                                           static_cast<Variant>(variant));
+    }
+  }
+
+  numMismatches += runInterpolationTest();
+
+  return numMismatches == 0U ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -131,6 +131,7 @@ public:
             if (avatarData.find(key) != avatarData.end() && 
                 !avatarData[key].positions.empty()) {
                 size_t agentId = sim->addAgent(avatarData[key].positions[0]);
+                sim->setAgentKinematic(agentId, true); // Replays its trajectory
                 std::cout << "Added avatar agent " << key << " with ID: " << agentId << std::endl;
             }
         }
@@ -139,6 +140,7 @@ public:
         RVO::Vector2 goalPos(MIN_X, std::sqrt(9*9 + 11*11) + MIN_Y);
         size_t goalId = sim->addAgent(goalPos);
         sim->setAgentMaxSpeed(goalId, 0.0f); // Static goal
+        sim->setAgentKinematic(goalId, true);
         std::cout << "Added goal agent with ID: " << goalId << std::endl;
     }
     
@@ -151,18 +153,22 @@ public:
             sim->setAgentPrefVelocity(0, preferredVel);
         }
         
-        // Update avatar agents (IDs 1-10)
+        // Replay avatar agents (IDs 1-10), which are kinematic, in bulk
+        std::vector<size_t> avatarIds;
+        std::vector<RVO::Vector2> avatarPositions;
+        std::vector<RVO::Vector2> avatarVelocities;
         for (int avatar = 1; avatar <= 10; ++avatar) {
             std::string key = "A" + std::to_string(avatar) + "P";
             if (avatarData.find(key) != avatarData.end() && 
                 currentStep < avatarData[key].positions.size()) {
-                RVO::Vector2 preferredVel = calculatePreferredVelocity(avatar, avatarData[key]);
-                sim->setAgentPrefVelocity(avatar, preferredVel);
+                avatarIds.push_back(avatar);
+                avatarPositions.push_back(avatarData[key].positions[currentStep]);
+                avatarVelocities.push_back(calculatePreferredVelocity(avatar, avatarData[key]));
             }
         }
+        sim->setAgentStates(avatarIds, avatarPositions, avatarVelocities);
         
-        // Goal agent remains static (ID 11)
-        sim->setAgentPrefVelocity(11, RVO::Vector2(0.0f, 0.0f));
+        // Goal agent (ID 11) is kinematic with zero velocity and remains static
     }
     
     RVO::Vector2 calculatePreferredVelocity(int agentId, const AgentTrajectory& trajectory) {
@@ -0,0 +1,306 @@
+/*
+ * LoadObstacles.cc
+ * RVO2 Library
+ *
+ * SPDX-FileCopyrightText: 2008 University of North Carolina at Chapel Hill
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Please send all bug reports to <geom@cs.unc.edu>.
+ *
+ * The authors may be contacted via:
+ *
+ * Jur van den Berg, Stephen J. Guy, Jamie Snape, Ming C. Lin, Dinesh Manocha
+ * Dept. of Computer Science
+ * 201 S. Columbia St.
+ * Frederick P. Brooks, Jr. Computer Science Bldg.
+ * Chapel Hill, N.C. 27599-3175
+ * United States of America
+ *
+ * <https://gamma.cs.unc.edu/RVO2/>
+ */
+
+
+/*
+ * @file  LoadObstacles.cc
+ * @brief Example file testing loadObstacles on small well-known binary (WKB)
+ *        polygon files in both byte orders, including a polygon with a hole, a
+ *        MultiPolygon and malformed files, which must be rejected with
+ *        RVO::RVO_ERROR without adding obstacles.
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "RVO.h"
+
+namespace {
+/* The WKB types of the geometries written. */
+const unsigned int RVO_WKB_POINT = 1U;
+const unsigned int RVO_WKB_POLYGON = 3U;
+const unsigned int RVO_WKB_MULTI_POLYGON = 6U;
+
+typedef std::vector<RVO::Vector2> Ring;
+
+bool isHostLittleEndian() {
+  const unsigned int one = 1U;
+  unsigned char byte = 0U;
+  std::memcpy(&byte, &one, 1U);
+
+  return byte == 1U;
+}
+
+void appendUInt32(
+    std::vector<unsigned char> &bytes, /* NOLINT(runtime/references) */
+    unsigned int value, bool isLittleEndian) {
+  for (std::size_t i = 0U; i < 4U; ++i) {
+    const std::size_t shift = isLittleEndian ? 8U * i : 8U * (3U - i);
+    bytes.push_back(static_cast<unsigned char>((value >> shift) & 0xFFU));
+  }
+}
+
+void appendDouble(
+    std::vector<unsigned char> &bytes, /* NOLINT(runtime/references) */
+    double value, bool isLittleEndian) {
+  unsigned char valueBytes[sizeof(double)];
+  std::memcpy(valueBytes, &value, sizeof(double));
+
+  if (isLittleEndian != isHostLittleEndian()) {
+    std::reverse(valueBytes, valueBytes + sizeof(double));
+  }
+
+  bytes.insert(bytes.end(), valueBytes, valueBytes + sizeof(double));
+}
+
+void appendHeader(
+    std::vector<unsigned char> &bytes, /* NOLINT(runtime/references) */
+    unsigned int type, bool isLittleEndian) {
+  bytes.push_back(isLittleEndian ? 1U : 0U);
+  appendUInt32(bytes, type, isLittleEndian);
+}
+
+/* Appends a polygon whose rings are closed by repeating their first vertex. */
+void appendPolygon(
+    std::vector<unsigned char> &bytes, /* NOLINT(runtime/references) */
+    const std::vector<Ring> &rings, bool isLittleEndian) {
+  appendHeader(bytes, RVO_WKB_POLYGON, isLittleEndian);
+  appendUInt32(bytes, static_cast<unsigned int>(rings.size()), isLittleEndian);
+
+  for (std::size_t i = 0U; i < rings.size(); ++i) {
+    appendUInt32(bytes, static_cast<unsigned int>(rings[i].size() + 1U),
+                 isLittleEndian);
+
+    for (std::size_t j = 0U; j <= rings[i].size(); ++j) {
+      const RVO::Vector2 &vertex = rings[i][j % rings[i].size()];
+      appendDouble(bytes, vertex.x(), isLittleEndian);
+      appendDouble(bytes, vertex.y(), isLittleEndian);
+    }
+  }
+}
+
+/* Returns an axis-aligned square, clockwise if specified. */
+Ring makeSquare(float minCoord, float maxCoord, bool isClockwise) {
+  Ring square;
+  square.push_back(RVO::Vector2(minCoord, minCoord));
+  square.push_back(RVO::Vector2(maxCoord, minCoord));
+  square.push_back(RVO::Vector2(maxCoord, maxCoord));
+  square.push_back(RVO::Vector2(minCoord, maxCoord));
+
+  if (isClockwise) {
+    std::reverse(square.begin(), square.end());
+  }
+
+  return square;
+}
+
+std::string getFilename() {
+  /* Bazel provides a writable directory for test outputs. */
+  const char *const directory = std::getenv("TEST_TMPDIR");
+
+  return std::string(directory != NULL ? directory : ".") +
+         "/LoadObstacles.wkb";
+}
+
+void writeFile(const std::string &filename,
+               const std::vector<unsigned char> &bytes) {
+  std::ofstream file(filename.c_str(), std::ios::binary | std::ios::trunc);
+
+  if (!bytes.empty()) {
+    file.write(reinterpret_cast<const char *>(&bytes[0]),
+               static_cast<std::streamsize>(bytes.size()));
+  }
+}
+
+void reportFailure(const char *name, const char *what,
+                   std::size_t &numFailures) { /* NOLINT(runtime/references) */
+  std::cerr << name << ": " << what << std::endl;
+  ++numFailures;
+}
+
+/* Loads a file and checks the count of obstacles added, the count of vertices
+ * of each ring and the winding of each ring, which is counterclockwise for
+ * exterior rings and clockwise for interior rings. */
+std::size_t checkLoad(const char *name, const std::vector<unsigned char> &bytes,
+                      const std::vector<std::size_t> &numRingVertices,
+                      const std::vector<bool> &isExterior) {
+  const std::string filename = getFilename();
+  writeFile(filename, bytes);
+
+  RVO::RVOSimulator simulator;
+  const std::size_t numRings = simulator.loadObstacles(filename.c_str(), false);
+  std::remove(filename.c_str());
+
+  std::size_t numFailures = 0U;
+
+  if (numRings != numRingVertices.size()) {
+    reportFailure(name, "ring count differs", numFailures);
+
+    return numFailures;
+  }
+
+  std::size_t begin = 0U;
+
+  for (std::size_t i = 0U; i < numRings; ++i) {
+    std::size_t numVertices = 0U;
+    float signedArea = 0.0F;
+    std::size_t vertexNo = begin;
+
+    do {
+      const std::size_t nextVertexNo =
+          simulator.getNextObstacleVertexNo(vertexNo);
+      signedArea += RVO::det(simulator.getObstacleVertex(vertexNo),
+                             simulator.getObstacleVertex(nextVertexNo));
+      vertexNo = nextVertexNo;
+      ++numVertices;
+    } while (vertexNo != begin && numVertices <= numRingVertices[i]);
+
+    if (numVertices != numRingVertices[i]) {
+      reportFailure(name, "vertex count differs", numFailures);
+    }
+
+    if (isExterior[i] ? signedArea <= 0.0F : signedArea >= 0.0F) {
+      reportFailure(name, "winding differs", numFailures);
+    }
+
+    begin += numVertices;
+  }
+
+  if (begin != simulator.getNumObstacleVertices()) {
+    reportFailure(name, "total vertex count differs", numFailures);
+  }
+
+  return numFailures;
+}
+
+/* Loads a file that must be rejected without adding obstacles. */
+std::size_t checkError(const char *name,
+                       const std::vector<unsigned char> &bytes) {
+  const std::string filename = getFilename();
+  writeFile(filename, bytes);
+
+  RVO::RVOSimulator simulator;
+  const std::size_t numRings = simulator.loadObstacles(filename.c_str(), false);
+  std::remove(filename.c_str());
+
+  std::size_t numFailures = 0U;
+
+  if (numRings != RVO::RVO_ERROR) {
+    reportFailure(name, "file accepted", numFailures);
+  }
+
+  if (simulator.getNumObstacleVertices() != 0U) {
+    reportFailure(name, "obstacles added", numFailures);
+  }
+
+  return numFailures;
+}
+} /* namespace */
+
+int main() {
+  std::size_t numFailures = 0U;
+
+  /* Squares given clockwise in either byte order become counterclockwise
+   * obstacles of four vertices once the closing vertex is dropped. */
+  for (int i = 0; i < 2; ++i) {
+    const bool isLittleEndian = i == 0;
+    std::vector<unsigned char> bytes;
+    appendPolygon(bytes, std::vector<Ring>(1U, makeSquare(0.0F, 4.0F, true)),
+                  isLittleEndian);
+    numFailures += checkLoad(
+        isLittleEndian ? "little-endian polygon" : "big-endian polygon", bytes,
+        std::vector<std::size_t>(1U, 4U), std::vector<bool>(1U, true));
+  }
+
+  /* A counterclockwise hole becomes a clockwise obstacle. */
+  std::vector<Ring> rings;
+  rings.push_back(makeSquare(0.0F, 10.0F, false));
+  rings.push_back(makeSquare(4.0F, 6.0F, false));
+  std::vector<unsigned char> polygonWithHole;
+  appendPolygon(polygonWithHole, rings, true);
+  std::vector<bool> isExterior;
+  isExterior.push_back(true);
+  isExterior.push_back(false);
+  numFailures += checkLoad("polygon with hole", polygonWithHole,
+                           std::vector<std::size_t>(2U, 4U), isExterior);
+
+  /* The polygons of a MultiPolygon may use different byte orders. */
+  std::vector<unsigned char> multiPolygon;
+  appendHeader(multiPolygon, RVO_WKB_MULTI_POLYGON, false);
+  appendUInt32(multiPolygon, 2U, false);
+  appendPolygon(multiPolygon, rings, true);
+  appendPolygon(multiPolygon,
+                std::vector<Ring>(1U, makeSquare(20.0F, 22.0F, true)), false);
+  isExterior.push_back(true);
+  numFailures += checkLoad("multipolygon", multiPolygon,
+                           std::vector<std::size_t>(3U, 4U), isExterior);
+
+  /* A polygon followed by a truncated polygon is rejected as a whole. */
+  std::vector<unsigned char> truncated = polygonWithHole;
+  truncated.insert(truncated.end(), polygonWithHole.begin(),
+                   polygonWithHole.end() - 8);
+  numFailures += checkError("truncated file", truncated);
+
+  std::vector<unsigned char> point;
+  appendHeader(point, RVO_WKB_POINT, true);
+  appendDouble(point, 0.0, true);
+  appendDouble(point, 0.0, true);
+  numFailures += checkError("unsupported type", point);
+
+  std::vector<unsigned char> hugeRing;
+  appendHeader(hugeRing, RVO_WKB_POLYGON, true);
+  appendUInt32(hugeRing, 1U, true);
+  appendUInt32(hugeRing, 0xFFFFFFFFU, true);
+  numFailures += checkError("huge vertex count", hugeRing);
+
+  std::vector<unsigned char> badByteOrder(polygonWithHole);
+  badByteOrder[0] = 2U;
+  numFailures += checkError("invalid byte order", badByteOrder);
+
+  RVO::RVOSimulator simulator;
+
+  if (simulator.loadObstacles("LoadObstacles.missing.wkb", false) !=
+      RVO::RVO_ERROR) {
+    std::cerr << "missing file: file accepted" << std::endl;
+    ++numFailures;
+  }
+
+  return numFailures == 0U ? EXIT_SUCCESS : EXIT_FAILURE;
+}
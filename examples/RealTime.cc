@@ -0,0 +1,159 @@
+/*
+ * RealTime.cc
+ * RVO2 Library
+ *
+ * SPDX-FileCopyrightText: 2008 University of North Carolina at Chapel Hill
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Please send all bug reports to <geom@cs.unc.edu>.
+ *
+ * The authors may be contacted via:
+ *
+ * Jur van den Berg, Stephen J. Guy, Jamie Snape, Ming C. Lin, Dinesh Manocha
+ * Dept. of Computer Science
+ * 201 S. Columbia St.
+ * Frederick P. Brooks, Jr. Computer Science Bldg.
+ * Chapel Hill, N.C. 27599-3175
+ * United States of America
+ *
+ * <https://gamma.cs.unc.edu/RVO2/>
+ */
+
+/*
+ * @file  RealTime.cc
+ * @brief Example file showing a demo with 100 agents initially positioned
+ *        evenly distributed on a circle attempting to move to the antipodal
+ *        position on the circle, stepped at the pace of the wall clock with
+ *        the latencies of each tick reported at the end.
+ */
+
+#ifndef RVO_OUTPUT_TIME_AND_POSITIONS
+#define RVO_OUTPUT_TIME_AND_POSITIONS 1
+#endif /* RVO_OUTPUT_TIME_AND_POSITIONS */
+
+#include <cmath>
+#include <cstddef>
+#include <iostream>
+#include <vector>
+
+#include "RVO.h"
+
+namespace {
+const float RVO_TWO_PI = 6.28318530717958647692F;
+
+void setupScenario(
+    RVO::RVOSimulator *simulator,
+    std::vector<RVO::Vector2> &goals) { /* NOLINT(runtime/references) */
+  /* Specify the global time step of the simulation, i.e., 50 ticks per
+   * second. */
+  simulator->setTimeStep(0.02F);
+
+  /* Specify the default parameters for agents that are subsequently added. */
+  simulator->setAgentDefaults(15.0F, 10U, 10.0F, 10.0F, 1.5F, 2.0F);
+
+  /* Add agents, specifying their start position, and store their goals on the
+   * opposite side of the environment. */
+  for (std::size_t i = 0U; i < 100U; ++i) {
+    simulator->addAgent(
+        80.0F *
+        RVO::Vector2(std::cos(static_cast<float>(i) * RVO_TWO_PI * 0.01F),
+                     std::sin(static_cast<float>(i) * RVO_TWO_PI * 0.01F)));
+    goals.push_back(-simulator->getAgentPosition(i));
+  }
+}
+
+RVO::Vector2 computePreferredVelocity(const RVO::RVOSimulator *simulator,
+                                      std::size_t agentNo, void *context) {
+  /* The preferred velocity is a vector of unit magnitude (speed) in the
+   * direction of the goal. */
+  const std::vector<RVO::Vector2> &goals =
+      *static_cast<const std::vector<RVO::Vector2> *>(context);
+  RVO::Vector2 goalVector =
+      goals[agentNo] - simulator->getAgentPosition(agentNo);
+
+  if (RVO::absSq(goalVector) > 1.0F) {
+    goalVector = RVO::normalize(goalVector);
+  }
+
+  return goalVector;
+}
+
+bool updateVisualization(RVO::RVOSimulator *simulator, void *context) {
+  static_cast<void>(context);
+
+#if RVO_OUTPUT_TIME_AND_POSITIONS
+  /* Output the current global time. */
+  std::cout << simulator->getGlobalTime();
+
+  /* Output the current position of all the agents. */
+  for (std::size_t i = 0U; i < simulator->getNumAgents(); ++i) {
+    std::cout << " " << simulator->getAgentPosition(i);
+  }
+
+  std::cout << std::endl;
+#else
+  static_cast<void>(simulator);
+#endif /* RVO_OUTPUT_TIME_AND_POSITIONS */
+
+  /* Continue with the next tick. */
+  return true;
+}
+
+void reportLatencies(const RVO::RealTimeRunner &runner) {
+  const char *const names[] = {"lateness", "build",    "velocity", "update",
+                               "step",     "callback", "tick"};
+
+  /* Output the median, 99th percentile, and maximum of each phase in
+   * milliseconds. */
+  std::cout << "phase p50 p99 max (ms)" << std::endl;
+
+  for (int i = RVO::RVO_PHASE_LATENESS; i <= RVO::RVO_PHASE_TICK; ++i) {
+    const RVO::RealTimePhase phase = static_cast<RVO::RealTimePhase>(i);
+    std::cout << names[i] << " " << 1000.0F * runner.getLatency(phase, 0.5F)
+              << " " << 1000.0F * runner.getLatency(phase, 0.99F) << " "
+              << 1000.0F * runner.getLatency(phase, 1.0F) << std::endl;
+  }
+
+  std::cout << "overruns " << runner.getNumOverruns() << ", skipped ticks "
+            << runner.getNumSkippedTicks() << std::endl;
+}
+} /* namespace */
+
+int main() {
+  /* Store the goals of the agents. */
+  std::vector<RVO::Vector2> goals;
+
+  /* Create a new simulator instance. */
+  RVO::RVOSimulator *simulator = new RVO::RVOSimulator();
+
+  /* Set up the scenario. */
+  setupScenario(simulator, goals);
+
+  /* Compute the preferred velocities within each simulation step, in parallel
+   * for all agents. */
+  simulator->setPrefVelocityCallback(&computePreferredVelocity, &goals);
+
+  /* Perform two seconds of the simulation in real time, catching up with at
+   * most two simulation steps back to back after an overrun. */
+  RVO::RealTimeRunner runner(simulator);
+  runner.setCatchUpPolicy(RVO::RVO_CATCH_UP_BURST, 2U);
+  runner.run(100U, &updateVisualization, NULL);
+
+  reportLatencies(runner);
+
+  delete simulator;
+
+  return 0;
+}
@@ -48,8 +48,6 @@
 #define RVO_SEED_RANDOM_NUMBER_GENERATOR 1
 #endif /* RVO_SEED_RANDOM_NUMBER_GENERATOR */
 
-#include <cmath>
-#include <cstdlib>
 #include <limits>
 #include <map>
 #include <utility>
@@ -71,8 +69,6 @@
 #endif /* _OPENMP */
 
 namespace {
-const float RVO_TWO_PI = 6.28318530717958647692F;
-
 class RoadmapVertex {
  public:
   RVO::Vector2 position;
@@ -84,8 +80,13 @@ void setupScenario(
     RVO::RVOSimulator *simulator,
     std::vector<RoadmapVertex> &roadmap, /* NOLINT(runtime/references) */
     std::vector<int> &goals) {           /* NOLINT(runtime/references) */
+  /* Perturb the preferred velocities a little in each step to avoid deadlocks
+   * due to perfect symmetry. */
 #if RVO_SEED_RANDOM_NUMBER_GENERATOR
-  std::srand(static_cast<unsigned int>(std::time(NULL)));
+  simulator->setPerturbation(0.0001F,
+                             static_cast<unsigned int>(std::time(NULL)));
+#else
+  simulator->setPerturbation(0.0001F, 0U);
 #endif /* RVO_SEED_RANDOM_NUMBER_GENERATOR */
 
   /* Specify the global time step of the simulation. */
@@ -316,16 +317,6 @@ void setPreferredVelocities(RVO::RVOSimulator *simulator,
                               simulator->getAgentPosition(i)));
       }
     }
-
-    /* Perturb a little to avoid deadlocks due to perfect symmetry. */
-    float angle = static_cast<float>(std::rand()) * RVO_TWO_PI /
-                  static_cast<float>(RAND_MAX);
-    float dist = static_cast<float>(std::rand()) * 0.0001F /
-                 static_cast<float>(RAND_MAX);
-
-    simulator->setAgentPrefVelocity(
-        i, simulator->getAgentPrefVelocity(i) +
-               dist * RVO::Vector2(std::cos(angle), std::sin(angle)));
   }
 }
 
@@ -0,0 +1,168 @@
+/*
+ * SimplifyObstacles.cc
+ * RVO2 Library
+ *
+ * SPDX-FileCopyrightText: 2008 University of North Carolina at Chapel Hill
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Please send all bug reports to <geom@cs.unc.edu>.
+ *
+ * The authors may be contacted via:
+ *
+ * Jur van den Berg, Stephen J. Guy, Jamie Snape, Ming C. Lin, Dinesh Manocha
+ * Dept. of Computer Science
+ * 201 S. Columbia St.
+ * Frederick P. Brooks, Jr. Computer Science Bldg.
+ * Chapel Hill, N.C. 27599-3175
+ * United States of America
+ *
+ * <https://gamma.cs.unc.edu/RVO2/>
+ */
+
+
+/*
+ * @file  SimplifyObstacles.cc
+ * @brief Example file testing simplifyObstacles on small obstacles with
+ *        collinear vertices, near-duplicate vertices, thin and tiny triangles,
+ *        a line segment and a nested square, checking the count of vertices
+ *        removed and the count of vertices left.
+ */
+
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "RVO.h"
+
+namespace {
+/* The tolerance of the simplification. */
+const float RVO_TOLERANCE = 0.1F;
+
+/* Returns a counterclockwise square of a specified size with a specified
+ * number of vertices on each side, all evenly spaced. */
+std::vector<RVO::Vector2> makeSquare(const RVO::Vector2 &minCorner, float size,
+                                     std::size_t numVerticesPerSide) {
+  const RVO::Vector2 directions[4] = {
+      RVO::Vector2(1.0F, 0.0F), RVO::Vector2(0.0F, 1.0F),
+      RVO::Vector2(-1.0F, 0.0F), RVO::Vector2(0.0F, -1.0F)};
+  const float spacing = size / static_cast<float>(numVerticesPerSide);
+  std::vector<RVO::Vector2> vertices;
+  RVO::Vector2 vertex = minCorner;
+
+  for (std::size_t i = 0U; i < 4U; ++i) {
+    for (std::size_t j = 0U; j < numVerticesPerSide; ++j) {
+      vertices.push_back(vertex);
+      vertex += spacing * directions[i];
+    }
+  }
+
+  return vertices;
+}
+
+std::vector<RVO::Vector2> makeTriangle(const RVO::Vector2 &vertex1,
+                                       const RVO::Vector2 &vertex2,
+                                       const RVO::Vector2 &vertex3) {
+  std::vector<RVO::Vector2> vertices;
+  vertices.push_back(vertex1);
+  vertices.push_back(vertex2);
+  vertices.push_back(vertex3);
+
+  return vertices;
+}
+
+/* Simplifies the specified obstacles and checks the count of vertices removed
+ * and the count of vertices left. */
+std::size_t checkSimplification(
+    const char *name, const std::vector<std::vector<RVO::Vector2> > &obstacles,
+    std::size_t expectedNumRemoved, std::size_t expectedNumVertices) {
+  RVO::RVOSimulator simulator;
+
+  for (std::size_t i = 0U; i < obstacles.size(); ++i) {
+    simulator.addObstacle(obstacles[i]);
+  }
+
+  const std::size_t numRemoved = simulator.simplifyObstacles(RVO_TOLERANCE);
+  std::size_t numFailures = 0U;
+
+  if (numRemoved != expectedNumRemoved) {
+    std::cerr << name << ": " << numRemoved << " vertices removed, expected "
+              << expectedNumRemoved << std::endl;
+    ++numFailures;
+  }
+
+  if (simulator.getNumObstacleVertices() != expectedNumVertices) {
+    std::cerr << name << ": " << simulator.getNumObstacleVertices()
+              << " vertices left, expected " << expectedNumVertices
+              << std::endl;
+    ++numFailures;
+  }
+
+  return numFailures;
+}
+} /* namespace */
+
+int main() {
+  std::size_t numFailures = 0U;
+
+  /* The collinear vertices of the sides of a square are removed. */
+  numFailures += checkSimplification(
+      "collinear vertices",
+      std::vector<std::vector<RVO::Vector2> >(
+          1U, makeSquare(RVO::Vector2(0.0F, 0.0F), 4.0F, 3U)),
+      8U, 4U);
+
+  /* A vertex close to its predecessor is removed. */
+  std::vector<RVO::Vector2> square =
+      makeSquare(RVO::Vector2(0.0F, 0.0F), 4.0F, 1U);
+  square.insert(square.begin() + 2, RVO::Vector2(4.0F, 3.95F));
+  numFailures += checkSimplification(
+      "near-duplicate vertices",
+      std::vector<std::vector<RVO::Vector2> >(1U, square), 1U, 4U);
+
+  /* A triangle thinner than the tolerance is not reduced to a line
+   * segment. */
+  numFailures += checkSimplification(
+      "thin triangle",
+      std::vector<std::vector<RVO::Vector2> >(
+          1U, makeTriangle(RVO::Vector2(0.0F, 0.0F), RVO::Vector2(4.0F, 0.0F),
+                           RVO::Vector2(2.0F, 0.05F))),
+      0U, 3U);
+
+  /* A triangle whose vertices snap to two vertices is removed. */
+  numFailures += checkSimplification(
+      "tiny triangle",
+      std::vector<std::vector<RVO::Vector2> >(
+          1U,
+          makeTriangle(RVO::Vector2(0.0F, 0.0F), RVO::Vector2(0.15F, 0.0F),
+                       RVO::Vector2(0.1F, 0.02F))),
+      3U, 0U);
+
+  /* A line segment remains. */
+  std::vector<RVO::Vector2> segment;
+  segment.push_back(RVO::Vector2(0.0F, 0.0F));
+  segment.push_back(RVO::Vector2(4.0F, 0.0F));
+  numFailures += checkSimplification(
+      "line segment", std::vector<std::vector<RVO::Vector2> >(1U, segment), 0U,
+      2U);
+
+  /* A square nested inside another square is removed. */
+  std::vector<std::vector<RVO::Vector2> > nestedSquares;
+  nestedSquares.push_back(makeSquare(RVO::Vector2(0.0F, 0.0F), 10.0F, 1U));
+  nestedSquares.push_back(makeSquare(RVO::Vector2(4.0F, 4.0F), 2.0F, 1U));
+  numFailures += checkSimplification("nested square", nestedSquares, 4U, 4U);
+
+  return numFailures == 0U ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -42,6 +42,8 @@
 #include <cmath>
 #include <limits>
 
+#include "BoxObstacle.h"
+#include "ClusterProxy.h"
 #include "KdTree.h"
 #include "Obstacle.h"
 
@@ -240,380 +242,793 @@ void linearProgram3(const std::vector<Line> &lines, std::size_t numObstLines,
     }
   }
 }
+
+/**
+ * @relates   Agent
+ * @brief     Rotates a vector from the frame of a face of a box obstacle back
+ *            to the world frame.
+ * @param[in] vector The vector in the frame of the face.
+ * @param[in] face   The face of the box obstacle, counterclockwise from the
+ *                   face with minimum y-coordinate.
+ * @return    The vector in the world frame.
+ */
+Vector2 rotateFromBoxFace(const Vector2 &vector, std::size_t face) {
+  switch (face) {
+    case 1U:
+      return Vector2(-vector.y(), vector.x());
+    case 2U:
+      return Vector2(-vector.x(), -vector.y());
+    case 3U:
+      return Vector2(vector.y(), -vector.x());
+    default:
+      return vector;
+  }
+}
+
+/**
+ * @relates   Agent
+ * @brief     Rotates a vector from the world frame to the frame of a face of a
+ *            box obstacle, in which the face points along the positive x-axis
+ *            and lies above the agents that can see it.
+ * @param[in] vector The vector in the world frame.
+ * @param[in] face   The face of the box obstacle, counterclockwise from the
+ *                   face with minimum y-coordinate.
+ * @return    The vector in the frame of the face.
+ */
+Vector2 rotateToBoxFace(const Vector2 &vector, std::size_t face) {
+  switch (face) {
+    case 1U:
+      return Vector2(vector.y(), -vector.x());
+    case 2U:
+      return Vector2(-vector.x(), -vector.y());
+    case 3U:
+      return Vector2(-vector.y(), vector.x());
+    default:
+      return vector;
+  }
+}
 } /* namespace */
 
 Agent::Agent()
     : id_(0U),
+      layer_(0U),
       maxNeighbors_(0U),
+      neighborLimit_(0U),
+      numObstacleEdgesTested_(0U),
+      numObstacleTreeNodesVisited_(0U),
+      numPrunedORCALines_(0U),
+      collisionGroups_(1U),
+      collisionMask_(~0U),
       maxSpeed_(0.0F),
       neighborDist_(0.0F),
+      priority_(0.0F),
       radius_(0.0F),
       timeHorizon_(0.0F),
-      timeHorizonObst_(0.0F) {}
+      timeHorizonObst_(0.0F),
+      isDeferred_(false),
+      isInfeasible_(false),
+      isIntrospectionEnabled_(true),
+      isKinematic_(false) {}
 
 Agent::~Agent() {}
 
+void Agent::computeAgentORCALine(const Vector2 &position,
+                                 const Vector2 &velocity, float radius,
+                                 float responsibility, float invTimeHorizon,
+                                 float timeStep) {
+  const Vector2 relativePosition = position - position_;
+  const Vector2 relativeVelocity = velocity_ - velocity;
+  const float distSq = absSq(relativePosition);
+  const float combinedRadius = radius_ + radius;
+  const float combinedRadiusSq = combinedRadius * combinedRadius;
+
+  Line line;
+  Vector2 u;
+
+  if (distSq > combinedRadiusSq) {
+    /* No collision. */
+    const Vector2 w = relativeVelocity - invTimeHorizon * relativePosition;
+    /* Vector from cutoff center to relative velocity. */
+    const float wLengthSq = absSq(w);
+
+    const float dotProduct = w * relativePosition;
+
+    if (dotProduct < 0.0F &&
+        dotProduct * dotProduct > combinedRadiusSq * wLengthSq) {
+      /* Project on cut-off circle. */
+      const float wLength = std::sqrt(wLengthSq);
+      const Vector2 unitW = w / wLength;
+
+      line.direction = Vector2(unitW.y(), -unitW.x());
+      u = (combinedRadius * invTimeHorizon - wLength) * unitW;
+    } else {
+      /* Project on legs. */
+      const float leg = std::sqrt(distSq - combinedRadiusSq);
+
+      if (det(relativePosition, w) > 0.0F) {
+        /* Project on left leg. */
+        line.direction = Vector2(relativePosition.x() * leg -
+                                     relativePosition.y() * combinedRadius,
+                                 relativePosition.x() * combinedRadius +
+                                     relativePosition.y() * leg) /
+                         distSq;
+      } else {
+        /* Project on right leg. */
+        line.direction = -Vector2(relativePosition.x() * leg +
+                                      relativePosition.y() * combinedRadius,
+                                  -relativePosition.x() * combinedRadius +
+                                      relativePosition.y() * leg) /
+                         distSq;
+      }
+
+      u = (relativeVelocity * line.direction) * line.direction -
+          relativeVelocity;
+    }
+  } else {
+    /* Collision. Project on cut-off circle of time timeStep. */
+    const float invTimeStep = 1.0F / timeStep;
+
+    /* Vector from cutoff center to relative velocity. */
+    const Vector2 w = relativeVelocity - invTimeStep * relativePosition;
+
+    const float wLength = abs(w);
+    const Vector2 unitW = w / wLength;
+
+    line.direction = Vector2(unitW.y(), -unitW.x());
+    u = (combinedRadius * invTimeStep - wLength) * unitW;
+  }
+
+  line.point = velocity_ + responsibility * u;
+  orcaLines_.push_back(line);
+}
+
+void Agent::computeBoxObstacleORCALine(const Vector2 &point1,
+                                       const Vector2 &point2, std::size_t face,
+                                       float invTimeHorizonObst) {
+  const Vector2 relativePosition1 = point1 - position_;
+  const Vector2 relativePosition2 = point2 - position_;
+
+  /* Check if velocity obstacle of face is already taken care of by previously
+   * constructed obstacle ORCA lines. */
+  for (std::size_t j = 0U; j < orcaLines_.size(); ++j) {
+    if (det(invTimeHorizonObst * relativePosition1 - orcaLines_[j].point,
+            orcaLines_[j].direction) -
+                invTimeHorizonObst * radius_ >=
+            -RVO_EPSILON &&
+        det(invTimeHorizonObst * relativePosition2 - orcaLines_[j].point,
+            orcaLines_[j].direction) -
+                invTimeHorizonObst * radius_ >=
+            -RVO_EPSILON) {
+      return;
+    }
+  }
+
+  /* In the frame of the face, the face runs from (x1, y) to (x2, y) with
+   * x1 < x2 and y > 0, its neighboring faces point along the negative and
+   * positive y-axis, and all its vertices are convex. */
+  const float x1 = rotateToBoxFace(relativePosition1, face).x();
+  const float x2 = rotateToBoxFace(relativePosition2, face).x();
+  const float y = rotateToBoxFace(relativePosition1, face).y();
+  const Vector2 velocity = rotateToBoxFace(velocity_, face);
+
+  const float distSq1 = x1 * x1 + y * y;
+  const float distSq2 = x2 * x2 + y * y;
+  const float distSqLine = y * y;
+  const float radiusSq = radius_ * radius_;
+
+  Line line;
+
+  if (x1 > 0.0F && distSq1 <= radiusSq) {
+    /* Collision with left vertex. */
+    line.point = Vector2(0.0F, 0.0F);
+    line.direction = rotateFromBoxFace(normalize(Vector2(-y, x1)), face);
+    orcaLines_.push_back(line);
+
+    return;
+  }
+
+  if (x2 < 0.0F && distSq2 <= radiusSq) {
+    /* Collision with right vertex, taken care of by the next face. */
+    return;
+  }
+
+  if (distSqLine <= radiusSq) {
+    if (x1 <= 0.0F && x2 >= 0.0F) {
+      /* Collision with face. */
+      line.point = Vector2(0.0F, 0.0F);
+      line.direction = rotateFromBoxFace(Vector2(-1.0F, 0.0F), face);
+      orcaLines_.push_back(line);
+
+      return;
+    }
+  }
+
+  /* No collision. Compute legs, which come from a single vertex when the face
+   * is viewed obliquely. */
+  const bool isOblique = distSqLine <= radiusSq;
+  const float legX = x1 > 0.0F || !isOblique ? x1 : x2;
+  const float legDistSq = x1 > 0.0F || !isOblique ? distSq1 : distSq2;
+  const float leg1 = std::sqrt(legDistSq - radiusSq);
+  Vector2 leftLegDirection =
+      Vector2(legX * leg1 - y * radius_, legX * radius_ + y * leg1) /
+      legDistSq;
+
+  const float rightLegX = isOblique ? legX : x2;
+  const float rightLegDistSq = isOblique ? legDistSq : distSq2;
+  const float leg2 = std::sqrt(rightLegDistSq - radiusSq);
+  Vector2 rightLegDirection =
+      Vector2(rightLegX * leg2 + y * radius_, -rightLegX * radius_ + y * leg2) /
+      rightLegDistSq;
+
+  /* Legs can never point into a neighboring face, take the cut-off line of the
+   * neighboring face instead. If velocity projected on "foreign" leg, no
+   * constraint is added. */
+  bool isLeftLegForeign = false;
+  bool isRightLegForeign = false;
+
+  if (isOblique && x2 < 0.0F) {
+    /* Both legs from the right vertex, whose left neighbor is this face. */
+    if (leftLegDirection.y() >= 0.0F) {
+      leftLegDirection = Vector2(-1.0F, 0.0F);
+      isLeftLegForeign = true;
+    }
+  } else if (leftLegDirection.x() >= 0.0F) {
+    leftLegDirection = Vector2(0.0F, 1.0F);
+    isLeftLegForeign = true;
+  }
+
+  if (isOblique && x1 > 0.0F) {
+    /* Both legs from the left vertex, whose right neighbor is this face. */
+    if (rightLegDirection.y() >= 0.0F) {
+      rightLegDirection = Vector2(1.0F, 0.0F);
+      isRightLegForeign = true;
+    }
+  } else if (rightLegDirection.x() <= 0.0F) {
+    rightLegDirection = Vector2(0.0F, 1.0F);
+    isRightLegForeign = true;
+  }
+
+  /* Compute cut-off centers. */
+  const Vector2 leftCutoff = invTimeHorizonObst * Vector2(legX, y);
+  const Vector2 rightCutoff = invTimeHorizonObst * Vector2(rightLegX, y);
+  const float cutoffLength = rightCutoff.x() - leftCutoff.x();
+
+  /* Check if current velocity is projected on cutoff circles. */
+  const float t =
+      isOblique ? 0.5F : (velocity.x() - leftCutoff.x()) / cutoffLength;
+  const float tLeft = (velocity - leftCutoff) * leftLegDirection;
+  const float tRight = (velocity - rightCutoff) * rightLegDirection;
+
+  if ((t < 0.0F && tLeft < 0.0F) ||
+      (isOblique && tLeft < 0.0F && tRight < 0.0F)) {
+    /* Project on left cut-off circle. */
+    const Vector2 unitW = normalize(velocity - leftCutoff);
+
+    line.direction = rotateFromBoxFace(Vector2(unitW.y(), -unitW.x()), face);
+    line.point = rotateFromBoxFace(
+        leftCutoff + radius_ * invTimeHorizonObst * unitW, face);
+    orcaLines_.push_back(line);
+
+    return;
+  }
+
+  if (t > 1.0F && tRight < 0.0F) {
+    /* Project on right cut-off circle. */
+    const Vector2 unitW = normalize(velocity - rightCutoff);
+
+    line.direction = rotateFromBoxFace(Vector2(unitW.y(), -unitW.x()), face);
+    line.point = rotateFromBoxFace(
+        rightCutoff + radius_ * invTimeHorizonObst * unitW, face);
+    orcaLines_.push_back(line);
+
+    return;
+  }
+
+  /* Project on left leg, right leg, or cut-off line, whichever is closest to
+   * velocity. The cut-off line is parallel to the x-axis. */
+  const float distSqCutoff =
+      (t < 0.0F || t > 1.0F || isOblique)
+          ? std::numeric_limits<float>::infinity()
+          : (velocity.y() - leftCutoff.y()) * (velocity.y() - leftCutoff.y());
+  const float distSqLeft =
+      tLeft < 0.0F
+          ? std::numeric_limits<float>::infinity()
+          : absSq(velocity - (leftCutoff + tLeft * leftLegDirection));
+  const float distSqRight =
+      tRight < 0.0F
+          ? std::numeric_limits<float>::infinity()
+          : absSq(velocity - (rightCutoff + tRight * rightLegDirection));
+
+  Vector2 direction;
+  Vector2 cutoff;
+
+  if (distSqCutoff <= distSqLeft && distSqCutoff <= distSqRight) {
+    /* Project on cut-off line. */
+    direction = Vector2(-1.0F, 0.0F);
+    cutoff = leftCutoff;
+  } else if (distSqLeft <= distSqRight) {
+    /* Project on left leg. */
+    if (isLeftLegForeign) {
+      return;
+    }
+
+    direction = leftLegDirection;
+    cutoff = leftCutoff;
+  } else {
+    /* Project on right leg. */
+    if (isRightLegForeign) {
+      return;
+    }
+
+    direction = -rightLegDirection;
+    cutoff = rightCutoff;
+  }
+
+  line.direction = rotateFromBoxFace(direction, face);
+  line.point = rotateFromBoxFace(
+      cutoff + radius_ * invTimeHorizonObst *
+                   Vector2(-direction.y(), direction.x()),
+      face);
+  orcaLines_.push_back(line);
+}
+
 void Agent::computeNeighbors(const KdTree *kdTree) {
   obstacleNeighbors_.clear();
+  numObstacleEdgesTested_ = 0U;
+  numObstacleTreeNodesVisited_ = 0U;
   const float range = timeHorizonObst_ * maxSpeed_ + radius_;
   kdTree->computeObstacleNeighbors(this, range * range);
 
+  boxObstacleNeighbors_.clear();
+  kdTree->computeBoxObstacleNeighbors(this, range * range);
+
   agentNeighbors_.clear();
+  clusterNeighbors_.clear();
 
   if (maxNeighbors_ > 0U) {
     float rangeSq = neighborDist_ * neighborDist_;
+    neighborLimit_ = maxNeighbors_;
+
+    if (kdTree->adaptiveNeighborCount_ > 0U) {
+      /* Agents packed as densely as their radii allow keep the adaptive
+       * neighbor count of neighbors, agents at lower densities proportionally
+       * more. The search starts within the squared range limit / density,
+       * which is about pi times the area expected to hold the limit, as the
+       * density is only an estimate. */
+      const float density = kdTree->computeAgentDensity(this);
+      const float crowding = 4.0F * radius_ * radius_ * density;
+      const float count = static_cast<float>(kdTree->adaptiveNeighborCount_);
+
+      if (crowding * static_cast<float>(maxNeighbors_) > count) {
+        neighborLimit_ = std::min(
+            maxNeighbors_,
+            std::max(kdTree->adaptiveNeighborCount_,
+                     static_cast<std::size_t>(count / crowding)));
+        rangeSq =
+            std::min(rangeSq, static_cast<float>(neighborLimit_) / density);
+      }
+    }
+
     kdTree->computeAgentNeighbors(this, rangeSq);
   }
 }
 
 /* Search for the best new velocity. */
-void Agent::computeNewVelocity(float timeStep) {
+void Agent::computeNewVelocity(float timeStep, bool isConstraintPruningEnabled,
+                               const Vector2 &perturbation) {
   orcaLines_.clear();
 
   const float invTimeHorizonObst = 1.0F / timeHorizonObst_;
 
   /* Create obstacle ORCA lines. */
   for (std::size_t i = 0U; i < obstacleNeighbors_.size(); ++i) {
-    const Obstacle *obstacle1 = obstacleNeighbors_[i].second;
-    const Obstacle *obstacle2 = obstacle1->next_;
-
-    const Vector2 relativePosition1 = obstacle1->point_ - position_;
-    const Vector2 relativePosition2 = obstacle2->point_ - position_;
-
-    /* Check if velocity obstacle of obstacle is already taken care of by
-     * previously constructed obstacle ORCA lines. */
-    bool alreadyCovered = false;
-
-    for (std::size_t j = 0U; j < orcaLines_.size(); ++j) {
-      if (det(invTimeHorizonObst * relativePosition1 - orcaLines_[j].point,
-              orcaLines_[j].direction) -
-                  invTimeHorizonObst * radius_ >=
-              -RVO_EPSILON &&
-          det(invTimeHorizonObst * relativePosition2 - orcaLines_[j].point,
-              orcaLines_[j].direction) -
-                  invTimeHorizonObst * radius_ >=
-              -RVO_EPSILON) {
-        alreadyCovered = true;
-        break;
+    const Obstacle *const obstacle1 = obstacleNeighbors_[i].second;
+    const Obstacle *const obstacle2 = obstacle1->next_;
+
+    computeObstacleORCALine(obstacle1->point_, obstacle2->point_,
+                            obstacle1->direction_,
+                            obstacle1->previous_->direction_,
+                            obstacle2->direction_, obstacle1->isConvex_,
+                            obstacle2->isConvex_, invTimeHorizonObst);
+  }
+
+  /* Create box obstacle ORCA lines for the faces visible from the agent. */
+  for (std::size_t i = 0U; i < boxObstacleNeighbors_.size(); ++i) {
+    const BoxObstacle *const boxObstacle = boxObstacleNeighbors_[i].second;
+    const Vector2 &minCorner = boxObstacle->minCorner_;
+    const Vector2 &maxCorner = boxObstacle->maxCorner_;
+
+    /* Counterclockwise corners. */
+    const Vector2 corners[4] = {
+        minCorner, Vector2(maxCorner.x(), minCorner.y()), maxCorner,
+        Vector2(minCorner.x(), maxCorner.y())};
+    const bool isVisible[4] = {
+        position_.y() < minCorner.y(), position_.x() > maxCorner.x(),
+        position_.y() > maxCorner.y(), position_.x() < minCorner.x()};
+
+    for (std::size_t j = 0U; j < 4U; ++j) {
+      if (isVisible[j]) {
+        computeBoxObstacleORCALine(corners[j], corners[(j + 1U) % 4U], j,
+                                   invTimeHorizonObst);
       }
     }
+  }
 
-    if (alreadyCovered) {
-      continue;
-    }
+  const std::size_t numObstLines = orcaLines_.size();
 
-    /* Not yet covered. Check for collisions. */
-    const float distSq1 = absSq(relativePosition1);
-    const float distSq2 = absSq(relativePosition2);
+  const float invTimeHorizon = 1.0F / timeHorizon_;
 
-    const float radiusSq = radius_ * radius_;
+  /* Create agent ORCA lines. */
+  for (std::size_t i = 0U; i < agentNeighbors_.size(); ++i) {
+    const Agent *const other = agentNeighbors_[i].second;
 
-    const Vector2 obstacleVector = obstacle2->point_ - obstacle1->point_;
-    const float s =
-        (-relativePosition1 * obstacleVector) / absSq(obstacleVector);
-    const float distSqLine = absSq(-relativePosition1 - s * obstacleVector);
+    /* Kinematic agents and agents whose collision masks exclude the collision
+     * groups of this agent do not reciprocate, so this agent takes full
+     * responsibility for avoiding them. */
+    const bool isReciprocal = !other->isKinematic_ &&
+                              (collisionGroups_ & other->collisionMask_) != 0U;
+    computeAgentORCALine(other->position_, other->velocity_, other->radius_,
+                         isReciprocal ? 0.5F : 1.0F, invTimeHorizon, timeStep);
+  }
 
-    Line line;
+  /* Create cluster ORCA lines. Clusters do not reciprocate, so this agent
+   * takes full responsibility for avoiding them. */
+  for (std::size_t i = 0U; i < clusterNeighbors_.size(); ++i) {
+    const ClusterProxy *const clusterProxy = clusterNeighbors_[i].second;
+    computeAgentORCALine(clusterProxy->position_, clusterProxy->velocity_,
+                         clusterProxy->radius_, 1.0F, invTimeHorizon,
+                         timeStep);
+  }
 
-    if (s < 0.0F && distSq1 <= radiusSq) {
-      /* Collision with left vertex. Ignore if non-convex. */
-      if (obstacle1->isConvex_) {
-        line.point = Vector2(0.0F, 0.0F);
-        line.direction =
-            normalize(Vector2(-relativePosition1.y(), relativePosition1.x()));
-        orcaLines_.push_back(line);
-      }
+  numPrunedORCALines_ = 0U;
 
-      continue;
-    }
+  if (isConstraintPruningEnabled) {
+    /* Drop agent ORCA lines whose half-plane of permissible velocities
+     * contains the whole disc of speeds up to the maximum speed, as no
+     * velocity considered by the linear programs can violate them. Obstacle
+     * lines are kept, as linearProgram3 treats them as hard constraints. */
+    std::size_t numLines = numObstLines;
 
-    if (s > 1.0F && distSq2 <= radiusSq) {
-      /* Collision with right vertex. Ignore if non-convex or if it will be
-       * taken care of by neighoring obstace */
-      if (obstacle2->isConvex_ &&
-          det(relativePosition2, obstacle2->direction_) >= 0.0F) {
-        line.point = Vector2(0.0F, 0.0F);
-        line.direction =
-            normalize(Vector2(-relativePosition2.y(), relativePosition2.x()));
-        orcaLines_.push_back(line);
+    for (std::size_t i = numObstLines; i < orcaLines_.size(); ++i) {
+      if (det(orcaLines_[i].direction, orcaLines_[i].point) + maxSpeed_ >
+          -RVO_EPSILON) {
+        orcaLines_[numLines++] = orcaLines_[i];
       }
-
-      continue;
     }
 
-    if (s >= 0.0F && s <= 1.0F && distSqLine <= radiusSq) {
-      /* Collision with obstacle segment. */
-      line.point = Vector2(0.0F, 0.0F);
-      line.direction = -obstacle1->direction_;
-      orcaLines_.push_back(line);
-      continue;
+    numPrunedORCALines_ = orcaLines_.size() - numLines;
+    orcaLines_.resize(numLines);
+  }
+
+  const std::size_t lineFail =
+      linearProgram2(orcaLines_, maxSpeed_, prefVelocity_ + perturbation, false,
+                     newVelocity_);
+
+  isInfeasible_ = lineFail < orcaLines_.size();
+
+  if (isInfeasible_) {
+    linearProgram3(orcaLines_, numObstLines, lineFail, maxSpeed_, newVelocity_);
+  }
+}
+
+void Agent::computeObstacleORCALine(
+    const Vector2 &point1, const Vector2 &point2, const Vector2 &direction,
+    const Vector2 &prevDirection, const Vector2 &nextDirection, bool isConvex1,
+    bool isConvex2, float invTimeHorizonObst) {
+  const Vector2 relativePosition1 = point1 - position_;
+  const Vector2 relativePosition2 = point2 - position_;
+
+  /* Check if velocity obstacle of obstacle is already taken care of by
+   * previously constructed obstacle ORCA lines. */
+  bool alreadyCovered = false;
+
+  for (std::size_t j = 0U; j < orcaLines_.size(); ++j) {
+    if (det(invTimeHorizonObst * relativePosition1 - orcaLines_[j].point,
+            orcaLines_[j].direction) -
+                invTimeHorizonObst * radius_ >=
+            -RVO_EPSILON &&
+        det(invTimeHorizonObst * relativePosition2 - orcaLines_[j].point,
+            orcaLines_[j].direction) -
+                invTimeHorizonObst * radius_ >=
+            -RVO_EPSILON) {
+      alreadyCovered = true;
+      break;
     }
+  }
 
-    /* No collision. Compute legs. When obliquely viewed, both legs can come
-     * from a single vertex. Legs extend cut-off line when nonconvex vertex. */
-    Vector2 leftLegDirection;
-    Vector2 rightLegDirection;
+  if (alreadyCovered) {
+    return;
+  }
 
-    if (s < 0.0F && distSqLine <= radiusSq) {
-      /* Obstacle viewed obliquely so that left vertex defines velocity
-       * obstacle. */
-      if (!obstacle1->isConvex_) {
-        /* Ignore obstacle. */
-        continue;
-      }
+  /* Not yet covered. Check for collisions. */
+  const float distSq1 = absSq(relativePosition1);
+  const float distSq2 = absSq(relativePosition2);
 
-      obstacle2 = obstacle1;
+  const float radiusSq = radius_ * radius_;
 
-      const float leg1 = std::sqrt(distSq1 - radiusSq);
-      leftLegDirection =
-          Vector2(
-              relativePosition1.x() * leg1 - relativePosition1.y() * radius_,
-              relativePosition1.x() * radius_ + relativePosition1.y() * leg1) /
-          distSq1;
-      rightLegDirection =
-          Vector2(
-              relativePosition1.x() * leg1 + relativePosition1.y() * radius_,
-              -relativePosition1.x() * radius_ + relativePosition1.y() * leg1) /
-          distSq1;
-    } else if (s > 1.0F && distSqLine <= radiusSq) {
-      /* Obstacle viewed obliquely so that right vertex defines velocity
-       * obstacle. */
-      if (!obstacle2->isConvex_) {
-        /* Ignore obstacle. */
-        continue;
-      }
+  const Vector2 obstacleVector = point2 - point1;
+  const float s = (-relativePosition1 * obstacleVector) / absSq(obstacleVector);
+  const float distSqLine = absSq(-relativePosition1 - s * obstacleVector);
 
-      obstacle1 = obstacle2;
+  Line line;
 
-      const float leg2 = std::sqrt(distSq2 - radiusSq);
-      leftLegDirection =
-          Vector2(
-              relativePosition2.x() * leg2 - relativePosition2.y() * radius_,
-              relativePosition2.x() * radius_ + relativePosition2.y() * leg2) /
-          distSq2;
-      rightLegDirection =
-          Vector2(
-              relativePosition2.x() * leg2 + relativePosition2.y() * radius_,
-              -relativePosition2.x() * radius_ + relativePosition2.y() * leg2) /
-          distSq2;
-    } else {
-      /* Usual situation. */
-      if (obstacle1->isConvex_) {
-        const float leg1 = std::sqrt(distSq1 - radiusSq);
-        leftLegDirection = Vector2(relativePosition1.x() * leg1 -
-                                       relativePosition1.y() * radius_,
-                                   relativePosition1.x() * radius_ +
-                                       relativePosition1.y() * leg1) /
-                           distSq1;
-      } else {
-        /* Left vertex non-convex; left leg extends cut-off line. */
-        leftLegDirection = -obstacle1->direction_;
-      }
+  if (s < 0.0F && distSq1 <= radiusSq) {
+    /* Collision with left vertex. Ignore if non-convex. */
+    if (isConvex1) {
+      line.point = Vector2(0.0F, 0.0F);
+      line.direction =
+          normalize(Vector2(-relativePosition1.y(), relativePosition1.x()));
+      orcaLines_.push_back(line);
+    }
 
-      if (obstacle2->isConvex_) {
-        const float leg2 = std::sqrt(distSq2 - radiusSq);
-        rightLegDirection = Vector2(relativePosition2.x() * leg2 +
-                                        relativePosition2.y() * radius_,
-                                    -relativePosition2.x() * radius_ +
-                                        relativePosition2.y() * leg2) /
-                            distSq2;
-      } else {
-        /* Right vertex non-convex; right leg extends cut-off line. */
-        rightLegDirection = obstacle1->direction_;
-      }
+    return;
+  }
+
+  if (s > 1.0F && distSq2 <= radiusSq) {
+    /* Collision with right vertex. Ignore if non-convex or if it will be
+     * taken care of by neighoring obstace */
+    if (isConvex2 && det(relativePosition2, nextDirection) >= 0.0F) {
+      line.point = Vector2(0.0F, 0.0F);
+      line.direction =
+          normalize(Vector2(-relativePosition2.y(), relativePosition2.x()));
+      orcaLines_.push_back(line);
     }
 
-    /* Legs can never point into neighboring edge when convex vertex, take
-     * cutoff-line of neighboring edge instead. If velocity projected on
-     * "foreign" leg, no constraint is added. */
-    const Obstacle *const leftNeighbor = obstacle1->previous_;
+    return;
+  }
 
-    bool isLeftLegForeign = false;
-    bool isRightLegForeign = false;
+  if (s >= 0.0F && s <= 1.0F && distSqLine <= radiusSq) {
+    /* Collision with obstacle segment. */
+    line.point = Vector2(0.0F, 0.0F);
+    line.direction = -direction;
+    orcaLines_.push_back(line);
+    return;
+  }
 
-    if (obstacle1->isConvex_ &&
-        det(leftLegDirection, -leftNeighbor->direction_) >= 0.0F) {
-      /* Left leg points into obstacle. */
-      leftLegDirection = -leftNeighbor->direction_;
-      isLeftLegForeign = true;
+  /* No collision. Compute legs. When obliquely viewed, both legs can come
+   * from a single vertex. Legs extend cut-off line when nonconvex vertex. */
+  Vector2 leftLegDirection;
+  Vector2 rightLegDirection;
+  Vector2 leftPoint = point1;
+  Vector2 rightPoint = point2;
+  Vector2 leftNeighborDirection = prevDirection;
+  Vector2 rightNeighborDirection = nextDirection;
+  bool isLeftConvex = isConvex1;
+  bool isRightConvex = isConvex2;
+  bool isSingleVertex = false;
+
+  if (s < 0.0F && distSqLine <= radiusSq) {
+    /* Obstacle viewed obliquely so that left vertex defines velocity
+     * obstacle. */
+    if (!isConvex1) {
+      /* Ignore obstacle. */
+      return;
     }
 
-    if (obstacle2->isConvex_ &&
-        det(rightLegDirection, obstacle2->direction_) <= 0.0F) {
-      /* Right leg points into obstacle. */
-      rightLegDirection = obstacle2->direction_;
-      isRightLegForeign = true;
+    rightPoint = point1;
+    rightNeighborDirection = direction;
+    isRightConvex = isConvex1;
+    isSingleVertex = true;
+
+    const float leg1 = std::sqrt(distSq1 - radiusSq);
+    leftLegDirection =
+        Vector2(
+            relativePosition1.x() * leg1 - relativePosition1.y() * radius_,
+            relativePosition1.x() * radius_ + relativePosition1.y() * leg1) /
+        distSq1;
+    rightLegDirection =
+        Vector2(
+            relativePosition1.x() * leg1 + relativePosition1.y() * radius_,
+            -relativePosition1.x() * radius_ + relativePosition1.y() * leg1) /
+        distSq1;
+  } else if (s > 1.0F && distSqLine <= radiusSq) {
+    /* Obstacle viewed obliquely so that right vertex defines velocity
+     * obstacle. */
+    if (!isConvex2) {
+      /* Ignore obstacle. */
+      return;
     }
 
-    /* Compute cut-off centers. */
-    const Vector2 leftCutoff =
-        invTimeHorizonObst * (obstacle1->point_ - position_);
-    const Vector2 rightCutoff =
-        invTimeHorizonObst * (obstacle2->point_ - position_);
-    const Vector2 cutoffVector = rightCutoff - leftCutoff;
+    leftPoint = point2;
+    leftNeighborDirection = direction;
+    isLeftConvex = isConvex2;
+    isSingleVertex = true;
+
+    const float leg2 = std::sqrt(distSq2 - radiusSq);
+    leftLegDirection =
+        Vector2(
+            relativePosition2.x() * leg2 - relativePosition2.y() * radius_,
+            relativePosition2.x() * radius_ + relativePosition2.y() * leg2) /
+        distSq2;
+    rightLegDirection =
+        Vector2(
+            relativePosition2.x() * leg2 + relativePosition2.y() * radius_,
+            -relativePosition2.x() * radius_ + relativePosition2.y() * leg2) /
+        distSq2;
+  } else {
+    /* Usual situation. */
+    if (isConvex1) {
+      const float leg1 = std::sqrt(distSq1 - radiusSq);
+      leftLegDirection = Vector2(relativePosition1.x() * leg1 -
+                                     relativePosition1.y() * radius_,
+                                 relativePosition1.x() * radius_ +
+                                     relativePosition1.y() * leg1) /
+                         distSq1;
+    } else {
+      /* Left vertex non-convex; left leg extends cut-off line. */
+      leftLegDirection = -direction;
+    }
 
-    /* Project current velocity on velocity obstacle. */
+    if (isConvex2) {
+      const float leg2 = std::sqrt(distSq2 - radiusSq);
+      rightLegDirection = Vector2(relativePosition2.x() * leg2 +
+                                      relativePosition2.y() * radius_,
+                                  -relativePosition2.x() * radius_ +
+                                      relativePosition2.y() * leg2) /
+                          distSq2;
+    } else {
+      /* Right vertex non-convex; right leg extends cut-off line. */
+      rightLegDirection = direction;
+    }
+  }
 
-    /* Check if current velocity is projected on cutoff circles. */
-    const float t =
-        obstacle1 == obstacle2
-            ? 0.5F
-            : (velocity_ - leftCutoff) * cutoffVector / absSq(cutoffVector);
-    const float tLeft = (velocity_ - leftCutoff) * leftLegDirection;
-    const float tRight = (velocity_ - rightCutoff) * rightLegDirection;
+  /* Legs can never point into neighboring edge when convex vertex, take
+   * cutoff-line of neighboring edge instead. If velocity projected on
+   * "foreign" leg, no constraint is added. */
+  bool isLeftLegForeign = false;
+  bool isRightLegForeign = false;
 
-    if ((t < 0.0F && tLeft < 0.0F) ||
-        (obstacle1 == obstacle2 && tLeft < 0.0F && tRight < 0.0F)) {
-      /* Project on left cut-off circle. */
-      const Vector2 unitW = normalize(velocity_ - leftCutoff);
+  if (isLeftConvex && det(leftLegDirection, -leftNeighborDirection) >= 0.0F) {
+    /* Left leg points into obstacle. */
+    leftLegDirection = -leftNeighborDirection;
+    isLeftLegForeign = true;
+  }
 
-      line.direction = Vector2(unitW.y(), -unitW.x());
-      line.point = leftCutoff + radius_ * invTimeHorizonObst * unitW;
-      orcaLines_.push_back(line);
-      continue;
-    }
+  if (isRightConvex && det(rightLegDirection, rightNeighborDirection) <= 0.0F) {
+    /* Right leg points into obstacle. */
+    rightLegDirection = rightNeighborDirection;
+    isRightLegForeign = true;
+  }
 
-    if (t > 1.0F && tRight < 0.0F) {
-      /* Project on right cut-off circle. */
-      const Vector2 unitW = normalize(velocity_ - rightCutoff);
+  /* Compute cut-off centers. */
+  const Vector2 leftCutoff = invTimeHorizonObst * (leftPoint - position_);
+  const Vector2 rightCutoff = invTimeHorizonObst * (rightPoint - position_);
+  const Vector2 cutoffVector = rightCutoff - leftCutoff;
 
-      line.direction = Vector2(unitW.y(), -unitW.x());
-      line.point = rightCutoff + radius_ * invTimeHorizonObst * unitW;
-      orcaLines_.push_back(line);
-      continue;
-    }
+  /* Project current velocity on velocity obstacle. */
 
-    /* Project on left leg, right leg, or cut-off line, whichever is closest to
-     * velocity. */
-    const float distSqCutoff =
-        (t < 0.0F || t > 1.0F || obstacle1 == obstacle2)
-            ? std::numeric_limits<float>::infinity()
-            : absSq(velocity_ - (leftCutoff + t * cutoffVector));
-    const float distSqLeft =
-        tLeft < 0.0F
-            ? std::numeric_limits<float>::infinity()
-            : absSq(velocity_ - (leftCutoff + tLeft * leftLegDirection));
-    const float distSqRight =
-        tRight < 0.0F
-            ? std::numeric_limits<float>::infinity()
-            : absSq(velocity_ - (rightCutoff + tRight * rightLegDirection));
-
-    if (distSqCutoff <= distSqLeft && distSqCutoff <= distSqRight) {
-      /* Project on cut-off line. */
-      line.direction = -obstacle1->direction_;
-      line.point =
-          leftCutoff + radius_ * invTimeHorizonObst *
-                           Vector2(-line.direction.y(), line.direction.x());
-      orcaLines_.push_back(line);
-      continue;
-    }
+  /* Check if current velocity is projected on cutoff circles. */
+  const float t =
+      isSingleVertex ? 0.5F
+                     : (velocity_ - leftCutoff) * cutoffVector /
+                           absSq(cutoffVector);
+  const float tLeft = (velocity_ - leftCutoff) * leftLegDirection;
+  const float tRight = (velocity_ - rightCutoff) * rightLegDirection;
 
-    if (distSqLeft <= distSqRight) {
-      /* Project on left leg. */
-      if (isLeftLegForeign) {
-        continue;
-      }
+  if ((t < 0.0F && tLeft < 0.0F) ||
+      (isSingleVertex && tLeft < 0.0F && tRight < 0.0F)) {
+    /* Project on left cut-off circle. */
+    const Vector2 unitW = normalize(velocity_ - leftCutoff);
 
-      line.direction = leftLegDirection;
-      line.point =
-          leftCutoff + radius_ * invTimeHorizonObst *
-                           Vector2(-line.direction.y(), line.direction.x());
-      orcaLines_.push_back(line);
-      continue;
-    }
+    line.direction = Vector2(unitW.y(), -unitW.x());
+    line.point = leftCutoff + radius_ * invTimeHorizonObst * unitW;
+    orcaLines_.push_back(line);
+    return;
+  }
 
-    /* Project on right leg. */
-    if (isRightLegForeign) {
-      continue;
+  if (t > 1.0F && tRight < 0.0F) {
+    /* Project on right cut-off circle. */
+    const Vector2 unitW = normalize(velocity_ - rightCutoff);
+
+    line.direction = Vector2(unitW.y(), -unitW.x());
+    line.point = rightCutoff + radius_ * invTimeHorizonObst * unitW;
+    orcaLines_.push_back(line);
+    return;
+  }
+
+  /* Project on left leg, right leg, or cut-off line, whichever is closest to
+   * velocity. */
+  const float distSqCutoff =
+      (t < 0.0F || t > 1.0F || isSingleVertex)
+          ? std::numeric_limits<float>::infinity()
+          : absSq(velocity_ - (leftCutoff + t * cutoffVector));
+  const float distSqLeft =
+      tLeft < 0.0F
+          ? std::numeric_limits<float>::infinity()
+          : absSq(velocity_ - (leftCutoff + tLeft * leftLegDirection));
+  const float distSqRight =
+      tRight < 0.0F
+          ? std::numeric_limits<float>::infinity()
+          : absSq(velocity_ - (rightCutoff + tRight * rightLegDirection));
+
+  if (distSqCutoff <= distSqLeft && distSqCutoff <= distSqRight) {
+    /* Project on cut-off line. */
+    line.direction = -direction;
+    line.point =
+        leftCutoff + radius_ * invTimeHorizonObst *
+                         Vector2(-line.direction.y(), line.direction.x());
+    orcaLines_.push_back(line);
+    return;
+  }
+
+  if (distSqLeft <= distSqRight) {
+    /* Project on left leg. */
+    if (isLeftLegForeign) {
+      return;
     }
 
-    line.direction = -rightLegDirection;
+    line.direction = leftLegDirection;
     line.point =
-        rightCutoff + radius_ * invTimeHorizonObst *
-                          Vector2(-line.direction.y(), line.direction.x());
+        leftCutoff + radius_ * invTimeHorizonObst *
+                         Vector2(-line.direction.y(), line.direction.x());
     orcaLines_.push_back(line);
+    return;
   }
 
-  const std::size_t numObstLines = orcaLines_.size();
+  /* Project on right leg. */
+  if (isRightLegForeign) {
+    return;
+  }
 
-  const float invTimeHorizon = 1.0F / timeHorizon_;
+  line.direction = -rightLegDirection;
+  line.point =
+      rightCutoff + radius_ * invTimeHorizonObst *
+                        Vector2(-line.direction.y(), line.direction.x());
+  orcaLines_.push_back(line);
+}
+
+float Agent::computeSafeTimeStep() const {
+  float safeTimeStep = std::numeric_limits<float>::infinity();
 
-  /* Create agent ORCA lines. */
   for (std::size_t i = 0U; i < agentNeighbors_.size(); ++i) {
     const Agent *const other = agentNeighbors_[i].second;
+    const float clearance =
+        abs(other->position_ - position_) - radius_ - other->radius_;
 
-    const Vector2 relativePosition = other->position_ - position_;
-    const Vector2 relativeVelocity = velocity_ - other->velocity_;
-    const float distSq = absSq(relativePosition);
-    const float combinedRadius = radius_ + other->radius_;
-    const float combinedRadiusSq = combinedRadius * combinedRadius;
+    if (clearance <= 0.0F) {
+      return 0.0F;
+    }
 
-    Line line;
-    Vector2 u;
+    const float relativeSpeed = abs(velocity_ - other->velocity_);
 
-    if (distSq > combinedRadiusSq) {
-      /* No collision. */
-      const Vector2 w = relativeVelocity - invTimeHorizon * relativePosition;
-      /* Vector from cutoff center to relative velocity. */
-      const float wLengthSq = absSq(w);
+    if (clearance < safeTimeStep * relativeSpeed) {
+      safeTimeStep = clearance / relativeSpeed;
+    }
+  }
 
-      const float dotProduct = w * relativePosition;
+  /* Obstacles are static, so the relative speed is the speed of the agent. */
+  float obstacleDistSq = std::numeric_limits<float>::infinity();
 
-      if (dotProduct < 0.0F &&
-          dotProduct * dotProduct > combinedRadiusSq * wLengthSq) {
-        /* Project on cut-off circle. */
-        const float wLength = std::sqrt(wLengthSq);
-        const Vector2 unitW = w / wLength;
+  for (std::size_t i = 0U; i < obstacleNeighbors_.size(); ++i) {
+    const Obstacle *const obstacle = obstacleNeighbors_[i].second;
+    obstacleDistSq = std::min(
+        obstacleDistSq, distSqPointLineSegment(obstacle->point_,
+                                               obstacle->next_->point_,
+                                               position_));
+  }
 
-        line.direction = Vector2(unitW.y(), -unitW.x());
-        u = (combinedRadius * invTimeHorizon - wLength) * unitW;
-      } else {
-        /* Project on legs. */
-        const float leg = std::sqrt(distSq - combinedRadiusSq);
-
-        if (det(relativePosition, w) > 0.0F) {
-          /* Project on left leg. */
-          line.direction = Vector2(relativePosition.x() * leg -
-                                       relativePosition.y() * combinedRadius,
-                                   relativePosition.x() * combinedRadius +
-                                       relativePosition.y() * leg) /
-                           distSq;
-        } else {
-          /* Project on right leg. */
-          line.direction = -Vector2(relativePosition.x() * leg +
-                                        relativePosition.y() * combinedRadius,
-                                    -relativePosition.x() * combinedRadius +
-                                        relativePosition.y() * leg) /
-                           distSq;
-        }
+  for (std::size_t i = 0U; i < boxObstacleNeighbors_.size(); ++i) {
+    const BoxObstacle *const boxObstacle = boxObstacleNeighbors_[i].second;
+    obstacleDistSq = std::min(
+        obstacleDistSq, distSqBoxPoint(boxObstacle->minCorner_,
+                                       boxObstacle->maxCorner_, position_));
+  }
 
-        u = (relativeVelocity * line.direction) * line.direction -
-            relativeVelocity;
-      }
-    } else {
-      /* Collision. Project on cut-off circle of time timeStep. */
-      const float invTimeStep = 1.0F / timeStep;
+  if (obstacleDistSq < std::numeric_limits<float>::infinity()) {
+    const float clearance = std::sqrt(obstacleDistSq) - radius_;
 
-      /* Vector from cutoff center to relative velocity. */
-      const Vector2 w = relativeVelocity - invTimeStep * relativePosition;
+    if (clearance <= 0.0F) {
+      return 0.0F;
+    }
 
-      const float wLength = abs(w);
-      const Vector2 unitW = w / wLength;
+    const float speed = abs(velocity_);
 
-      line.direction = Vector2(unitW.y(), -unitW.x());
-      u = (combinedRadius * invTimeStep - wLength) * unitW;
+    if (clearance < safeTimeStep * speed) {
+      safeTimeStep = clearance / speed;
     }
-
-    line.point = velocity_ + 0.5F * u;
-    orcaLines_.push_back(line);
   }
 
-  const std::size_t lineFail =
-      linearProgram2(orcaLines_, maxSpeed_, prefVelocity_, false, newVelocity_);
-
-  if (lineFail < orcaLines_.size()) {
-    linearProgram3(orcaLines_, numObstLines, lineFail, maxSpeed_, newVelocity_);
-  }
+  return safeTimeStep;
 }
 
 void Agent::insertAgentNeighbor(const Agent *agent, float &rangeSq) {
@@ -621,7 +1036,7 @@ void Agent::insertAgentNeighbor(const Agent *agent, float &rangeSq) {
     const float distSq = absSq(position_ - agent->position_);
 
     if (distSq < rangeSq) {
-      if (agentNeighbors_.size() < maxNeighbors_) {
+      if (agentNeighbors_.size() < neighborLimit_) {
         agentNeighbors_.push_back(std::make_pair(distSq, agent));
       }
 
@@ -634,13 +1049,37 @@ void Agent::insertAgentNeighbor(const Agent *agent, float &rangeSq) {
 
       agentNeighbors_[i] = std::make_pair(distSq, agent);
 
-      if (agentNeighbors_.size() == maxNeighbors_) {
+      if (agentNeighbors_.size() == neighborLimit_) {
         rangeSq = agentNeighbors_.back().first;
       }
     }
   }
 }
 
+void Agent::insertBoxObstacleNeighbor(const BoxObstacle *boxObstacle,
+                                      float rangeSq) {
+  const float distSq = distSqBoxPoint(boxObstacle->minCorner_,
+                                      boxObstacle->maxCorner_, position_);
+
+  if (distSq < rangeSq) {
+    boxObstacleNeighbors_.push_back(std::make_pair(distSq, boxObstacle));
+
+    std::size_t i = boxObstacleNeighbors_.size() - 1U;
+
+    while (i != 0U && distSq < boxObstacleNeighbors_[i - 1U].first) {
+      boxObstacleNeighbors_[i] = boxObstacleNeighbors_[i - 1U];
+      --i;
+    }
+
+    boxObstacleNeighbors_[i] = std::make_pair(distSq, boxObstacle);
+  }
+}
+
+void Agent::insertClusterNeighbor(const ClusterProxy *clusterProxy,
+                                  float distSq) {
+  clusterNeighbors_.push_back(std::make_pair(distSq, clusterProxy));
+}
+
 void Agent::insertObstacleNeighbor(const Obstacle *obstacle, float rangeSq) {
   const Obstacle *const nextObstacle = obstacle->next_;
 
@@ -672,7 +1111,19 @@ void Agent::insertObstacleNeighbor(const Obstacle *obstacle, float rangeSq) {
   }
 }
 
-void Agent::update(float timeStep) {
+void Agent::swapBuffers(Agent *other) {
+  agentNeighbors_.swap(other->agentNeighbors_);
+  boxObstacleNeighbors_.swap(other->boxObstacleNeighbors_);
+  clusterNeighbors_.swap(other->clusterNeighbors_);
+  obstacleNeighbors_.swap(other->obstacleNeighbors_);
+  orcaLines_.swap(other->orcaLines_);
+}
+
+void Agent::update(float timeStep, bool isPreviousPositionRetained) {
+  if (isPreviousPositionRetained) {
+    previousPosition_ = position_;
+  }
+
   velocity_ = newVelocity_;
   position_ += velocity_ * timeStep;
 }
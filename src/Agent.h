@@ -47,6 +47,8 @@
 #include "Vector2.h"
 
 namespace RVO {
+class BoxObstacle;
+class ClusterProxy;
 class KdTree;
 class Obstacle;
 
@@ -65,6 +67,39 @@ class Agent {
    */
   ~Agent();
 
+  /**
+   * @brief     Computes the ORCA constraint induced by another moving disk and
+   *            adds it to the ORCA constraints of this agent.
+   * @param[in] position       The two-dimensional position of the disk.
+   * @param[in] velocity       The two-dimensional velocity of the disk.
+   * @param[in] radius         The radius of the disk.
+   * @param[in] responsibility The share of the avoidance effort taken by this
+   *                           agent, 0.5 for reciprocating agents and 1 for
+   *                           disks that do not reciprocate.
+   * @param[in] invTimeHorizon The inverse of the time horizon of this agent.
+   * @param[in] timeStep       The time step of the simulation.
+   */
+  void computeAgentORCALine(const Vector2 &position, const Vector2 &velocity,
+                            float radius, float responsibility,
+                            float invTimeHorizon, float timeStep);
+
+  /**
+   * @brief     Computes the ORCA constraint induced by a face of a static
+   *            axis-aligned box obstacle that is visible from this agent and
+   *            adds it to the ORCA constraints of this agent unless it is
+   *            already covered by them. Equivalent to computeObstacleORCALine
+   *            for the face, but computed in the frame of the face, in which
+   *            the distances and legs reduce to single coordinates.
+   * @param[in] point1             The first vertex of the face.
+   * @param[in] point2             The second vertex of the face.
+   * @param[in] face               The face, counterclockwise from the face with
+   *                               minimum y-coordinate.
+   * @param[in] invTimeHorizonObst The inverse of the time horizon with respect
+   *                               to obstacles of this agent.
+   */
+  void computeBoxObstacleORCALine(const Vector2 &point1, const Vector2 &point2,
+                                  std::size_t face, float invTimeHorizonObst);
+
   /**
    * @brief     Computes the neighbors of this agent.
    * @param[in] kdTree A pointer to the k-D trees for agents and static
@@ -74,9 +109,47 @@ class Agent {
 
   /**
    * @brief     Computes the new velocity of this agent.
-   * @param[in] timeStep The time step of the simulation.
+   * @param[in] timeStep                   The time step of the simulation.
+   * @param[in] isConstraintPruningEnabled Whether agent ORCA lines that cannot
+   *                                       bind within the maximum speed are
+   *                                       dropped before the linear programs.
+   * @param[in] perturbation               The perturbation added to the
+   *                                       preferred velocity in this step.
    */
-  void computeNewVelocity(float timeStep);
+  void computeNewVelocity(float timeStep, bool isConstraintPruningEnabled,
+                          const Vector2 &perturbation);
+
+  /**
+   * @brief     Computes the ORCA constraint induced by a static obstacle edge
+   *            and adds it to the ORCA constraints of this agent unless it is
+   *            already covered by them.
+   * @param[in] point1             The first vertex of the obstacle edge.
+   * @param[in] point2             The second vertex of the obstacle edge.
+   * @param[in] direction          The unit direction of the obstacle edge.
+   * @param[in] prevDirection      The unit direction of the obstacle edge
+   *                               preceding the first vertex.
+   * @param[in] nextDirection      The unit direction of the obstacle edge
+   *                               succeeding the second vertex.
+   * @param[in] isConvex1          True if the first vertex is convex.
+   * @param[in] isConvex2          True if the second vertex is convex.
+   * @param[in] invTimeHorizonObst The inverse of the time horizon with respect
+   *                               to obstacles of this agent.
+   */
+  void computeObstacleORCALine(const Vector2 &point1, const Vector2 &point2,
+                               const Vector2 &direction,
+                               const Vector2 &prevDirection,
+                               const Vector2 &nextDirection, bool isConvex1,
+                               bool isConvex2, float invTimeHorizonObst);
+
+  /**
+   * @brief  Computes the time within which this agent could close its
+   *         clearance to its nearest neighbor or obstacle at their current
+   *         relative speed.
+   * @return The time within which the clearance could be closed, zero if this
+   *         agent overlaps a neighbor or obstacle, and infinity if it has
+   *         neither agent nor obstacle neighbors.
+   */
+  float computeSafeTimeStep() const;
 
   /**
    * @brief          Inserts an agent neighbor into the set of neighbors of this
@@ -87,6 +160,25 @@ class Agent {
   void insertAgentNeighbor(const Agent *agent,
                            float &rangeSq); /* NOLINT(runtime/references) */
 
+  /**
+   * @brief     Inserts a static box obstacle neighbor into the set of
+   *            neighbors of this agent.
+   * @param[in] boxObstacle A pointer to the static box obstacle to be
+   *                        inserted.
+   * @param[in] rangeSq     The squared range around this agent.
+   */
+  void insertBoxObstacleNeighbor(const BoxObstacle *boxObstacle,
+                                 float rangeSq);
+
+  /**
+   * @brief     Inserts a cluster proxy neighbor into the set of neighbors of
+   *            this agent.
+   * @param[in] clusterProxy A pointer to the cluster proxy to be inserted.
+   * @param[in] distSq       The squared distance from this agent to the
+   *                         center of the cluster proxy.
+   */
+  void insertClusterNeighbor(const ClusterProxy *clusterProxy, float distSq);
+
   /**
    * @brief          Inserts a static obstacle neighbor into the set of
    *                 neighbors of this agent.
@@ -95,12 +187,22 @@ class Agent {
    */
   void insertObstacleNeighbor(const Obstacle *obstacle, float rangeSq);
 
+  /**
+   * @brief     Exchanges the neighbor lists and ORCA lines of this agent with
+   *            those of another agent in constant time.
+   * @param[in] other The agent with which to exchange the lists.
+   */
+  void swapBuffers(Agent *other);
+
   /**
    * @brief     Updates the two-dimensional position and two-dimensional
    *            velocity of this agent.
-   * @param[in] timeStep The time step of the simulation.
+   * @param[in] timeStep                   The time step of the simulation.
+   * @param[in] isPreviousPositionRetained Whether the two-dimensional
+   *                                       position before the update is
+   *                                       retained for interpolation.
    */
-  void update(float timeStep);
+  void update(float timeStep, bool isPreviousPositionRetained);
 
   /* Not implemented. */
   Agent(const Agent &other);
@@ -109,19 +211,34 @@ class Agent {
   Agent &operator=(const Agent &other);
 
   std::vector<std::pair<float, const Agent *> > agentNeighbors_;
+  std::vector<std::pair<float, const BoxObstacle *> > boxObstacleNeighbors_;
+  std::vector<std::pair<float, const ClusterProxy *> > clusterNeighbors_;
   std::vector<std::pair<float, const Obstacle *> > obstacleNeighbors_;
   std::vector<Line> orcaLines_;
   Vector2 newVelocity_;
   Vector2 position_;
   Vector2 prefVelocity_;
+  Vector2 previousPosition_;
   Vector2 velocity_;
   std::size_t id_;
+  std::size_t layer_;
   std::size_t maxNeighbors_;
+  std::size_t neighborLimit_;
+  std::size_t numObstacleEdgesTested_;
+  std::size_t numObstacleTreeNodesVisited_;
+  std::size_t numPrunedORCALines_;
+  unsigned int collisionGroups_;
+  unsigned int collisionMask_;
   float maxSpeed_;
   float neighborDist_;
+  float priority_;
   float radius_;
   float timeHorizon_;
   float timeHorizonObst_;
+  bool isDeferred_;
+  bool isInfeasible_;
+  bool isIntrospectionEnabled_;
+  bool isKinematic_;
 
   friend class KdTree;
   friend class RVOSimulator;
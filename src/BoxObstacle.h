@@ -0,0 +1,73 @@
+/*
+ * BoxObstacle.h
+ * RVO2 Library
+ *
+ * SPDX-FileCopyrightText: 2008 University of North Carolina at Chapel Hill
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Please send all bug reports to <geom@cs.unc.edu>.
+ *
+ * The authors may be contacted via:
+ *
+ * Jur van den Berg, Stephen J. Guy, Jamie Snape, Ming C. Lin, Dinesh Manocha
+ * Dept. of Computer Science
+ * 201 S. Columbia St.
+ * Frederick P. Brooks, Jr. Computer Science Bldg.
+ * Chapel Hill, N.C. 27599-3175
+ * United States of America
+ *
+ * <https://gamma.cs.unc.edu/RVO2/>
+ */
+
+#ifndef RVO_BOX_OBSTACLE_H_
+#define RVO_BOX_OBSTACLE_H_
+
+/**
+ * @file  BoxObstacle.h
+ * @brief Declares the BoxObstacle class.
+ */
+
+#include <cstddef>
+
+#include "Vector2.h"
+
+namespace RVO {
+/**
+ * @brief Defines static axis-aligned box obstacles in the simulation.
+ */
+class BoxObstacle {
+ private:
+  /**
+   * @brief     Constructs a static axis-aligned box obstacle instance.
+   * @param[in] minCorner The corner of the box with minimum coordinates.
+   * @param[in] maxCorner The corner of the box with maximum coordinates.
+   * @param[in] id        The number of the box obstacle.
+   * @param[in] layer     The layer of the box obstacle.
+   */
+  BoxObstacle(const Vector2 &minCorner, const Vector2 &maxCorner,
+              std::size_t id, std::size_t layer);
+
+  Vector2 maxCorner_;
+  Vector2 minCorner_;
+  std::size_t id_;
+  std::size_t layer_;
+
+  friend class Agent;
+  friend class KdTree;
+  friend class RVOSimulator;
+};
+} /* namespace RVO */
+
+#endif /* RVO_BOX_OBSTACLE_H_ */
@@ -0,0 +1,65 @@
+/*
+ * ClusterProxy.h
+ * RVO2 Library
+ *
+ * SPDX-FileCopyrightText: 2008 University of North Carolina at Chapel Hill
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Please send all bug reports to <geom@cs.unc.edu>.
+ *
+ * The authors may be contacted via:
+ *
+ * Jur van den Berg, Stephen J. Guy, Jamie Snape, Ming C. Lin, Dinesh Manocha
+ * Dept. of Computer Science
+ * 201 S. Columbia St.
+ * Frederick P. Brooks, Jr. Computer Science Bldg.
+ * Chapel Hill, N.C. 27599-3175
+ * United States of America
+ *
+ * <https://gamma.cs.unc.edu/RVO2/>
+ */
+
+#ifndef RVO_CLUSTER_PROXY_H_
+#define RVO_CLUSTER_PROXY_H_
+
+/**
+ * @file  ClusterProxy.h
+ * @brief Declares the ClusterProxy class.
+ */
+
+#include "Vector2.h"
+
+namespace RVO {
+/**
+ * @brief Defines a disk standing in for the agents of an agent k-D tree node
+ *        when they are avoided from afar as a single moving obstacle.
+ */
+class ClusterProxy {
+ private:
+  /**
+   * @brief Constructs a cluster proxy instance.
+   */
+  ClusterProxy();
+
+  Vector2 position_;
+  Vector2 velocity_;
+  float radius_;
+
+  friend class Agent;
+  friend class KdTree;
+};
+} /* namespace RVO */
+
+#endif /* RVO_CLUSTER_PROXY_H_ */
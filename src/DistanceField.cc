@@ -0,0 +1,162 @@
+/*
+ * DistanceField.cc
+ * RVO2 Library
+ *
+ * SPDX-FileCopyrightText: 2008 University of North Carolina at Chapel Hill
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Please send all bug reports to <geom@cs.unc.edu>.
+ *
+ * The authors may be contacted via:
+ *
+ * Jur van den Berg, Stephen J. Guy, Jamie Snape, Ming C. Lin, Dinesh Manocha
+ * Dept. of Computer Science
+ * 201 S. Columbia St.
+ * Frederick P. Brooks, Jr. Computer Science Bldg.
+ * Chapel Hill, N.C. 27599-3175
+ * United States of America
+ *
+ * <https://gamma.cs.unc.edu/RVO2/>
+ */
+
+/**
+ * @file  DistanceField.cc
+ * @brief Defines the DistanceField class.
+ */
+
+#include "DistanceField.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "Obstacle.h"
+#include "RVOSimulator.h"
+#include "Vector2.h"
+
+namespace RVO {
+DistanceField::DistanceField(const std::vector<const Obstacle *> &obstacles,
+                             float cellSize, float maxRange)
+    : cellSize_(cellSize),
+      maxRange_(maxRange),
+      minX_(0.0F),
+      minY_(0.0F),
+      numCellsX_(0U),
+      numCellsY_(0U) {
+  if (obstacles.empty()) {
+    return;
+  }
+
+  /* Cover every point within the maximum range of an obstacle edge. */
+  float maxX = obstacles.front()->point_.x();
+  float maxY = obstacles.front()->point_.y();
+  minX_ = maxX;
+  minY_ = maxY;
+
+  for (std::size_t i = 1U; i < obstacles.size(); ++i) {
+    maxX = std::max(maxX, obstacles[i]->point_.x());
+    minX_ = std::min(minX_, obstacles[i]->point_.x());
+    maxY = std::max(maxY, obstacles[i]->point_.y());
+    minY_ = std::min(minY_, obstacles[i]->point_.y());
+  }
+
+  minX_ -= maxRange_;
+  minY_ -= maxRange_;
+  numCellsX_ = static_cast<std::size_t>(
+                   std::floor((maxX + maxRange_ - minX_) / cellSize_)) +
+               1U;
+  numCellsY_ = static_cast<std::size_t>(
+                   std::floor((maxY + maxRange_ - minY_) / cellSize_)) +
+               1U;
+
+  const std::size_t numCells = numCellsX_ * numCellsY_;
+  const float maxRangeSq = maxRange_ * maxRange_;
+
+  cellBegins_.assign(numCells + 1U, 0U);
+  cellDistances_.assign(numCells, maxRange_);
+
+  std::vector<std::size_t> cellCounters;
+
+  /* Two passes over the obstacle edges: count the edges near each cell, then
+   * store them contiguously. */
+  for (std::size_t pass = 0U; pass < 2U; ++pass) {
+    if (pass == 1U) {
+      for (std::size_t i = 0U; i < numCells; ++i) {
+        cellBegins_[i + 1U] += cellBegins_[i];
+      }
+
+      cellCounters.assign(cellBegins_.begin(), cellBegins_.end() - 1);
+      cellObstacles_.resize(cellBegins_[numCells]);
+    }
+
+    for (std::size_t i = 0U; i < obstacles.size(); ++i) {
+      const Vector2 &point1 = obstacles[i]->point_;
+      const Vector2 &point2 = obstacles[i]->next_->point_;
+
+      const std::size_t beginX = static_cast<std::size_t>(
+          (std::min(point1.x(), point2.x()) - maxRange_ - minX_) / cellSize_);
+      const std::size_t endX = std::min(
+          numCellsX_ - 1U,
+          static_cast<std::size_t>(
+              (std::max(point1.x(), point2.x()) + maxRange_ - minX_) /
+              cellSize_));
+      const std::size_t beginY = static_cast<std::size_t>(
+          (std::min(point1.y(), point2.y()) - maxRange_ - minY_) / cellSize_);
+      const std::size_t endY = std::min(
+          numCellsY_ - 1U,
+          static_cast<std::size_t>(
+              (std::max(point1.y(), point2.y()) + maxRange_ - minY_) /
+              cellSize_));
+
+      for (std::size_t y = beginY; y <= endY; ++y) {
+        for (std::size_t x = beginX; x <= endX; ++x) {
+          const Vector2 minCorner(minX_ + static_cast<float>(x) * cellSize_,
+                                  minY_ + static_cast<float>(y) * cellSize_);
+          const Vector2 maxCorner(minCorner.x() + cellSize_,
+                                  minCorner.y() + cellSize_);
+          const float distSq =
+              distSqBoxLineSegment(minCorner, maxCorner, point1, point2);
+
+          if (distSq < maxRangeSq) {
+            const std::size_t cell = y * numCellsX_ + x;
+
+            if (pass == 0U) {
+              ++cellBegins_[cell + 1U];
+              cellDistances_[cell] =
+                  std::min(cellDistances_[cell], std::sqrt(distSq));
+            } else {
+              cellObstacles_[cellCounters[cell]++] = obstacles[i];
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+DistanceField::~DistanceField() {}
+
+std::size_t DistanceField::getCell(const Vector2 &point) const {
+  const float x = (point.x() - minX_) / cellSize_;
+  const float y = (point.y() - minY_) / cellSize_;
+
+  if (x >= 0.0F && y >= 0.0F && x < static_cast<float>(numCellsX_) &&
+      y < static_cast<float>(numCellsY_)) {
+    return static_cast<std::size_t>(y) * numCellsX_ +
+           static_cast<std::size_t>(x);
+  }
+
+  return RVO_ERROR;
+}
+} /* namespace RVO */
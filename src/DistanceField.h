@@ -0,0 +1,101 @@
+/*
+ * DistanceField.h
+ * RVO2 Library
+ *
+ * SPDX-FileCopyrightText: 2008 University of North Carolina at Chapel Hill
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Please send all bug reports to <geom@cs.unc.edu>.
+ *
+ * The authors may be contacted via:
+ *
+ * Jur van den Berg, Stephen J. Guy, Jamie Snape, Ming C. Lin, Dinesh Manocha
+ * Dept. of Computer Science
+ * 201 S. Columbia St.
+ * Frederick P. Brooks, Jr. Computer Science Bldg.
+ * Chapel Hill, N.C. 27599-3175
+ * United States of America
+ *
+ * <https://gamma.cs.unc.edu/RVO2/>
+ */
+
+#ifndef RVO_DISTANCE_FIELD_H_
+#define RVO_DISTANCE_FIELD_H_
+
+/**
+ * @file  DistanceField.h
+ * @brief Declares the DistanceField class.
+ */
+
+#include <cstddef>
+#include <vector>
+
+namespace RVO {
+class Obstacle;
+class Vector2;
+
+/**
+ * @brief Defines a coarse grid over the static obstacles in the simulation
+ *        that stores, for each cell, a lower bound on the distance to the
+ *        nearest obstacle edge and the obstacle edges near the cell.
+ */
+class DistanceField {
+ private:
+  /**
+   * @brief     Constructs a distance field instance.
+   * @param[in] obstacles The obstacle vertices of the simulation, each of
+   *                      which defines an obstacle edge to its successor.
+   * @param[in] cellSize  The width and height of a cell. Must be positive.
+   * @param[in] maxRange  The maximum range within which obstacle edges are
+   *                      stored with each cell. Must be positive.
+   */
+  DistanceField(const std::vector<const Obstacle *> &obstacles,
+                float cellSize, float maxRange);
+
+  /**
+   * @brief Destroys this distance field instance.
+   */
+  ~DistanceField();
+
+  /**
+   * @brief     Returns the cell that contains the specified point.
+   * @param[in] point The point whose cell is to be retrieved.
+   * @return    The number of the cell, or RVO::RVO_ERROR when the point lies
+   *            outside the distance field, and so farther than the maximum
+   *            range from every obstacle edge.
+   */
+  std::size_t getCell(const Vector2 &point) const;
+
+  /* Not implemented. */
+  DistanceField(const DistanceField &other);
+
+  /* Not implemented. */
+  DistanceField &operator=(const DistanceField &other);
+
+  std::vector<std::size_t> cellBegins_;
+  std::vector<float> cellDistances_;
+  std::vector<const Obstacle *> cellObstacles_;
+  float cellSize_;
+  float maxRange_;
+  float minX_;
+  float minY_;
+  std::size_t numCellsX_;
+  std::size_t numCellsY_;
+
+  friend class KdTree;
+};
+} /* namespace RVO */
+
+#endif /* RVO_DISTANCE_FIELD_H_ */
@@ -39,13 +39,25 @@
 #include "KdTree.h"
 
 #include <algorithm>
+#include <cmath>
+#include <limits>
 #include <utility>
 
 #include "Agent.h"
+#include "BoxObstacle.h"
+#include "DistanceField.h"
 #include "Obstacle.h"
 #include "RVOSimulator.h"
 #include "Vector2.h"
 
+/* Tasks require OpenMP 3.0, which some compilers do not support. */
+#if defined(_OPENMP) && _OPENMP >= 200805
+#include <omp.h>
+#define RVO_OPENMP_TASKS 1
+#else
+#define RVO_OPENMP_TASKS 0
+#endif /* _OPENMP */
+
 namespace RVO {
 namespace {
 /**
@@ -53,6 +65,20 @@ namespace {
  * @brief   The maximum k-D tree node leaf size.
  */
 const std::size_t RVO_MAX_LEAF_SIZE = 10U;
+
+/**
+ * @relates KdTree
+ * @brief   The minimum number of obstacles for which the subtree of an obstacle
+ *          k-D tree is built as a separate task.
+ */
+const std::size_t RVO_MIN_OBSTACLE_TASK_SIZE = 64U;
+
+/**
+ * @relates KdTree
+ * @brief   The minimum number of obstacles for which candidate split edges of
+ *          an obstacle k-D tree node are scored in parallel.
+ */
+const std::size_t RVO_MIN_PARALLEL_SPLIT_SIZE = 512U;
 } /* namespace */
 
 /**
@@ -85,6 +111,11 @@ class KdTree::AgentTreeNode {
    */
   std::size_t right;
 
+  /**
+   * @brief The union of the collision groups of the agents in the node.
+   */
+  unsigned int collisionGroups;
+
   /**
    * @brief The maximum x-coordinate.
    */
@@ -111,6 +142,7 @@ KdTree::AgentTreeNode::AgentTreeNode()
       end(0U),
       left(0U),
       right(0U),
+      collisionGroups(0U),
       maxX(0.0F),
       maxY(0.0F),
       minX(0.0F),
@@ -160,9 +192,20 @@ KdTree::ObstacleTreeNode::ObstacleTreeNode()
 KdTree::ObstacleTreeNode::~ObstacleTreeNode() {}
 
 KdTree::KdTree(RVOSimulator *simulator)
-    : obstacleTree_(NULL), simulator_(simulator) {}
+    : simulator_(simulator),
+      adaptiveNeighborCount_(0U),
+      numObstacleSplits_(0U),
+      clusterProxyRatio_(0.0F) {}
+
+KdTree::~KdTree() {
+  for (std::size_t i = 0U; i < distanceFields_.size(); ++i) {
+    delete distanceFields_[i];
+  }
 
-KdTree::~KdTree() { deleteObstacleTree(obstacleTree_); }
+  for (std::size_t i = 0U; i < obstacleTrees_.size(); ++i) {
+    deleteObstacleTree(obstacleTrees_[i]);
+  }
+}
 
 void KdTree::buildAgentTree() {
   if (agents_.size() < simulator_->agents_.size()) {
@@ -173,8 +216,49 @@ void KdTree::buildAgentTree() {
     agentTree_.resize(2U * agents_.size() - 1U);
   }
 
-  if (!agents_.empty()) {
-    buildAgentTreeRecursive(0U, agents_.size(), 0U);
+  /* Group the agents by layer, keeping the order of the previous build within
+   * each layer, and build a separate subtree for each layer. */
+  std::size_t numLayers = 0U;
+
+  for (std::size_t i = 0U; i < agents_.size(); ++i) {
+    numLayers = std::max(numLayers, agents_[i]->layer_ + 1U);
+  }
+
+  std::vector<std::size_t> layerBegins(numLayers + 1U, 0U);
+
+  for (std::size_t i = 0U; i < agents_.size(); ++i) {
+    ++layerBegins[agents_[i]->layer_ + 1U];
+  }
+
+  for (std::size_t i = 0U; i < numLayers; ++i) {
+    layerBegins[i + 1U] += layerBegins[i];
+  }
+
+  if (numLayers > 1U) {
+    std::vector<std::size_t> layerCounters(layerBegins.begin(),
+                                           layerBegins.end() - 1);
+    std::vector<Agent *> agents(agents_.size());
+
+    for (std::size_t i = 0U; i < agents_.size(); ++i) {
+      agents[layerCounters[agents_[i]->layer_]++] = agents_[i];
+    }
+
+    agents_.swap(agents);
+  }
+
+  if (clusterProxyRatio_ > 0.0F &&
+      clusterProxies_.size() != agentTree_.size()) {
+    clusterProxies_.assign(agentTree_.size(), ClusterProxy());
+  }
+
+  agentTreeRoots_.assign(numLayers, RVO_ERROR);
+
+  for (std::size_t i = 0U, node = 0U; i < numLayers; ++i) {
+    if (layerBegins[i] < layerBegins[i + 1U]) {
+      agentTreeRoots_[i] = node;
+      buildAgentTreeRecursive(layerBegins[i], layerBegins[i + 1U], node);
+      node += 2U * (layerBegins[i + 1U] - layerBegins[i]) - 1U;
+    }
   }
 }
 
@@ -184,8 +268,10 @@ void KdTree::buildAgentTreeRecursive(std::size_t begin, std::size_t end,
   agentTree_[node].end = end;
   agentTree_[node].minX = agentTree_[node].maxX = agents_[begin]->position_.x();
   agentTree_[node].minY = agentTree_[node].maxY = agents_[begin]->position_.y();
+  agentTree_[node].collisionGroups = agents_[begin]->collisionGroups_;
 
   for (std::size_t i = begin + 1U; i < end; ++i) {
+    agentTree_[node].collisionGroups |= agents_[i]->collisionGroups_;
     agentTree_[node].maxX =
         std::max(agentTree_[node].maxX, agents_[i]->position_.x());
     agentTree_[node].minX =
@@ -238,17 +324,252 @@ void KdTree::buildAgentTreeRecursive(std::size_t begin, std::size_t end,
     buildAgentTreeRecursive(begin, left, agentTree_[node].left);
     buildAgentTreeRecursive(left, end, agentTree_[node].right);
   }
+
+  if (clusterProxyRatio_ > 0.0F) {
+    buildClusterProxy(node);
+  }
+}
+
+void KdTree::buildBoxObstacleTree() {
+  /* Box obstacle neighbors refer to the box obstacles about to be reordered. */
+  for (std::size_t i = 0U; i < simulator_->agents_.size(); ++i) {
+    simulator_->agents_[i]->boxObstacleNeighbors_.clear();
+  }
+
+  boxObstacleTree_.clear();
+  boxObstacleTreeRoots_.clear();
+
+  /* Group the box obstacles by layer and build a separate subtree for each
+   * layer. */
+  std::vector<std::size_t> layerBegins(1U, 0U);
+
+  for (std::size_t i = 0U; i < boxObstacles_.size(); ++i) {
+    const std::size_t layer = boxObstacles_[i].layer_;
+
+    if (layer + 2U > layerBegins.size()) {
+      layerBegins.resize(layer + 2U, 0U);
+    }
+
+    ++layerBegins[layer + 1U];
+  }
+
+  const std::size_t numLayers = layerBegins.size() - 1U;
+
+  for (std::size_t i = 0U; i < numLayers; ++i) {
+    layerBegins[i + 1U] += layerBegins[i];
+  }
+
+  std::vector<std::size_t> layerCounters(layerBegins.begin(),
+                                         layerBegins.end() - 1);
+  const std::vector<BoxObstacle> boxObstacles(boxObstacles_);
+
+  for (std::size_t i = 0U; i < boxObstacles.size(); ++i) {
+    boxObstacles_[layerCounters[boxObstacles[i].layer_]++] = boxObstacles[i];
+  }
+
+  if (!boxObstacles_.empty()) {
+    boxObstacleTree_.resize(2U * boxObstacles_.size() - 1U);
+  }
+
+  boxObstacleTreeRoots_.assign(numLayers, RVO_ERROR);
+
+  for (std::size_t i = 0U, node = 0U; i < numLayers; ++i) {
+    if (layerBegins[i] < layerBegins[i + 1U]) {
+      boxObstacleTreeRoots_[i] = node;
+      buildBoxObstacleTreeRecursive(layerBegins[i], layerBegins[i + 1U], node);
+      node += 2U * (layerBegins[i + 1U] - layerBegins[i]) - 1U;
+    }
+  }
+
+  for (std::size_t i = 0U; i < boxObstacles_.size(); ++i) {
+    boxObstacleIndices_[boxObstacles_[i].id_] = i;
+  }
+}
+
+void KdTree::buildBoxObstacleTreeRecursive(std::size_t begin, std::size_t end,
+                                           std::size_t node) {
+  boxObstacleTree_[node].begin = begin;
+  boxObstacleTree_[node].end = end;
+  boxObstacleTree_[node].minX = boxObstacles_[begin].minCorner_.x();
+  boxObstacleTree_[node].minY = boxObstacles_[begin].minCorner_.y();
+  boxObstacleTree_[node].maxX = boxObstacles_[begin].maxCorner_.x();
+  boxObstacleTree_[node].maxY = boxObstacles_[begin].maxCorner_.y();
+
+  for (std::size_t i = begin + 1U; i < end; ++i) {
+    boxObstacleTree_[node].maxX =
+        std::max(boxObstacleTree_[node].maxX, boxObstacles_[i].maxCorner_.x());
+    boxObstacleTree_[node].minX =
+        std::min(boxObstacleTree_[node].minX, boxObstacles_[i].minCorner_.x());
+    boxObstacleTree_[node].maxY =
+        std::max(boxObstacleTree_[node].maxY, boxObstacles_[i].maxCorner_.y());
+    boxObstacleTree_[node].minY =
+        std::min(boxObstacleTree_[node].minY, boxObstacles_[i].minCorner_.y());
+  }
+
+  if (end - begin > RVO_MAX_LEAF_SIZE) {
+    /* No leaf node. Split the box obstacles by their centers. */
+    const bool isVertical =
+        boxObstacleTree_[node].maxX - boxObstacleTree_[node].minX >
+        boxObstacleTree_[node].maxY - boxObstacleTree_[node].minY;
+    const float splitValue =
+        isVertical
+            ? boxObstacleTree_[node].maxX + boxObstacleTree_[node].minX
+            : boxObstacleTree_[node].maxY + boxObstacleTree_[node].minY;
+
+    std::size_t left = begin;
+    std::size_t right = end;
+
+    while (left < right) {
+      while (left < right &&
+             (isVertical ? boxObstacles_[left].minCorner_.x() +
+                               boxObstacles_[left].maxCorner_.x()
+                         : boxObstacles_[left].minCorner_.y() +
+                               boxObstacles_[left].maxCorner_.y()) <
+                 splitValue) {
+        ++left;
+      }
+
+      while (right > left &&
+             (isVertical ? boxObstacles_[right - 1U].minCorner_.x() +
+                               boxObstacles_[right - 1U].maxCorner_.x()
+                         : boxObstacles_[right - 1U].minCorner_.y() +
+                               boxObstacles_[right - 1U].maxCorner_.y()) >=
+                 splitValue) {
+        --right;
+      }
+
+      if (left < right) {
+        std::swap(boxObstacles_[left], boxObstacles_[right - 1U]);
+        ++left;
+        --right;
+      }
+    }
+
+    if (left == begin) {
+      ++left;
+      ++right;
+    }
+
+    boxObstacleTree_[node].left = node + 1U;
+    boxObstacleTree_[node].right = node + 2U * (left - begin);
+
+    buildBoxObstacleTreeRecursive(begin, left, boxObstacleTree_[node].left);
+    buildBoxObstacleTreeRecursive(left, end, boxObstacleTree_[node].right);
+  }
+}
+
+void KdTree::buildClusterProxy(std::size_t node) {
+  const AgentTreeNode &treeNode = agentTree_[node];
+  ClusterProxy &clusterProxy = clusterProxies_[node];
+
+  if (treeNode.end - treeNode.begin <= RVO_MAX_LEAF_SIZE) {
+    Vector2 position;
+    Vector2 velocity;
+
+    for (std::size_t i = treeNode.begin; i < treeNode.end; ++i) {
+      position += agents_[i]->position_;
+      velocity += agents_[i]->velocity_;
+    }
+
+    const float invNumAgents =
+        1.0F / static_cast<float>(treeNode.end - treeNode.begin);
+    clusterProxy.position_ = invNumAgents * position;
+    clusterProxy.velocity_ = invNumAgents * velocity;
+    clusterProxy.radius_ = 0.0F;
+
+    for (std::size_t i = treeNode.begin; i < treeNode.end; ++i) {
+      clusterProxy.radius_ = std::max(
+          clusterProxy.radius_,
+          abs(agents_[i]->position_ - clusterProxy.position_) +
+              agents_[i]->radius_);
+    }
+  } else {
+    /* Weight the children by their numbers of agents. */
+    const AgentTreeNode &left = agentTree_[treeNode.left];
+    const ClusterProxy &leftProxy = clusterProxies_[treeNode.left];
+    const ClusterProxy &rightProxy = clusterProxies_[treeNode.right];
+    const float leftWeight = static_cast<float>(left.end - left.begin) /
+                             static_cast<float>(treeNode.end - treeNode.begin);
+    const float rightWeight = 1.0F - leftWeight;
+
+    clusterProxy.position_ =
+        leftWeight * leftProxy.position_ + rightWeight * rightProxy.position_;
+    clusterProxy.velocity_ =
+        leftWeight * leftProxy.velocity_ + rightWeight * rightProxy.velocity_;
+    clusterProxy.radius_ = std::max(
+        abs(leftProxy.position_ - clusterProxy.position_) + leftProxy.radius_,
+        abs(rightProxy.position_ - clusterProxy.position_) +
+            rightProxy.radius_);
+  }
+}
+
+void KdTree::buildDistanceField(float cellSize, float maxRange) {
+  for (std::size_t i = 0U; i < distanceFields_.size(); ++i) {
+    delete distanceFields_[i];
+  }
+
+  distanceFields_.clear();
+
+  if (cellSize > 0.0F && maxRange > 0.0F) {
+    /* Keep at least one distance field, even if empty, so that it is rebuilt
+     * when the obstacles are processed. */
+    distanceFields_.resize(
+        std::max(obstacleTrees_.size(), static_cast<std::size_t>(1U)), NULL);
+
+    for (std::size_t i = 0U; i < distanceFields_.size(); ++i) {
+      std::vector<const Obstacle *> obstacles;
+      collectObstacleTreeRecursive(obstacles, getObstacleTree(i));
+      distanceFields_[i] = new DistanceField(obstacles, cellSize, maxRange);
+    }
+  }
 }
 
 void KdTree::buildObstacleTree() {
-  deleteObstacleTree(obstacleTree_);
+  for (std::size_t i = 0U; i < obstacleTrees_.size(); ++i) {
+    deleteObstacleTree(obstacleTrees_[i]);
+  }
+
+  std::vector<std::vector<Obstacle *> > layerObstacles;
+
+  for (std::size_t i = 0U; i < simulator_->obstacles_.size(); ++i) {
+    Obstacle *const obstacle = simulator_->obstacles_[i];
+
+    if (obstacle->layer_ >= layerObstacles.size()) {
+      layerObstacles.resize(obstacle->layer_ + 1U);
+    }
+
+    layerObstacles[obstacle->layer_].push_back(obstacle);
+  }
+
+  obstacleTrees_.assign(layerObstacles.size(), NULL);
+  std::vector<Obstacle *> newObstacles;
+
+#if RVO_OPENMP_TASKS
+#pragma omp parallel
+#pragma omp single
+#endif /* RVO_OPENMP_TASKS */
+  for (std::size_t i = 0U; i < layerObstacles.size(); ++i) {
+    obstacleTrees_[i] =
+        buildObstacleTreeRecursive(layerObstacles[i], newObstacles);
+  }
+
+  /* Number split obstacles as a serial build would. */
+  numObstacleSplits_ = newObstacles.size();
 
-  const std::vector<Obstacle *> obstacles(simulator_->obstacles_);
-  obstacleTree_ = buildObstacleTreeRecursive(obstacles);
+  for (std::size_t i = 0U; i < newObstacles.size(); ++i) {
+    newObstacles[i]->id_ = simulator_->obstacles_.size();
+    simulator_->obstacles_.push_back(newObstacles[i]);
+  }
+
+  if (!distanceFields_.empty()) {
+    buildDistanceField(distanceFields_.front()->cellSize_,
+                       distanceFields_.front()->maxRange_);
+  }
 }
 
 KdTree::ObstacleTreeNode *KdTree::buildObstacleTreeRecursive(
-    const std::vector<Obstacle *> &obstacles) {
+    const std::vector<Obstacle *> &obstacles,
+    std::vector<Obstacle *> &newObstacles) { /* NOLINT(runtime/references) */
   if (!obstacles.empty()) {
     ObstacleTreeNode *const node = new ObstacleTreeNode();
 
@@ -256,51 +577,44 @@ KdTree::ObstacleTreeNode *KdTree::buildObstacleTreeRecursive(
     std::size_t minLeft = obstacles.size();
     std::size_t minRight = obstacles.size();
 
-    for (std::size_t i = 0U; i < obstacles.size(); ++i) {
-      std::size_t leftSize = 0U;
-      std::size_t rightSize = 0U;
-
-      const Obstacle *const obstacleI1 = obstacles[i];
-      const Obstacle *const obstacleI2 = obstacleI1->next_;
-
-      /* Compute optimal split node. */
-      for (std::size_t j = 0U; j < obstacles.size(); ++j) {
-        if (i != j) {
-          const Obstacle *const obstacleJ1 = obstacles[j];
-          const Obstacle *const obstacleJ2 = obstacleJ1->next_;
+#if RVO_OPENMP_TASKS
+    if (obstacles.size() >= RVO_MIN_PARALLEL_SPLIT_SIZE) {
+      /* Score candidate split edges in chunks, then keep the first optimal
+       * candidate, as the serial loop would. */
+      const std::size_t numChunks = std::min(
+          obstacles.size(), static_cast<std::size_t>(omp_get_num_threads()));
+      std::vector<std::size_t> optimalSplits(numChunks, 0U);
+      std::vector<std::size_t> minLefts(numChunks, obstacles.size());
+      std::vector<std::size_t> minRights(numChunks, obstacles.size());
+
+      for (std::size_t chunk = 0U; chunk < numChunks; ++chunk) {
+#pragma omp task default(shared) firstprivate(chunk)
+        findObstacleSplit(obstacles, chunk * obstacles.size() / numChunks,
+                          (chunk + 1U) * obstacles.size() / numChunks,
+                          optimalSplits[chunk], minLefts[chunk],
+                          minRights[chunk]);
+      }
 
-          const float j1LeftOfI = leftOf(obstacleI1->point_, obstacleI2->point_,
-                                         obstacleJ1->point_);
-          const float j2LeftOfI = leftOf(obstacleI1->point_, obstacleI2->point_,
-                                         obstacleJ2->point_);
+#pragma omp taskwait
 
-          if (j1LeftOfI >= -RVO_EPSILON && j2LeftOfI >= -RVO_EPSILON) {
-            ++leftSize;
-          } else if (j1LeftOfI <= RVO_EPSILON && j2LeftOfI <= RVO_EPSILON) {
-            ++rightSize;
-          } else {
-            ++leftSize;
-            ++rightSize;
-          }
-
-          if (std::make_pair(std::max(leftSize, rightSize),
-                             std::min(leftSize, rightSize)) >=
-              std::make_pair(std::max(minLeft, minRight),
-                             std::min(minLeft, minRight))) {
-            break;
-          }
+      for (std::size_t chunk = 0U; chunk < numChunks; ++chunk) {
+        if (std::make_pair(std::max(minLefts[chunk], minRights[chunk]),
+                           std::min(minLefts[chunk], minRights[chunk])) <
+            std::make_pair(std::max(minLeft, minRight),
+                           std::min(minLeft, minRight))) {
+          minLeft = minLefts[chunk];
+          minRight = minRights[chunk];
+          optimalSplit = optimalSplits[chunk];
         }
       }
-
-      if (std::make_pair(std::max(leftSize, rightSize),
-                         std::min(leftSize, rightSize)) <
-          std::make_pair(std::max(minLeft, minRight),
-                         std::min(minLeft, minRight))) {
-        minLeft = leftSize;
-        minRight = rightSize;
-        optimalSplit = i;
-      }
+    } else {
+      findObstacleSplit(obstacles, 0U, obstacles.size(), optimalSplit, minLeft,
+                        minRight);
     }
+#else
+    findObstacleSplit(obstacles, 0U, obstacles.size(), optimalSplit, minLeft,
+                      minRight);
+#endif /* RVO_OPENMP_TASKS */
 
     /* Build split node. */
     std::vector<Obstacle *> leftObstacles(minLeft);
@@ -338,14 +652,17 @@ KdTree::ObstacleTreeNode *KdTree::buildObstacleTreeRecursive(
               obstacleJ1->point_ +
               t * (obstacleJ2->point_ - obstacleJ1->point_);
 
+          /* Each edge belongs to a single subtree, so splitting it only
+           * touches obstacles owned by this call. */
           Obstacle *const newObstacle = new Obstacle();
           newObstacle->direction_ = obstacleJ1->direction_;
           newObstacle->point_ = splitPoint;
           newObstacle->next_ = obstacleJ2;
           newObstacle->previous_ = obstacleJ1;
-          newObstacle->id_ = simulator_->obstacles_.size();
           newObstacle->isConvex_ = true;
-          simulator_->obstacles_.push_back(newObstacle);
+          newObstacle->isSplit_ = true;
+          newObstacle->layer_ = obstacleJ1->layer_;
+          newObstacles.push_back(newObstacle);
 
           obstacleJ1->next_ = newObstacle;
           obstacleJ2->previous_ = newObstacle;
@@ -362,8 +679,28 @@ KdTree::ObstacleTreeNode *KdTree::buildObstacleTreeRecursive(
     }
 
     node->obstacle = obstacleI1;
-    node->left = buildObstacleTreeRecursive(leftObstacles);
-    node->right = buildObstacleTreeRecursive(rightObstacles);
+
+    std::vector<Obstacle *> leftNewObstacles;
+    std::vector<Obstacle *> rightNewObstacles;
+
+#if RVO_OPENMP_TASKS
+#pragma omp task default(shared) if (leftObstacles.size() >= \
+                                         RVO_MIN_OBSTACLE_TASK_SIZE)
+#endif /* RVO_OPENMP_TASKS */
+    node->left = buildObstacleTreeRecursive(leftObstacles, leftNewObstacles);
+#if RVO_OPENMP_TASKS
+#pragma omp task default(shared) if (rightObstacles.size() >= \
+                                         RVO_MIN_OBSTACLE_TASK_SIZE)
+#endif /* RVO_OPENMP_TASKS */
+    node->right = buildObstacleTreeRecursive(rightObstacles, rightNewObstacles);
+#if RVO_OPENMP_TASKS
+#pragma omp taskwait
+#endif /* RVO_OPENMP_TASKS */
+
+    newObstacles.insert(newObstacles.end(), leftNewObstacles.begin(),
+                        leftNewObstacles.end());
+    newObstacles.insert(newObstacles.end(), rightNewObstacles.begin(),
+                        rightNewObstacles.end());
 
     return node;
   }
@@ -371,12 +708,173 @@ KdTree::ObstacleTreeNode *KdTree::buildObstacleTreeRecursive(
   return NULL;
 }
 
+void KdTree::collectObstacleTreeRecursive(
+    std::vector<const Obstacle *> &obstacles,
+    const ObstacleTreeNode *node) const {
+  if (node != NULL) {
+    obstacles.push_back(node->obstacle);
+    collectObstacleTreeRecursive(obstacles, node->left);
+    collectObstacleTreeRecursive(obstacles, node->right);
+  }
+}
+
+void KdTree::computeAgentClearance(const Agent *agent, float maxRadius,
+                                   float &clearance,
+                                   std::size_t &numPenetrations,
+                                   float &penetrationDepth) const {
+  /* The agent belongs to the subtree of its own layer. */
+  queryAgentClearanceRecursive(agent, maxRadius, clearance, numPenetrations,
+                               penetrationDepth,
+                               agentTreeRoots_[agent->layer_]);
+}
+
+float KdTree::computeAgentDensity(const Agent *agent) const {
+  std::size_t node = agentTreeRoots_[agent->layer_];
+
+  /* Descend towards the agent while the child containing it is populated
+   * enough to give a meaningful estimate. */
+  while (agentTree_[node].end - agentTree_[node].begin > RVO_MAX_LEAF_SIZE) {
+    const AgentTreeNode &left = agentTree_[agentTree_[node].left];
+    const bool isInLeft = agent->position_.x() >= left.minX &&
+                          agent->position_.x() <= left.maxX &&
+                          agent->position_.y() >= left.minY &&
+                          agent->position_.y() <= left.maxY;
+    const std::size_t child =
+        isInLeft ? agentTree_[node].left : agentTree_[node].right;
+
+    if (agentTree_[child].end - agentTree_[child].begin <
+        adaptiveNeighborCount_) {
+      break;
+    }
+
+    node = child;
+  }
+
+  /* Pad the bounding box by the radius of the agent so that the area of a
+   * node whose agents are collinear is not zero. */
+  const AgentTreeNode &treeNode = agentTree_[node];
+  const float area =
+      (treeNode.maxX - treeNode.minX + 2.0F * agent->radius_) *
+      (treeNode.maxY - treeNode.minY + 2.0F * agent->radius_);
+
+  return area > 0.0F ? static_cast<float>(treeNode.end - treeNode.begin) / area
+                     : 0.0F;
+}
+
 void KdTree::computeAgentNeighbors(Agent *agent, float &rangeSq) const {
-  queryAgentTreeRecursive(agent, rangeSq, 0U);
+  /* The agent belongs to the subtree of its own layer. */
+  queryAgentTreeRecursive(agent, rangeSq, agentTreeRoots_[agent->layer_]);
+}
+
+void KdTree::computeBoxObstacleNeighbors(Agent *agent, float rangeSq) const {
+  if (agent->layer_ < boxObstacleTreeRoots_.size() &&
+      boxObstacleTreeRoots_[agent->layer_] != RVO_ERROR) {
+    queryBoxObstacleTreeRecursive(agent, rangeSq,
+                                  boxObstacleTreeRoots_[agent->layer_]);
+  }
+}
+
+void KdTree::computeNearestBoxObstacle(
+    const Vector2 &point, std::size_t layer, float &distSq,
+    const BoxObstacle *&boxObstacle) const {
+  if (layer < boxObstacleTreeRoots_.size() &&
+      boxObstacleTreeRoots_[layer] != RVO_ERROR) {
+    queryNearestBoxObstacleRecursive(point, distSq, boxObstacle,
+                                     boxObstacleTreeRoots_[layer]);
+  }
+}
+
+void KdTree::computeNearestObstacle(const Vector2 &point, std::size_t layer,
+                                    float &distSq,
+                                    const Obstacle *&obstacle) const {
+  queryNearestObstacleRecursive(point, distSq, obstacle,
+                                getObstacleTree(layer));
 }
 
 void KdTree::computeObstacleNeighbors(Agent *agent, float rangeSq) const {
-  queryObstacleTreeRecursive(agent, rangeSq, obstacleTree_);
+  const DistanceField *const distanceField =
+      agent->layer_ < distanceFields_.size() ? distanceFields_[agent->layer_]
+                                             : NULL;
+
+  if (distanceField != NULL &&
+      rangeSq <= distanceField->maxRange_ * distanceField->maxRange_) {
+    /* Obstacle edges farther than the maximum range of the distance field
+     * from a cell are never stored with the cell. */
+    const std::size_t cell = distanceField->getCell(agent->position_);
+
+    if (cell != RVO_ERROR && distanceField->cellDistances_[cell] *
+                                     distanceField->cellDistances_[cell] <
+                                 rangeSq) {
+      for (std::size_t i = distanceField->cellBegins_[cell];
+           i < distanceField->cellBegins_[cell + 1U]; ++i) {
+        const Obstacle *const obstacle1 = distanceField->cellObstacles_[i];
+        const Obstacle *const obstacle2 = obstacle1->next_;
+
+        ++agent->numObstacleEdgesTested_;
+
+        if (leftOf(obstacle1->point_, obstacle2->point_, agent->position_) <
+            0.0F) {
+          agent->insertObstacleNeighbor(obstacle1, rangeSq);
+        }
+      }
+    }
+
+    return;
+  }
+
+  queryObstacleTreeRecursive(agent, rangeSq, getObstacleTree(agent->layer_));
+}
+
+void KdTree::computeObstacleTreeStats(std::size_t &numNodes, std::size_t &depth,
+                                      std::size_t &sumDepth) const {
+  numNodes = 0U;
+  depth = 0U;
+  sumDepth = 0U;
+
+  for (std::size_t i = 0U; i < obstacleTrees_.size(); ++i) {
+    computeObstacleTreeStatsRecursive(obstacleTrees_[i], 1U, numNodes, depth,
+                                      sumDepth);
+  }
+}
+
+void KdTree::computeObstacleTreeStatsRecursive(const ObstacleTreeNode *node,
+                                               std::size_t depth,
+                                               std::size_t &numNodes,
+                                               std::size_t &maxDepth,
+                                               std::size_t &sumDepth) const {
+  if (node != NULL) {
+    ++numNodes;
+    maxDepth = std::max(maxDepth, depth);
+    sumDepth += depth;
+
+    computeObstacleTreeStatsRecursive(node->left, depth + 1U, numNodes,
+                                      maxDepth, sumDepth);
+    computeObstacleTreeStatsRecursive(node->right, depth + 1U, numNodes,
+                                      maxDepth, sumDepth);
+  }
+}
+
+void KdTree::computePointNeighbors(
+    const Vector2 &point, std::size_t layer, std::size_t maxAgents,
+    float &rangeSq, std::vector<std::pair<float, std::size_t> > &agents) const {
+  agents.clear();
+
+  if (layer < agentTreeRoots_.size() && agentTreeRoots_[layer] != RVO_ERROR &&
+      maxAgents > 0U) {
+    queryPointTreeRecursive(point, maxAgents, rangeSq, agents,
+                            agentTreeRoots_[layer]);
+
+    if (maxAgents == std::numeric_limits<std::size_t>::max()) {
+      std::sort(agents.begin(), agents.end());
+    }
+  }
+}
+
+void KdTree::computeRaycast(const Vector2 &origin, const Vector2 &direction,
+                            std::size_t layer, float &distance,
+                            const Obstacle *&obstacle) const {
+  queryRaycastRecursive(origin, direction, distance, obstacle,
+                        getObstacleTree(layer));
 }
 
 void KdTree::deleteObstacleTree(ObstacleTreeNode *node) {
@@ -387,12 +885,173 @@ void KdTree::deleteObstacleTree(ObstacleTreeNode *node) {
   }
 }
 
+void KdTree::findObstacleSplit(
+    const std::vector<Obstacle *> &obstacles, std::size_t begin,
+    std::size_t end,
+    std::size_t &optimalSplit, /* NOLINT(runtime/references) */
+    std::size_t &minLeft,      /* NOLINT(runtime/references) */
+    std::size_t &minRight) const { /* NOLINT(runtime/references) */
+  for (std::size_t i = begin; i < end; ++i) {
+    std::size_t leftSize = 0U;
+    std::size_t rightSize = 0U;
+
+    const Obstacle *const obstacleI1 = obstacles[i];
+    const Obstacle *const obstacleI2 = obstacleI1->next_;
+
+    /* Compute optimal split node. */
+    for (std::size_t j = 0U; j < obstacles.size(); ++j) {
+      if (i != j) {
+        const Obstacle *const obstacleJ1 = obstacles[j];
+        const Obstacle *const obstacleJ2 = obstacleJ1->next_;
+
+        const float j1LeftOfI =
+            leftOf(obstacleI1->point_, obstacleI2->point_, obstacleJ1->point_);
+        const float j2LeftOfI =
+            leftOf(obstacleI1->point_, obstacleI2->point_, obstacleJ2->point_);
+
+        if (j1LeftOfI >= -RVO_EPSILON && j2LeftOfI >= -RVO_EPSILON) {
+          ++leftSize;
+        } else if (j1LeftOfI <= RVO_EPSILON && j2LeftOfI <= RVO_EPSILON) {
+          ++rightSize;
+        } else {
+          ++leftSize;
+          ++rightSize;
+        }
+
+        if (std::make_pair(std::max(leftSize, rightSize),
+                           std::min(leftSize, rightSize)) >=
+            std::make_pair(std::max(minLeft, minRight),
+                           std::min(minLeft, minRight))) {
+          break;
+        }
+      }
+    }
+
+    if (std::make_pair(std::max(leftSize, rightSize),
+                       std::min(leftSize, rightSize)) <
+        std::make_pair(std::max(minLeft, minRight),
+                       std::min(minLeft, minRight))) {
+      minLeft = leftSize;
+      minRight = rightSize;
+      optimalSplit = i;
+    }
+  }
+}
+
+const KdTree::ObstacleTreeNode *KdTree::getObstacleTree(
+    std::size_t layer) const {
+  return layer < obstacleTrees_.size() ? obstacleTrees_[layer] : NULL;
+}
+
+bool KdTree::isInsideObstacle(const Vector2 &point, std::size_t layer) const {
+  const ObstacleTreeNode *node = getObstacleTree(layer);
+  bool isInside = false;
+
+  /* The leaf reached by the point is inside if it lies to the left of the
+   * edge of its parent node. */
+  while (node != NULL) {
+    const Obstacle *const obstacle1 = node->obstacle;
+    const Obstacle *const obstacle2 = obstacle1->next_;
+
+    isInside = leftOf(obstacle1->point_, obstacle2->point_, point) >= 0.0F;
+    node = isInside ? node->left : node->right;
+  }
+
+  return isInside;
+}
+
+void KdTree::queryAgentClearanceRecursive(const Agent *agent, float maxRadius,
+                                          float &clearance,
+                                          std::size_t &numPenetrations,
+                                          float &penetrationDepth,
+                                          std::size_t node) const {
+  if (agentTree_[node].end - agentTree_[node].begin <= RVO_MAX_LEAF_SIZE) {
+    for (std::size_t i = agentTree_[node].begin; i < agentTree_[node].end;
+         ++i) {
+      const Agent *const other = agents_[i];
+
+      if (other == agent ||
+          ((other->collisionGroups_ & agent->collisionMask_) == 0U &&
+           (agent->collisionGroups_ & other->collisionMask_) == 0U)) {
+        continue;
+      }
+
+      const float combinedRange =
+          agent->radius_ + other->radius_ + std::max(clearance, 0.0F);
+      const float distSq = absSq(other->position_ - agent->position_);
+
+      if (distSq < combinedRange * combinedRange) {
+        const float distance =
+            std::sqrt(distSq) - agent->radius_ - other->radius_;
+        clearance = std::min(clearance, distance);
+
+        /* Count each pair of agents once. */
+        if (distance < 0.0F && agent->id_ < other->id_) {
+          ++numPenetrations;
+          penetrationDepth -= distance;
+        }
+      }
+    }
+  } else {
+    const std::size_t left = agentTree_[node].left;
+    const std::size_t right = agentTree_[node].right;
+    const float distSqLeft =
+        distSqBoxPoint(Vector2(agentTree_[left].minX, agentTree_[left].minY),
+                       Vector2(agentTree_[left].maxX, agentTree_[left].maxY),
+                       agent->position_);
+    const float distSqRight =
+        distSqBoxPoint(Vector2(agentTree_[right].minX, agentTree_[right].minY),
+                       Vector2(agentTree_[right].maxX, agentTree_[right].maxY),
+                       agent->position_);
+    const std::size_t nearer = distSqLeft < distSqRight ? left : right;
+    const std::size_t farther = distSqLeft < distSqRight ? right : left;
+
+    /* A node may hold an agent penetrated by the agent, or one closer than
+     * the clearance found so far. */
+    float range = agent->radius_ + maxRadius + std::max(clearance, 0.0F);
+
+    if (std::min(distSqLeft, distSqRight) < range * range) {
+      queryAgentClearanceRecursive(agent, maxRadius, clearance,
+                                   numPenetrations, penetrationDepth, nearer);
+      range = agent->radius_ + maxRadius + std::max(clearance, 0.0F);
+
+      if (std::max(distSqLeft, distSqRight) < range * range) {
+        queryAgentClearanceRecursive(agent, maxRadius, clearance,
+                                     numPenetrations, penetrationDepth,
+                                     farther);
+      }
+    }
+  }
+}
+
 void KdTree::queryAgentTreeRecursive(Agent *agent, float &rangeSq,
                                      std::size_t node) const {
+  if ((agentTree_[node].collisionGroups & agent->collisionMask_) == 0U) {
+    /* No agent in the node is avoided by the agent. */
+    return;
+  }
+
+  if (clusterProxyRatio_ > 0.0F &&
+      agentTree_[node].end - agentTree_[node].begin > 1U &&
+      (agentTree_[node].collisionGroups & ~agent->collisionMask_) == 0U) {
+    /* Avoid the agents in the node as a single moving disk if the node is
+     * small as seen from the agent. The agent is never inside such a node. */
+    const ClusterProxy &clusterProxy = clusterProxies_[node];
+    const float distSq = absSq(agent->position_ - clusterProxy.position_);
+
+    if (clusterProxy.radius_ * clusterProxy.radius_ <
+        clusterProxyRatio_ * clusterProxyRatio_ * distSq) {
+      agent->insertClusterNeighbor(&clusterProxy, distSq);
+      return;
+    }
+  }
+
   if (agentTree_[node].end - agentTree_[node].begin <= RVO_MAX_LEAF_SIZE) {
     for (std::size_t i = agentTree_[node].begin; i < agentTree_[node].end;
          ++i) {
-      agent->insertAgentNeighbor(agents_[i], rangeSq);
+      if ((agents_[i]->collisionGroups_ & agent->collisionMask_) != 0U) {
+        agent->insertAgentNeighbor(agents_[i], rangeSq);
+      }
     }
   } else {
     const float distLeftMinX = std::max(
@@ -439,12 +1098,163 @@ void KdTree::queryAgentTreeRecursive(Agent *agent, float &rangeSq,
   }
 }
 
+void KdTree::queryBoxObstacleTreeRecursive(Agent *agent, float rangeSq,
+                                           std::size_t node) const {
+  if (boxObstacleTree_[node].end - boxObstacleTree_[node].begin <=
+      RVO_MAX_LEAF_SIZE) {
+    for (std::size_t i = boxObstacleTree_[node].begin;
+         i < boxObstacleTree_[node].end; ++i) {
+      agent->insertBoxObstacleNeighbor(&boxObstacles_[i], rangeSq);
+    }
+  } else {
+    const AgentTreeNode &left = boxObstacleTree_[boxObstacleTree_[node].left];
+    const AgentTreeNode &right = boxObstacleTree_[boxObstacleTree_[node].right];
+
+    if (distSqBoxPoint(Vector2(left.minX, left.minY),
+                       Vector2(left.maxX, left.maxY),
+                       agent->position_) < rangeSq) {
+      queryBoxObstacleTreeRecursive(agent, rangeSq,
+                                    boxObstacleTree_[node].left);
+    }
+
+    if (distSqBoxPoint(Vector2(right.minX, right.minY),
+                       Vector2(right.maxX, right.maxY),
+                       agent->position_) < rangeSq) {
+      queryBoxObstacleTreeRecursive(agent, rangeSq,
+                                    boxObstacleTree_[node].right);
+    }
+  }
+}
+
+bool KdTree::queryBoxObstacleVisibilityRecursive(
+    const Vector2 &vector1, const Vector2 &vector2, float radius,
+    std::size_t node, std::size_t &numNodesVisited) const {
+  ++numNodesVisited;
+
+  /* Visible if the segment keeps at least the radius from the node and does
+   * not touch it. */
+  const float distSqNode = distSqBoxLineSegment(
+      Vector2(boxObstacleTree_[node].minX, boxObstacleTree_[node].minY),
+      Vector2(boxObstacleTree_[node].maxX, boxObstacleTree_[node].maxY),
+      vector1, vector2);
+
+  if (distSqNode > 0.0F && distSqNode >= radius * radius) {
+    return true;
+  }
+
+  if (boxObstacleTree_[node].end - boxObstacleTree_[node].begin <=
+      RVO_MAX_LEAF_SIZE) {
+    for (std::size_t i = boxObstacleTree_[node].begin;
+         i < boxObstacleTree_[node].end; ++i) {
+      const float distSq =
+          distSqBoxLineSegment(boxObstacles_[i].minCorner_,
+                               boxObstacles_[i].maxCorner_, vector1, vector2);
+
+      if (distSq == 0.0F || distSq < radius * radius) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  return queryBoxObstacleVisibilityRecursive(vector1, vector2, radius,
+                                             boxObstacleTree_[node].left,
+                                             numNodesVisited) &&
+         queryBoxObstacleVisibilityRecursive(vector1, vector2, radius,
+                                             boxObstacleTree_[node].right,
+                                             numNodesVisited);
+}
+
+void KdTree::queryNearestBoxObstacleRecursive(
+    const Vector2 &point, float &distSq, const BoxObstacle *&boxObstacle,
+    std::size_t node) const {
+  if (boxObstacleTree_[node].end - boxObstacleTree_[node].begin <=
+      RVO_MAX_LEAF_SIZE) {
+    for (std::size_t i = boxObstacleTree_[node].begin;
+         i < boxObstacleTree_[node].end; ++i) {
+      const float distSqBox = distSqBoxPoint(
+          boxObstacles_[i].minCorner_, boxObstacles_[i].maxCorner_, point);
+
+      if (distSqBox < distSq) {
+        distSq = distSqBox;
+        boxObstacle = &boxObstacles_[i];
+      }
+    }
+  } else {
+    const AgentTreeNode &left = boxObstacleTree_[boxObstacleTree_[node].left];
+    const AgentTreeNode &right = boxObstacleTree_[boxObstacleTree_[node].right];
+    const float distSqLeft = distSqBoxPoint(
+        Vector2(left.minX, left.minY), Vector2(left.maxX, left.maxY), point);
+    const float distSqRight =
+        distSqBoxPoint(Vector2(right.minX, right.minY),
+                       Vector2(right.maxX, right.maxY), point);
+
+    if (distSqLeft < distSqRight) {
+      if (distSqLeft < distSq) {
+        queryNearestBoxObstacleRecursive(point, distSq, boxObstacle,
+                                         boxObstacleTree_[node].left);
+
+        if (distSqRight < distSq) {
+          queryNearestBoxObstacleRecursive(point, distSq, boxObstacle,
+                                           boxObstacleTree_[node].right);
+        }
+      }
+    } else if (distSqRight < distSq) {
+      queryNearestBoxObstacleRecursive(point, distSq, boxObstacle,
+                                       boxObstacleTree_[node].right);
+
+      if (distSqLeft < distSq) {
+        queryNearestBoxObstacleRecursive(point, distSq, boxObstacle,
+                                         boxObstacleTree_[node].left);
+      }
+    }
+  }
+}
+
+void KdTree::queryNearestObstacleRecursive(
+    const Vector2 &point, float &distSq, const Obstacle *&obstacle,
+    const ObstacleTreeNode *node) const {
+  if (node != NULL) {
+    const Obstacle *const obstacle1 = node->obstacle;
+    const Obstacle *const obstacle2 = obstacle1->next_;
+
+    const float pointLeftOfLine =
+        leftOf(obstacle1->point_, obstacle2->point_, point);
+
+    queryNearestObstacleRecursive(
+        point, distSq, obstacle,
+        pointLeftOfLine >= 0.0F ? node->left : node->right);
+
+    const float distSqLine = pointLeftOfLine * pointLeftOfLine /
+                             absSq(obstacle2->point_ - obstacle1->point_);
+
+    if (distSqLine < distSq) {
+      /* Unlike obstacle neighbors, both sides of an edge are considered. */
+      const float distSqEdge =
+          distSqPointLineSegment(obstacle1->point_, obstacle2->point_, point);
+
+      if (distSqEdge < distSq) {
+        distSq = distSqEdge;
+        obstacle = obstacle1;
+      }
+
+      /* Try other side of line. */
+      queryNearestObstacleRecursive(
+          point, distSq, obstacle,
+          pointLeftOfLine >= 0.0F ? node->right : node->left);
+    }
+  }
+}
+
 void KdTree::queryObstacleTreeRecursive(Agent *agent, float rangeSq,
                                         const ObstacleTreeNode *node) const {
   if (node != NULL) {
     const Obstacle *const obstacle1 = node->obstacle;
     const Obstacle *const obstacle2 = obstacle1->next_;
 
+    ++agent->numObstacleTreeNodesVisited_;
+
     const float agentLeftOfLine =
         leftOf(obstacle1->point_, obstacle2->point_, agent->position_);
 
@@ -468,15 +1278,145 @@ void KdTree::queryObstacleTreeRecursive(Agent *agent, float rangeSq,
   }
 }
 
+void KdTree::queryPointTreeRecursive(
+    const Vector2 &point, std::size_t maxAgents, float &rangeSq,
+    std::vector<std::pair<float, std::size_t> > &agents,
+    std::size_t node) const {
+  if (agentTree_[node].end - agentTree_[node].begin <= RVO_MAX_LEAF_SIZE) {
+    for (std::size_t i = agentTree_[node].begin; i < agentTree_[node].end;
+         ++i) {
+      const float distSq = absSq(point - agents_[i]->position_);
+
+      if (distSq < rangeSq) {
+        if (maxAgents == std::numeric_limits<std::size_t>::max()) {
+          /* Unbounded range query; sorted once the query completes. */
+          agents.push_back(std::make_pair(distSq, agents_[i]->id_));
+          continue;
+        }
+
+        if (agents.size() < maxAgents) {
+          agents.push_back(std::make_pair(distSq, agents_[i]->id_));
+        }
+
+        std::size_t j = agents.size() - 1U;
+
+        while (j != 0U && distSq < agents[j - 1U].first) {
+          agents[j] = agents[j - 1U];
+          --j;
+        }
+
+        agents[j] = std::make_pair(distSq, agents_[i]->id_);
+
+        if (agents.size() == maxAgents) {
+          rangeSq = agents.back().first;
+        }
+      }
+    }
+  } else {
+    const AgentTreeNode &left = agentTree_[agentTree_[node].left];
+    const AgentTreeNode &right = agentTree_[agentTree_[node].right];
+
+    const float distLeftX = std::max(
+        0.0F, std::max(left.minX - point.x(), point.x() - left.maxX));
+    const float distLeftY = std::max(
+        0.0F, std::max(left.minY - point.y(), point.y() - left.maxY));
+    const float distSqLeft = distLeftX * distLeftX + distLeftY * distLeftY;
+
+    const float distRightX = std::max(
+        0.0F, std::max(right.minX - point.x(), point.x() - right.maxX));
+    const float distRightY = std::max(
+        0.0F, std::max(right.minY - point.y(), point.y() - right.maxY));
+    const float distSqRight =
+        distRightX * distRightX + distRightY * distRightY;
+
+    if (distSqLeft < distSqRight) {
+      if (distSqLeft < rangeSq) {
+        queryPointTreeRecursive(point, maxAgents, rangeSq, agents,
+                                agentTree_[node].left);
+
+        if (distSqRight < rangeSq) {
+          queryPointTreeRecursive(point, maxAgents, rangeSq, agents,
+                                  agentTree_[node].right);
+        }
+      }
+    } else if (distSqRight < rangeSq) {
+      queryPointTreeRecursive(point, maxAgents, rangeSq, agents,
+                              agentTree_[node].right);
+
+      if (distSqLeft < rangeSq) {
+        queryPointTreeRecursive(point, maxAgents, rangeSq, agents,
+                                agentTree_[node].left);
+      }
+    }
+  }
+}
+
+void KdTree::queryRaycastRecursive(const Vector2 &origin,
+                                   const Vector2 &direction, float &distance,
+                                   const Obstacle *&obstacle,
+                                   const ObstacleTreeNode *node) const {
+  if (node != NULL) {
+    const Obstacle *const obstacle1 = node->obstacle;
+    const Obstacle *const obstacle2 = obstacle1->next_;
+
+    const float originLeftOfLine =
+        leftOf(obstacle1->point_, obstacle2->point_, origin);
+
+    /* Search the side of the origin first, which may shorten the ray. */
+    queryRaycastRecursive(
+        origin, direction, distance, obstacle,
+        originLeftOfLine >= 0.0F ? node->left : node->right);
+
+    const Vector2 obstacleVector = obstacle2->point_ - obstacle1->point_;
+    const float denominator = det(direction, obstacleVector);
+
+    /* Distance along the ray to the line of the obstacle at this node, which
+     * is compared with the distance rather than testing the side of the end
+     * of the ray so that an infinite distance is handled. */
+    const float t = denominator != 0.0F
+                        ? originLeftOfLine / denominator
+                        : std::numeric_limits<float>::infinity();
+
+    if (std::fabs(originLeftOfLine) <= RVO_EPSILON ||
+        (t >= 0.0F && t <= distance)) {
+      /* Ray reaches line of obstacle at this node. */
+      if (std::fabs(denominator) > RVO_EPSILON) {
+        const float s =
+            det(obstacle1->point_ - origin, direction) / denominator;
+
+        if (t >= 0.0F && t < distance && s >= 0.0F && s <= 1.0F) {
+          distance = t;
+          obstacle = obstacle1;
+        }
+      }
+
+      /* Try other side of line. */
+      queryRaycastRecursive(
+          origin, direction, distance, obstacle,
+          originLeftOfLine >= 0.0F ? node->right : node->left);
+    }
+  }
+}
+
 bool KdTree::queryVisibility(const Vector2 &vector1, const Vector2 &vector2,
-                             float radius) const {
-  return queryVisibilityRecursive(vector1, vector2, radius, obstacleTree_);
+                             float radius, std::size_t layer,
+                             std::size_t &numNodesVisited) const {
+  return queryVisibilityRecursive(vector1, vector2, radius,
+                                  getObstacleTree(layer), numNodesVisited) &&
+         (layer >= boxObstacleTreeRoots_.size() ||
+          boxObstacleTreeRoots_[layer] == RVO_ERROR ||
+          queryBoxObstacleVisibilityRecursive(vector1, vector2, radius,
+                                              boxObstacleTreeRoots_[layer],
+                                              numNodesVisited));
 }
 
 bool KdTree::queryVisibilityRecursive(const Vector2 &vector1,
                                       const Vector2 &vector2, float radius,
-                                      const ObstacleTreeNode *node) const {
+                                      const ObstacleTreeNode *node,
+                                      std::size_t &numNodesVisited) const {
   if (node != NULL) {
+    ++numNodesVisited;
+
     const Obstacle *const obstacle1 = node->obstacle;
     const Obstacle *const obstacle2 = obstacle1->next_;
 
@@ -488,23 +1428,29 @@ bool KdTree::queryVisibilityRecursive(const Vector2 &vector1,
         1.0F / absSq(obstacle2->point_ - obstacle1->point_);
 
     if (q1LeftOfI >= 0.0F && q2LeftOfI >= 0.0F) {
-      return queryVisibilityRecursive(vector1, vector2, radius, node->left) &&
+      return queryVisibilityRecursive(vector1, vector2, radius, node->left,
+                                      numNodesVisited) &&
              ((q1LeftOfI * q1LeftOfI * invLengthI >= radius * radius &&
                q2LeftOfI * q2LeftOfI * invLengthI >= radius * radius) ||
-              queryVisibilityRecursive(vector1, vector2, radius, node->right));
+              queryVisibilityRecursive(vector1, vector2, radius, node->right,
+                                       numNodesVisited));
     }
 
     if (q1LeftOfI <= 0.0F && q2LeftOfI <= 0.0F) {
-      return queryVisibilityRecursive(vector1, vector2, radius, node->right) &&
+      return queryVisibilityRecursive(vector1, vector2, radius, node->right,
+                                      numNodesVisited) &&
              ((q1LeftOfI * q1LeftOfI * invLengthI >= radius * radius &&
                q2LeftOfI * q2LeftOfI * invLengthI >= radius * radius) ||
-              queryVisibilityRecursive(vector1, vector2, radius, node->left));
+              queryVisibilityRecursive(vector1, vector2, radius, node->left,
+                                       numNodesVisited));
     }
 
     if (q1LeftOfI >= 0.0F && q2LeftOfI <= 0.0F) {
       /* One can see through obstacle from left to right. */
-      return queryVisibilityRecursive(vector1, vector2, radius, node->left) &&
-             queryVisibilityRecursive(vector1, vector2, radius, node->right);
+      return queryVisibilityRecursive(vector1, vector2, radius, node->left,
+                                      numNodesVisited) &&
+             queryVisibilityRecursive(vector1, vector2, radius, node->right,
+                                      numNodesVisited);
     }
 
     const float point1LeftOfQ = leftOf(vector1, vector2, obstacle1->point_);
@@ -514,10 +1460,47 @@ bool KdTree::queryVisibilityRecursive(const Vector2 &vector1,
     return point1LeftOfQ * point2LeftOfQ >= 0.0F &&
            point1LeftOfQ * point1LeftOfQ * invLengthQ > radius * radius &&
            point2LeftOfQ * point2LeftOfQ * invLengthQ > radius * radius &&
-           queryVisibilityRecursive(vector1, vector2, radius, node->left) &&
-           queryVisibilityRecursive(vector1, vector2, radius, node->right);
+           queryVisibilityRecursive(vector1, vector2, radius, node->left,
+                                    numNodesVisited) &&
+           queryVisibilityRecursive(vector1, vector2, radius, node->right,
+                                    numNodesVisited);
   }
 
   return true;
 }
+
+void KdTree::refitAgentTree() {
+  for (std::size_t i = 0U; i < agentTreeRoots_.size(); ++i) {
+    if (agentTreeRoots_[i] != RVO_ERROR) {
+      refitAgentTreeRecursive(agentTreeRoots_[i]);
+    }
+  }
+}
+
+void KdTree::refitAgentTreeRecursive(std::size_t node) {
+  AgentTreeNode &treeNode = agentTree_[node];
+
+  if (treeNode.end - treeNode.begin <= RVO_MAX_LEAF_SIZE) {
+    treeNode.minX = treeNode.maxX = agents_[treeNode.begin]->position_.x();
+    treeNode.minY = treeNode.maxY = agents_[treeNode.begin]->position_.y();
+
+    for (std::size_t i = treeNode.begin + 1U; i < treeNode.end; ++i) {
+      treeNode.maxX = std::max(treeNode.maxX, agents_[i]->position_.x());
+      treeNode.minX = std::min(treeNode.minX, agents_[i]->position_.x());
+      treeNode.maxY = std::max(treeNode.maxY, agents_[i]->position_.y());
+      treeNode.minY = std::min(treeNode.minY, agents_[i]->position_.y());
+    }
+  } else {
+    refitAgentTreeRecursive(treeNode.left);
+    refitAgentTreeRecursive(treeNode.right);
+
+    const AgentTreeNode &left = agentTree_[treeNode.left];
+    const AgentTreeNode &right = agentTree_[treeNode.right];
+
+    treeNode.maxX = std::max(left.maxX, right.maxX);
+    treeNode.minX = std::min(left.minX, right.minX);
+    treeNode.maxY = std::max(left.maxY, right.maxY);
+    treeNode.minY = std::min(left.minY, right.minY);
+  }
+}
 } /* namespace RVO */
@@ -40,10 +40,15 @@
  */
 
 #include <cstddef>
+#include <utility>
 #include <vector>
 
+#include "BoxObstacle.h"
+#include "ClusterProxy.h"
+
 namespace RVO {
 class Agent;
+class DistanceField;
 class Obstacle;
 class RVOSimulator;
 class Vector2;
@@ -68,7 +73,7 @@ class KdTree {
   ~KdTree();
 
   /**
-   * @brief Builds an agent k-D tree.
+   * @brief Builds an agent k-D tree for each layer.
    */
   void buildAgentTree();
 
@@ -82,20 +87,100 @@ class KdTree {
                                std::size_t node);
 
   /**
-   * @brief Builds an obstacle k-D tree.
+   * @brief Builds a box obstacle k-D tree for each layer, reordering the box
+   *        obstacles in place so that each node covers a contiguous range.
+   */
+  void buildBoxObstacleTree();
+
+  /**
+   * @brief     Recursive function to build a box obstacle k-D tree.
+   * @param[in] begin The beginning box obstacle k-D tree node number.
+   * @param[in] end   The ending box obstacle k-D tree node number.
+   * @param[in] node  The current box obstacle k-D tree node number.
+   */
+  void buildBoxObstacleTreeRecursive(std::size_t begin, std::size_t end,
+                                     std::size_t node);
+
+  /**
+   * @brief     Builds the cluster proxy of an agent k-D tree node from the
+   *            agents of a leaf node or the cluster proxies of the children of
+   *            an inner node.
+   * @param[in] node The agent k-D tree node.
+   */
+  void buildClusterProxy(std::size_t node);
+
+  /**
+   * @brief     Builds a distance field over the obstacles in the obstacle k-D
+   *            tree of each layer, replacing any previous distance fields.
+   * @param[in] cellSize The width and height of a cell of the distance field.
+   *                     The distance field is removed when not positive.
+   * @param[in] maxRange The maximum range within which obstacle edges are
+   *                     stored with each cell. The distance field is removed
+   *                     when not positive.
+   */
+  void buildDistanceField(float cellSize, float maxRange);
+
+  /**
+   * @brief Builds an obstacle k-D tree for each layer.
    */
   void buildObstacleTree();
 
   /**
-   * @brief     Recursive function to build an obstacle k-D tree.
-   * @param[in] obstacles List of obstacles from which to build the obstacle k-D
-   *                      tree.
+   * @brief          Recursive function to build an obstacle k-D tree.
+   * @param[in]      obstacles    List of obstacles from which to build the
+   *                              obstacle k-D tree.
+   * @param[in, out] newObstacles The obstacles created by splitting edges, in
+   *                              the order in which a serial depth-first build
+   *                              would create them.
    */
   ObstacleTreeNode *buildObstacleTreeRecursive(
-      const std::vector<Obstacle *> &obstacles);
+      const std::vector<Obstacle *> &obstacles,
+      std::vector<Obstacle *> &newObstacles); /* NOLINT(runtime/references) */
+
+  /**
+   * @brief          Recursive function to collect the obstacles in an obstacle
+   *                 k-D tree.
+   * @param[in, out] obstacles The obstacles collected.
+   * @param[in]      node      The current obstacle k-D tree node.
+   */
+  void collectObstacleTreeRecursive(
+      std::vector<const Obstacle *> &obstacles, /* NOLINT(runtime/references) */
+      const ObstacleTreeNode *node) const;
 
   /**
-   * @brief     Computes the agent neighbors of the specified agent.
+   * @brief          Computes the clearance of the specified agent to the other
+   *                 agents on its layer, and the agents it penetrates. Agents
+   *                 that avoid neither each other are skipped.
+   * @param[in]      agent            A pointer to the agent for which the
+   *                                  clearance is to be computed.
+   * @param[in]      maxRadius        The maximum radius of the agents.
+   * @param[in, out] clearance        The minimum distance between the agent
+   *                                  and another agent found, negative if they
+   *                                  overlap.
+   * @param[in, out] numPenetrations  The count of agents with greater numbers
+   *                                  that the agent penetrates.
+   * @param[in, out] penetrationDepth The sum of the penetration depths of the
+   *                                  agent into agents with greater numbers.
+   */
+  void computeAgentClearance(
+      const Agent *agent, float maxRadius,
+      float &clearance,               /* NOLINT(runtime/references) */
+      std::size_t &numPenetrations,   /* NOLINT(runtime/references) */
+      float &penetrationDepth) const; /* NOLINT(runtime/references) */
+
+  /**
+   * @brief     Estimates the density of agents around the specified agent on
+   *            its layer from the smallest agent k-D tree node that contains
+   *            the agent and at least the adaptive neighbor count of agents.
+   * @param[in] agent A pointer to the agent around which the density is to be
+   *                  estimated.
+   * @return    The count of agents per unit area in the node.
+   */
+  float computeAgentDensity(const Agent *agent) const;
+
+  /**
+   * @brief     Computes the agent neighbors of the specified agent on its
+   *            layer.
    * @param[in] agent        A pointer to the agent for which agent neighbors
    *                         are to be computed.
    * @param[in, out] rangeSq The squared range around the agent.
@@ -104,19 +189,173 @@ class KdTree {
       Agent *agent, float &rangeSq) const; /* NOLINT(runtime/references) */
 
   /**
-   * @brief     Computes the obstacle neighbors of the specified agent.
+   * @brief     Computes the box obstacle neighbors of the specified agent on
+   *            its layer.
+   * @param[in] agent   A pointer to the agent for which box obstacle neighbors
+   *                    are to be computed.
+   * @param[in] rangeSq The squared range around the agent.
+   */
+  void computeBoxObstacleNeighbors(Agent *agent, float rangeSq) const;
+
+  /**
+   * @brief          Computes the box obstacle nearest to the specified point.
+   * @param[in]      point       The point for which the nearest box obstacle
+   *                             is to be computed.
+   * @param[in]      layer       The layer of the box obstacles.
+   * @param[in, out] distSq      The squared distance to the nearest box
+   *                             obstacle found, zero if the point is inside.
+   * @param[in, out] boxObstacle A pointer to the nearest box obstacle found.
+   */
+  void computeNearestBoxObstacle(
+      const Vector2 &point, std::size_t layer,
+      float &distSq, /* NOLINT(runtime/references) */
+      const BoxObstacle *&boxObstacle) const; /* NOLINT(runtime/references) */
+
+  /**
+   * @brief          Computes the obstacle edge nearest to the specified point.
+   * @param[in]      point    The point for which the nearest obstacle edge is
+   *                          to be computed.
+   * @param[in]      layer    The layer of the obstacle edges.
+   * @param[in, out] distSq   The squared distance to the nearest obstacle edge
+   *                          found.
+   * @param[in, out] obstacle A pointer to the first vertex of the nearest
+   *                          obstacle edge found.
+   */
+  void computeNearestObstacle(
+      const Vector2 &point, std::size_t layer,
+      float &distSq,                    /* NOLINT(runtime/references) */
+      const Obstacle *&obstacle) const; /* NOLINT(runtime/references) */
+
+  /**
+   * @brief     Computes the obstacle neighbors of the specified agent on its
+   *            layer.
    * @param[in] agent   A pointer to the agent for which obstacle neighbors are
    *                    to be computed.
    * @param[in] rangeSq The squared range around the agent.
    */
   void computeObstacleNeighbors(Agent *agent, float rangeSq) const;
 
+  /**
+   * @brief      Computes statistics of the obstacle k-D trees of all layers.
+   * @param[out] numNodes The count of nodes in the obstacle k-D trees.
+   * @param[out] depth    The maximum depth of the obstacle k-D trees.
+   * @param[out] sumDepth The sum of the depths of all nodes in the obstacle
+   *                      k-D trees.
+   */
+  void computeObstacleTreeStats(
+      std::size_t &numNodes,        /* NOLINT(runtime/references) */
+      std::size_t &depth,           /* NOLINT(runtime/references) */
+      std::size_t &sumDepth) const; /* NOLINT(runtime/references) */
+
+  /**
+   * @brief          Recursive function to compute statistics of the obstacle
+   *                 k-D tree.
+   * @param[in]      node     The current obstacle k-D tree node.
+   * @param[in]      depth    The depth of the current obstacle k-D tree node.
+   * @param[in, out] numNodes The count of nodes visited.
+   * @param[in, out] maxDepth The maximum depth of the nodes visited.
+   * @param[in, out] sumDepth The sum of the depths of the nodes visited.
+   */
+  void computeObstacleTreeStatsRecursive(
+      const ObstacleTreeNode *node, std::size_t depth,
+      std::size_t &numNodes,        /* NOLINT(runtime/references) */
+      std::size_t &maxDepth,        /* NOLINT(runtime/references) */
+      std::size_t &sumDepth) const; /* NOLINT(runtime/references) */
+
+  /**
+   * @brief         Computes the agents nearest to the specified point.
+   * @param[in]     point     The point around which agents are to be found.
+   * @param[in]     layer     The layer of the agents.
+   * @param[in]     maxAgents The maximum number of agents to be found.
+   * @param[in,out] rangeSq   The squared range around the point.
+   * @param[out]    agents    The squared distances and numbers of the agents
+   *                          found, sorted by increasing distance.
+   */
+  void computePointNeighbors(
+      const Vector2 &point, std::size_t layer, std::size_t maxAgents,
+      float &rangeSq, /* NOLINT(runtime/references) */
+      std::vector<std::pair<float, std::size_t> > &agents)
+      const; /* NOLINT(runtime/references) */
+
+  /**
+   * @brief          Computes the first obstacle edge hit by the specified ray.
+   * @param[in]      origin    The origin of the ray.
+   * @param[in]      direction The unit direction of the ray.
+   * @param[in]      layer     The layer of the obstacle edges.
+   * @param[in, out] distance  The length of the ray, shortened to the distance
+   *                           to the first obstacle edge hit.
+   * @param[in, out] obstacle  A pointer to the first vertex of the first
+   *                           obstacle edge hit.
+   */
+  void computeRaycast(
+      const Vector2 &origin, const Vector2 &direction, std::size_t layer,
+      float &distance, /* NOLINT(runtime/references) */
+      const Obstacle *&obstacle) const; /* NOLINT(runtime/references) */
+
   /**
    * @brief     Deletes the specified obstacle tree node.
    * @param[in] node A pointer to the obstacle tree node to be deleted.
    */
   void deleteObstacleTree(ObstacleTreeNode *node);
 
+  /**
+   * @brief          Finds the obstacle edge among a range of candidates that
+   *                 best splits the specified obstacles.
+   * @param[in]      obstacles    List of obstacles to be split.
+   * @param[in]      begin        The first candidate split edge.
+   * @param[in]      end          One past the last candidate split edge.
+   * @param[in, out] optimalSplit The optimal candidate split edge.
+   * @param[in, out] minLeft      The number of obstacles left of the optimal
+   *                              candidate split edge.
+   * @param[in, out] minRight     The number of obstacles right of the optimal
+   *                              candidate split edge.
+   */
+  void findObstacleSplit(
+      const std::vector<Obstacle *> &obstacles, std::size_t begin,
+      std::size_t end,
+      std::size_t &optimalSplit, /* NOLINT(runtime/references) */
+      std::size_t &minLeft,      /* NOLINT(runtime/references) */
+      std::size_t &minRight) const; /* NOLINT(runtime/references) */
+
+  /**
+   * @brief     Returns the obstacle k-D tree of the specified layer.
+   * @param[in] layer The layer of the obstacle k-D tree.
+   * @return    A pointer to the root of the obstacle k-D tree, or NULL when the
+   *            layer has no obstacles.
+   */
+  const ObstacleTreeNode *getObstacleTree(std::size_t layer) const;
+
+  /**
+   * @brief     Determines whether a point lies inside an obstacle by descending
+   *            the obstacle k-D tree, in which the inside of an obstacle is to
+   *            the left of its edges.
+   * @param[in] point The point to be tested.
+   * @param[in] layer The layer of the obstacles.
+   * @return    True if the point lies inside an obstacle on the layer.
+   */
+  bool isInsideObstacle(const Vector2 &point, std::size_t layer) const;
+
+  /**
+   * @brief          Recursive function to compute the clearance of the
+   *                 specified agent to the other agents.
+   * @param[in]      agent            A pointer to the agent for which the
+   *                                  clearance is to be computed.
+   * @param[in]      maxRadius        The maximum radius of the agents.
+   * @param[in, out] clearance        The minimum distance between the agent
+   *                                  and another agent found.
+   * @param[in, out] numPenetrations  The count of agents with greater numbers
+   *                                  that the agent penetrates.
+   * @param[in, out] penetrationDepth The sum of the penetration depths of the
+   *                                  agent into agents with greater numbers.
+   * @param[in]      node             The current agent k-D tree node.
+   */
+  void queryAgentClearanceRecursive(
+      const Agent *agent, float maxRadius,
+      float &clearance,             /* NOLINT(runtime/references) */
+      std::size_t &numPenetrations, /* NOLINT(runtime/references) */
+      float &penetrationDepth,      /* NOLINT(runtime/references) */
+      std::size_t node) const;
+
   /**
    * @brief         Recursive function to compute the neighbors of the specified
    *                agent.
@@ -129,6 +368,70 @@ class KdTree {
                                float &rangeSq, /* NOLINT(runtime/references) */
                                std::size_t node) const;
 
+  /**
+   * @brief     Recursive function to compute the box obstacle neighbors of the
+   *            specified agent.
+   * @param[in] agent   A pointer to the agent for which box obstacle neighbors
+   *                    are to be computed.
+   * @param[in] rangeSq The squared range around the agent.
+   * @param[in] node    The current box obstacle k-D tree node number.
+   */
+  void queryBoxObstacleTreeRecursive(Agent *agent, float rangeSq,
+                                     std::size_t node) const;
+
+  /**
+   * @brief          Recursive function to query the visibility between two
+   *                 points within a specified radius with respect to the box
+   *                 obstacles.
+   * @param[in]      vector1         The first point between which visibility
+   *                                 is to be tested.
+   * @param[in]      vector2         The second point between which visibility
+   *                                 is to be tested.
+   * @param[in]      radius          The radius within which visibility is to
+   *                                 be tested.
+   * @param[in]      node            The current box obstacle k-D tree node
+   *                                 number.
+   * @param[in, out] numNodesVisited The count of box obstacle k-D tree nodes
+   *                                 visited.
+   * @return         True if q1 and q2 are mutually visible within the radius;
+   *                 false otherwise.
+   */
+  bool queryBoxObstacleVisibilityRecursive(
+      const Vector2 &vector1, const Vector2 &vector2, float radius,
+      std::size_t node,
+      std::size_t &numNodesVisited) const; /* NOLINT(runtime/references) */
+
+  /**
+   * @brief          Recursive function to compute the box obstacle nearest to
+   *                 the specified point.
+   * @param[in]      point       The point for which the nearest box obstacle
+   *                             is to be computed.
+   * @param[in, out] distSq      The squared distance to the nearest box
+   *                             obstacle found.
+   * @param[in, out] boxObstacle A pointer to the nearest box obstacle found.
+   * @param[in]      node        The current box obstacle k-D tree node number.
+   */
+  void queryNearestBoxObstacleRecursive(
+      const Vector2 &point, float &distSq, /* NOLINT(runtime/references) */
+      const BoxObstacle *&boxObstacle,     /* NOLINT(runtime/references) */
+      std::size_t node) const;
+
+  /**
+   * @brief          Recursive function to compute the obstacle edge nearest to
+   *                 the specified point.
+   * @param[in]      point    The point for which the nearest obstacle edge is
+   *                          to be computed.
+   * @param[in, out] distSq   The squared distance to the nearest obstacle edge
+   *                          found.
+   * @param[in, out] obstacle A pointer to the first vertex of the nearest
+   *                          obstacle edge found.
+   * @param[in]      node     The current obstacle k-D tree node.
+   */
+  void queryNearestObstacleRecursive(
+      const Vector2 &point, float &distSq, /* NOLINT(runtime/references) */
+      const Obstacle *&obstacle, /* NOLINT(runtime/references) */
+      const ObstacleTreeNode *node) const;
+
   /**
    * @brief         Recursive function to compute the neighbors of the specified
    *                obstacle.
@@ -140,6 +443,40 @@ class KdTree {
   void queryObstacleTreeRecursive(Agent *agent, float rangeSq,
                                   const ObstacleTreeNode *node) const;
 
+  /**
+   * @brief         Recursive function to compute the agents nearest to the
+   *                specified point.
+   * @param[in]     point     The point around which agents are to be found.
+   * @param[in]     maxAgents The maximum number of agents to be found.
+   * @param[in,out] rangeSq   The squared range around the point.
+   * @param[in,out] agents    The squared distances and numbers of the agents
+   *                          found so far.
+   * @param[in]     node      The current agent k-D tree node.
+   */
+  void queryPointTreeRecursive(
+      const Vector2 &point, std::size_t maxAgents,
+      float &rangeSq, /* NOLINT(runtime/references) */
+      std::vector<std::pair<float, std::size_t> >
+          &agents, /* NOLINT(runtime/references) */
+      std::size_t node) const;
+
+  /**
+   * @brief          Recursive function to compute the first obstacle edge hit
+   *                 by the specified ray.
+   * @param[in]      origin    The origin of the ray.
+   * @param[in]      direction The unit direction of the ray.
+   * @param[in, out] distance  The length of the ray, shortened to the distance
+   *                           to the first obstacle edge hit.
+   * @param[in, out] obstacle  A pointer to the first vertex of the first
+   *                           obstacle edge hit.
+   * @param[in]      node      The current obstacle k-D tree node.
+   */
+  void queryRaycastRecursive(
+      const Vector2 &origin, const Vector2 &direction,
+      float &distance, /* NOLINT(runtime/references) */
+      const Obstacle *&obstacle, /* NOLINT(runtime/references) */
+      const ObstacleTreeNode *node) const;
+
   /**
    * @brief     Queries the visibility between two points within a specified
    *            radius.
@@ -148,11 +485,16 @@ class KdTree {
    * @param[in] vector2 The second point between which visibility is to be
    *                    tested.
    * @param[in] radius  The radius within which visibility is to be tested.
+   * @param[in] layer   The layer of the obstacles.
+   * @param[in, out] numNodesVisited The count of obstacle k-D tree nodes
+   *                                 visited.
    * @return    True if q1 and q2 are mutually visible within the radius; false
    *            otherwise.
    */
-  bool queryVisibility(const Vector2 &vector1, const Vector2 &vector2,
-                       float radius) const;
+  bool queryVisibility(
+      const Vector2 &vector1, const Vector2 &vector2, float radius,
+      std::size_t layer,
+      std::size_t &numNodesVisited) const; /* NOLINT(runtime/references) */
 
   /**
    * @brief     Recursive function to query the visibility between two points
@@ -163,12 +505,28 @@ class KdTree {
    *                    tested.
    * @param[in] radius  The radius within which visibility is to be tested.
    * @param[in] node    The current obstacle k-D tree node.
+   * @param[in, out] numNodesVisited The count of obstacle k-D tree nodes
+   *                                 visited.
    * @return    True if q1 and q2 are mutually visible within the radius; false
    *            otherwise.
    */
-  bool queryVisibilityRecursive(const Vector2 &vector1, const Vector2 &vector2,
-                                float radius,
-                                const ObstacleTreeNode *node) const;
+  bool queryVisibilityRecursive(
+      const Vector2 &vector1, const Vector2 &vector2, float radius,
+      const ObstacleTreeNode *node,
+      std::size_t &numNodesVisited) const; /* NOLINT(runtime/references) */
+
+  /**
+   * @brief Refits the bounding boxes of the agent k-D trees to the current
+   *        positions of the agents without changing its structure.
+   */
+  void refitAgentTree();
+
+  /**
+   * @brief     Recursive function to refit the bounding boxes of an agent k-D
+   *            tree.
+   * @param[in] node The current agent k-D tree node.
+   */
+  void refitAgentTreeRecursive(std::size_t node);
 
   /* Not implemented. */
   KdTree(const KdTree &other);
@@ -178,8 +536,18 @@ class KdTree {
 
   std::vector<Agent *> agents_;
   std::vector<AgentTreeNode> agentTree_;
-  ObstacleTreeNode *obstacleTree_;
+  std::vector<std::size_t> agentTreeRoots_;
+  std::vector<std::size_t> boxObstacleIndices_;
+  std::vector<BoxObstacle> boxObstacles_;
+  std::vector<AgentTreeNode> boxObstacleTree_;
+  std::vector<std::size_t> boxObstacleTreeRoots_;
+  std::vector<ClusterProxy> clusterProxies_;
+  std::vector<DistanceField *> distanceFields_;
+  std::vector<ObstacleTreeNode *> obstacleTrees_;
   RVOSimulator *simulator_;
+  std::size_t adaptiveNeighborCount_;
+  std::size_t numObstacleSplits_;
+  float clusterProxyRatio_;
 
   friend class Agent;
   friend class RVOSimulator;
@@ -0,0 +1,174 @@
+/*
+ * LatencyHistogram.cc
+ * RVO2 Library
+ *
+ * SPDX-FileCopyrightText: 2008 University of North Carolina at Chapel Hill
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Please send all bug reports to <geom@cs.unc.edu>.
+ *
+ * The authors may be contacted via:
+ *
+ * Jur van den Berg, Stephen J. Guy, Jamie Snape, Ming C. Lin, Dinesh Manocha
+ * Dept. of Computer Science
+ * 201 S. Columbia St.
+ * Frederick P. Brooks, Jr. Computer Science Bldg.
+ * Chapel Hill, N.C. 27599-3175
+ * United States of America
+ *
+ * <https://gamma.cs.unc.edu/RVO2/>
+ */
+
+/**
+ * @file  LatencyHistogram.cc
+ * @brief Defines the LatencyHistogram class.
+ */
+
+#include "LatencyHistogram.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace RVO {
+namespace {
+/**
+ * @relates LatencyHistogram
+ * @brief   The latency in seconds below which all samples share the first
+ *          bucket.
+ */
+const double RVO_HISTOGRAM_MIN_LATENCY = 1.0e-7;
+
+/**
+ * @relates LatencyHistogram
+ * @brief   The count of doublings of the minimum latency that have buckets.
+ *          Longer latencies share the last bucket.
+ */
+const std::size_t RVO_HISTOGRAM_NUM_OCTAVES = 32U;
+
+/**
+ * @relates LatencyHistogram
+ * @brief   The count of buckets of equal width in each doubling of the
+ *          latency, which bounds the relative error of a latency by its
+ *          reciprocal.
+ */
+const std::size_t RVO_HISTOGRAM_NUM_SUB_BUCKETS = 32U;
+
+/**
+ * @relates LatencyHistogram
+ * @brief   The count of buckets of a latency histogram.
+ */
+const std::size_t RVO_HISTOGRAM_NUM_BUCKETS =
+    1U + RVO_HISTOGRAM_NUM_OCTAVES * RVO_HISTOGRAM_NUM_SUB_BUCKETS;
+
+/**
+ * @relates   LatencyHistogram
+ * @brief     Returns the bucket of a latency.
+ * @param[in] latency The latency in seconds.
+ * @return    The number of the bucket.
+ */
+std::size_t getBucket(double latency) {
+  const double scaledLatency = latency / RVO_HISTOGRAM_MIN_LATENCY;
+
+  if (!(scaledLatency >= 1.0)) {
+    return 0U;
+  }
+
+  /* The scaled latency equals mantissa * 2^exponent with the mantissa in
+   * [0.5, 1). */
+  int exponent = 0;
+  const double mantissa = std::frexp(scaledLatency, &exponent);
+  const std::size_t octave = static_cast<std::size_t>(exponent - 1);
+
+  if (octave >= RVO_HISTOGRAM_NUM_OCTAVES) {
+    return RVO_HISTOGRAM_NUM_BUCKETS - 1U;
+  }
+
+  const std::size_t subBucket = static_cast<std::size_t>(
+      (2.0 * mantissa - 1.0) * RVO_HISTOGRAM_NUM_SUB_BUCKETS);
+
+  return 1U + octave * RVO_HISTOGRAM_NUM_SUB_BUCKETS + subBucket;
+}
+
+/**
+ * @relates   LatencyHistogram
+ * @brief     Returns the upper limit of a bucket.
+ * @param[in] bucket The number of the bucket.
+ * @return    The upper limit of the latencies in the bucket in seconds.
+ */
+double getBucketLimit(std::size_t bucket) {
+  if (bucket == 0U) {
+    return RVO_HISTOGRAM_MIN_LATENCY;
+  }
+
+  const std::size_t octave = (bucket - 1U) / RVO_HISTOGRAM_NUM_SUB_BUCKETS;
+  const std::size_t subBucket = (bucket - 1U) % RVO_HISTOGRAM_NUM_SUB_BUCKETS;
+
+  return RVO_HISTOGRAM_MIN_LATENCY *
+         std::ldexp(1.0 + static_cast<double>(subBucket + 1U) /
+                              RVO_HISTOGRAM_NUM_SUB_BUCKETS,
+                    static_cast<int>(octave));
+}
+} /* namespace */
+
+LatencyHistogram::LatencyHistogram(std::size_t windowSize)
+    : counts_(RVO_HISTOGRAM_NUM_BUCKETS, 0U),
+      window_(windowSize, 0U),
+      numSamples_(0U) {}
+
+LatencyHistogram::~LatencyHistogram() {}
+
+double LatencyHistogram::getQuantile(double quantile) const {
+  const std::size_t numWindowSamples = std::min(numSamples_, window_.size());
+
+  if (numWindowSamples == 0U) {
+    return 0.0;
+  }
+
+  /* The rank of the sample at the quantile, counted from one. */
+  const double rank =
+      std::ceil(quantile * static_cast<double>(numWindowSamples));
+  const std::size_t minCount = static_cast<std::size_t>(
+      std::min(std::max(rank, 1.0), static_cast<double>(numWindowSamples)));
+  std::size_t count = 0U;
+
+  for (std::size_t i = 0U; i < counts_.size(); ++i) {
+    count += counts_[i];
+
+    if (count >= minCount) {
+      return getBucketLimit(i);
+    }
+  }
+
+  return getBucketLimit(counts_.size() - 1U);
+}
+
+void LatencyHistogram::record(double latency) {
+  const std::size_t slot = numSamples_ % window_.size();
+
+  if (numSamples_ >= window_.size()) {
+    /* Replace the oldest sample. */
+    --counts_[window_[slot]];
+  }
+
+  window_[slot] = getBucket(latency);
+  ++counts_[window_[slot]];
+  ++numSamples_;
+}
+
+void LatencyHistogram::reset() {
+  std::fill(counts_.begin(), counts_.end(), 0U);
+  numSamples_ = 0U;
+}
+} /* namespace RVO */
@@ -0,0 +1,99 @@
+/*
+ * LatencyHistogram.h
+ * RVO2 Library
+ *
+ * SPDX-FileCopyrightText: 2008 University of North Carolina at Chapel Hill
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Please send all bug reports to <geom@cs.unc.edu>.
+ *
+ * The authors may be contacted via:
+ *
+ * Jur van den Berg, Stephen J. Guy, Jamie Snape, Ming C. Lin, Dinesh Manocha
+ * Dept. of Computer Science
+ * 201 S. Columbia St.
+ * Frederick P. Brooks, Jr. Computer Science Bldg.
+ * Chapel Hill, N.C. 27599-3175
+ * United States of America
+ *
+ * <https://gamma.cs.unc.edu/RVO2/>
+ */
+
+#ifndef RVO_LATENCY_HISTOGRAM_H_
+#define RVO_LATENCY_HISTOGRAM_H_
+
+/**
+ * @file  LatencyHistogram.h
+ * @brief Declares the LatencyHistogram class.
+ */
+
+#include <cstddef>
+#include <vector>
+
+namespace RVO {
+/**
+ * @brief Defines a histogram of the latencies of the most recent samples with
+ *        buckets whose width grows with their latency, so that every latency
+ *        is resolved to within a fixed relative precision.
+ */
+class LatencyHistogram {
+ private:
+  /**
+   * @brief     Constructs a latency histogram instance.
+   * @param[in] windowSize The count of most recent samples in the histogram.
+   *                       Must be positive.
+   */
+  explicit LatencyHistogram(std::size_t windowSize);
+
+  /**
+   * @brief Destroys this latency histogram instance.
+   */
+  ~LatencyHistogram();
+
+  /**
+   * @brief     Returns the latency at the specified quantile of the samples.
+   * @param[in] quantile The quantile, between zero and one.
+   * @return    The upper limit of the bucket of the sample at the quantile, or
+   *            zero if there are no samples.
+   */
+  double getQuantile(double quantile) const;
+
+  /**
+   * @brief     Adds a sample to the histogram, replacing the oldest sample once
+   *            the histogram holds the window size of samples.
+   * @param[in] latency The latency in seconds.
+   */
+  void record(double latency);
+
+  /**
+   * @brief Removes all samples from the histogram.
+   */
+  void reset();
+
+  /* Not implemented. */
+  LatencyHistogram(const LatencyHistogram &other);
+
+  /* Not implemented. */
+  LatencyHistogram &operator=(const LatencyHistogram &other);
+
+  std::vector<std::size_t> counts_;
+  std::vector<std::size_t> window_;
+  std::size_t numSamples_;
+
+  friend class RealTimeRunner;
+};
+} /* namespace RVO */
+
+#endif /* RVO_LATENCY_HISTOGRAM_H_ */
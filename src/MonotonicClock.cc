@@ -0,0 +1,103 @@
+/*
+ * MonotonicClock.cc
+ * RVO2 Library
+ *
+ * SPDX-FileCopyrightText: 2008 University of North Carolina at Chapel Hill
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Please send all bug reports to <geom@cs.unc.edu>.
+ *
+ * The authors may be contacted via:
+ *
+ * Jur van den Berg, Stephen J. Guy, Jamie Snape, Ming C. Lin, Dinesh Manocha
+ * Dept. of Computer Science
+ * 201 S. Columbia St.
+ * Frederick P. Brooks, Jr. Computer Science Bldg.
+ * Chapel Hill, N.C. 27599-3175
+ * United States of America
+ *
+ * <https://gamma.cs.unc.edu/RVO2/>
+ */
+
+/**
+ * @file  MonotonicClock.cc
+ * @brief Defines functions to read a monotonic clock and to sleep until a time
+ *        of it.
+ */
+
+#include "MonotonicClock.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <time.h>
+
+#include <cerrno>
+#define RVO_MONOTONIC_CLOCK_POSIX 1
+#define RVO_MONOTONIC_CLOCK_WINDOWS 0
+#elif defined(_WIN32)
+#include <windows.h>
+#define RVO_MONOTONIC_CLOCK_POSIX 0
+#define RVO_MONOTONIC_CLOCK_WINDOWS 1
+#else
+#include <ctime>
+#define RVO_MONOTONIC_CLOCK_POSIX 0
+#define RVO_MONOTONIC_CLOCK_WINDOWS 0
+#endif /* __unix__ || __APPLE__ */
+
+namespace RVO {
+double getMonotonicTime() {
+#if RVO_MONOTONIC_CLOCK_POSIX
+  timespec time;
+  clock_gettime(CLOCK_MONOTONIC, &time);
+
+  return static_cast<double>(time.tv_sec) +
+         1.0e-9 * static_cast<double>(time.tv_nsec);
+#elif RVO_MONOTONIC_CLOCK_WINDOWS
+  LARGE_INTEGER frequency;
+  LARGE_INTEGER counter;
+  QueryPerformanceFrequency(&frequency);
+  QueryPerformanceCounter(&counter);
+
+  return static_cast<double>(counter.QuadPart) /
+         static_cast<double>(frequency.QuadPart);
+#else
+  return static_cast<double>(std::clock()) / CLOCKS_PER_SEC;
+#endif /* RVO_MONOTONIC_CLOCK_POSIX */
+}
+
+void sleepUntil(double wakeTime) {
+  const double duration = wakeTime - getMonotonicTime();
+
+  if (duration <= 0.0) {
+    return;
+  }
+
+#if RVO_MONOTONIC_CLOCK_POSIX
+  timespec time;
+  time.tv_sec = static_cast<time_t>(duration);
+  const double nanoseconds =
+      1.0e9 * (duration - static_cast<double>(time.tv_sec));
+  time.tv_nsec = static_cast<long>(nanoseconds); /* NOLINT(runtime/int) */
+
+  /* Resume sleeping for the remaining time if interrupted by a signal. */
+  while (nanosleep(&time, &time) == -1 && errno == EINTR) {
+  }
+#elif RVO_MONOTONIC_CLOCK_WINDOWS
+  Sleep(static_cast<DWORD>(1000.0 * duration));
+#else
+  while (getMonotonicTime() < wakeTime) {
+  }
+#endif /* RVO_MONOTONIC_CLOCK_POSIX */
+}
+} /* namespace RVO */
@@ -0,0 +1,59 @@
+/*
+ * MonotonicClock.h
+ * RVO2 Library
+ *
+ * SPDX-FileCopyrightText: 2008 University of North Carolina at Chapel Hill
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Please send all bug reports to <geom@cs.unc.edu>.
+ *
+ * The authors may be contacted via:
+ *
+ * Jur van den Berg, Stephen J. Guy, Jamie Snape, Ming C. Lin, Dinesh Manocha
+ * Dept. of Computer Science
+ * 201 S. Columbia St.
+ * Frederick P. Brooks, Jr. Computer Science Bldg.
+ * Chapel Hill, N.C. 27599-3175
+ * United States of America
+ *
+ * <https://gamma.cs.unc.edu/RVO2/>
+ */
+
+#ifndef RVO_MONOTONIC_CLOCK_H_
+#define RVO_MONOTONIC_CLOCK_H_
+
+/**
+ * @file  MonotonicClock.h
+ * @brief Declares functions to read a monotonic clock and to sleep until a
+ *        time of it.
+ */
+
+namespace RVO {
+/**
+ * @brief  Returns the time of a monotonic clock, which measures elapsed wall
+ *         clock time and is not adjusted while the program runs.
+ * @return The time in seconds from an arbitrary origin. Without a monotonic
+ *         clock, the processor time of the program is returned instead.
+ */
+double getMonotonicTime();
+
+/**
+ * @brief     Suspends the calling thread until a time of the monotonic clock.
+ * @param[in] wakeTime The time in seconds at which to resume.
+ */
+void sleepUntil(double wakeTime);
+} /* namespace RVO */
+
+#endif /* RVO_MONOTONIC_CLOCK_H_ */
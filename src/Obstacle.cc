@@ -40,7 +40,13 @@
 
 namespace RVO {
 Obstacle::Obstacle()
-    : next_(NULL), previous_(NULL), id_(0U), isConvex_(false) {}
+    : next_(NULL),
+      previous_(NULL),
+      id_(0U),
+      layer_(0U),
+      isConvex_(false),
+      isInBlock_(false),
+      isSplit_(false) {}
 
 Obstacle::~Obstacle() {}
 } /* namespace RVO */
@@ -70,9 +70,13 @@ class Obstacle {
   Obstacle *next_;
   Obstacle *previous_;
   std::size_t id_;
+  std::size_t layer_;
   bool isConvex_;
+  bool isInBlock_;
+  bool isSplit_;
 
   friend class Agent;
+  friend class DistanceField;
   friend class KdTree;
   friend class RVOSimulator;
 };
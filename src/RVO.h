@@ -49,6 +49,7 @@
 #include "Export.h"
 #include "Line.h"
 #include "RVOSimulator.h"
+#include "RealTimeRunner.h"
 #include "Vector2.h"
 /* IWYU pragma: end_exports */
 
@@ -38,14 +38,19 @@
 
 #include "RVOSimulator.h"
 
+#include <algorithm>
+#include <cmath>
 #include <limits>
 #include <utility>
 
 #include "Agent.h"
+#include "BoxObstacle.h"
 #include "KdTree.h"
 #include "Line.h"
+#include "MonotonicClock.h"
 #include "Obstacle.h"
 #include "Vector2.h"
+#include "WkbReader.h"
 
 #ifdef _OPENMP
 #include <omp.h>
@@ -53,20 +58,380 @@
 
 namespace RVO {
 const std::size_t RVO_ERROR = std::numeric_limits<std::size_t>::max();
+const std::size_t RVO_MAX_LAYERS = 1024U;
+
+namespace {
+/**
+ * @relates RVOSimulator
+ * @brief   The maximum fraction of agents with infeasible ORCA constraints for
+ *          which the adaptive time step may grow.
+ */
+const float RVO_MAX_INFEASIBLE_FRACTION = 0.1F;
+
+/**
+ * @relates RVOSimulator
+ * @brief   The count of barriers timed to measure the cost of synchronizing a
+ *          team of threads.
+ */
+const int RVO_PARALLELISM_NUM_BARRIERS = 16;
+
+/**
+ * @relates RVOSimulator
+ * @brief   The maximum count of simulation steps a team of threads performs
+ *          before the team is chosen again.
+ */
+const std::size_t RVO_PARALLELISM_NUM_STEPS = 64U;
+
+/**
+ * @relates RVOSimulator
+ * @brief   The count of times each team of threads is timed, of which the
+ *          fastest is kept.
+ */
+const int RVO_PARALLELISM_NUM_TRIALS = 3;
+
+/**
+ * @relates RVOSimulator
+ * @brief   The weight of the most recent simulation step in the estimated cost
+ *          per agent of each phase of a simulation step.
+ */
+const double RVO_PARALLELISM_SMOOTHING = 0.125;
+
+/**
+ * @relates RVOSimulator
+ * @brief   The multiplier of the Philox2x32 counter-based random number
+ *          generator.
+ */
+const unsigned int RVO_PHILOX_MULTIPLIER = 0xD256D193U;
+
+/**
+ * @relates RVOSimulator
+ * @brief   The count of rounds of the Philox2x32 counter-based random number
+ *          generator.
+ */
+const int RVO_PHILOX_NUM_ROUNDS = 10;
+
+/**
+ * @relates RVOSimulator
+ * @brief   The increment of the key per round of the Philox2x32 counter-based
+ *          random number generator, i.e., the golden ratio in fixed point.
+ */
+const unsigned int RVO_PHILOX_WEYL = 0x9E3779B9U;
+
+/**
+ * @relates RVOSimulator
+ * @brief   The maximum factor by which the adaptive time step grows per step.
+ */
+const float RVO_TIME_STEP_GROWTH = 1.25F;
+
+/**
+ * @relates RVOSimulator
+ * @brief   The fraction of the time within which agents could close their
+ *          clearance that the adaptive time step may take.
+ */
+const float RVO_TIME_STEP_SAFETY = 0.5F;
+
+/**
+ * @relates RVOSimulator
+ * @brief   Two times pi.
+ */
+const float RVO_TWO_PI = 6.28318530717958647692F;
+
+#ifdef _OPENMP
+/**
+ * @relates   RVOSimulator
+ * @brief     Computes the count of agents from which a phase of a simulation
+ *            step is faster in parallel, i.e., from which the time saved by
+ *            sharing the agents among the threads exceeds the time of
+ *            synchronizing the threads once more.
+ * @param[in] agentTime   The time in seconds that one thread spends per agent.
+ * @param[in] barrierTime The time in seconds of synchronizing the threads.
+ * @param[in] numThreads  The count of threads.
+ * @return    The count of agents, or the maximum value of std::size_t if the
+ *            phase is never faster in parallel.
+ */
+std::size_t computeParallelThreshold(double agentTime, double barrierTime,
+                                     std::size_t numThreads) {
+  if (numThreads <= 1U || agentTime <= 0.0) {
+    return std::numeric_limits<std::size_t>::max();
+  }
+
+  const double threshold =
+      std::ceil(barrierTime / (agentTime * (1.0 - 1.0 / numThreads)));
+
+  if (threshold >=
+      static_cast<double>(std::numeric_limits<std::size_t>::max())) {
+    return std::numeric_limits<std::size_t>::max();
+  }
+
+  return static_cast<std::size_t>(threshold);
+}
+#endif /* _OPENMP */
+
+/**
+ * @relates   RVOSimulator
+ * @brief     Multiplies two 32-bit unsigned integers into a 64-bit product
+ *            without 64-bit integer types, which C++98 lacks.
+ * @param[in] value1 The first factor.
+ * @param[in] value2 The second factor.
+ * @return    The high and low 32 bits of the product.
+ */
+std::pair<unsigned int, unsigned int> multiplyWide(unsigned int value1,
+                                                   unsigned int value2) {
+  const unsigned int low1 = value1 & 0xFFFFU;
+  const unsigned int high1 = value1 >> 16U;
+  const unsigned int low2 = value2 & 0xFFFFU;
+  const unsigned int high2 = value2 >> 16U;
+  const unsigned int lowLow = low1 * low2;
+  const unsigned int lowHigh = low1 * high2;
+  const unsigned int highLow = high1 * low2;
+  const unsigned int middle =
+      (lowLow >> 16U) + (lowHigh & 0xFFFFU) + (highLow & 0xFFFFU);
+
+  return std::make_pair(high1 * high2 + (lowHigh >> 16U) + (highLow >> 16U) +
+                            (middle >> 16U),
+                        (lowLow & 0xFFFFU) | (middle << 16U));
+}
+
+/**
+ * @relates   RVOSimulator
+ * @brief     Computes two random numbers with the Philox2x32-10 counter-based
+ *            random number generator. The numbers depend only on the counter
+ *            and key, so they may be computed in parallel without shared
+ *            state.
+ * @param[in] counter1 The first half of the counter.
+ * @param[in] counter2 The second half of the counter.
+ * @param[in] key      The key.
+ * @return    Two uniformly distributed 32-bit random numbers.
+ */
+std::pair<unsigned int, unsigned int> computePhilox(unsigned int counter1,
+                                                    unsigned int counter2,
+                                                    unsigned int key) {
+  for (int i = 0; i < RVO_PHILOX_NUM_ROUNDS; ++i) {
+    const std::pair<unsigned int, unsigned int> product =
+        multiplyWide(RVO_PHILOX_MULTIPLIER, counter1);
+    counter1 = product.first ^ key ^ counter2;
+    counter2 = product.second;
+    key += RVO_PHILOX_WEYL;
+  }
+
+  return std::make_pair(counter1, counter2);
+}
+
+/**
+ * @relates   RVOSimulator
+ * @brief     Computes twice the signed area of a polygon.
+ * @param[in] vertices The vertices of the polygon.
+ * @return    Twice the signed area of the polygon, which is positive when its
+ *            vertices are in counterclockwise order.
+ */
+float computeSignedArea(const std::vector<Vector2> &vertices) {
+  float area = 0.0F;
+
+  for (std::size_t i = 0U; i < vertices.size(); ++i) {
+    area += det(vertices[i], vertices[(i + 1U) % vertices.size()]);
+  }
+
+  return area;
+}
+
+/**
+ * @relates   RVOSimulator
+ * @brief     Tests whether a point lies inside a polygon.
+ * @param[in] vertices The vertices of the polygon.
+ * @param[in] point    The point to be tested.
+ * @return    True if the point lies inside the polygon; false otherwise.
+ */
+bool isPointInPolygon(const std::vector<Vector2> &vertices,
+                      const Vector2 &point) {
+  bool isInside = false;
+
+  for (std::size_t i = 0U, j = vertices.size() - 1U; i < vertices.size();
+       j = i++) {
+    if ((vertices[i].y() > point.y()) != (vertices[j].y() > point.y()) &&
+        point.x() < vertices[i].x() + (point.y() - vertices[i].y()) *
+                                          (vertices[j].x() - vertices[i].x()) /
+                                          (vertices[j].y() - vertices[i].y())) {
+      isInside = !isInside;
+    }
+  }
+
+  return isInside;
+}
+
+/**
+ * @relates   RVOSimulator
+ * @brief     Tests whether a polygon lies inside another polygon.
+ * @param[in] inner The vertices of the polygon that may lie inside.
+ * @param[in] outer The vertices of the polygon that may contain the other.
+ * @return    True if every vertex of the inner polygon lies inside the outer
+ *            polygon and no edges of the polygons cross; false otherwise.
+ */
+bool isPolygonInPolygon(const std::vector<Vector2> &inner,
+                        const std::vector<Vector2> &outer) {
+  for (std::size_t i = 0U; i < inner.size(); ++i) {
+    if (!isPointInPolygon(outer, inner[i])) {
+      return false;
+    }
+  }
+
+  for (std::size_t i = 0U; i < inner.size(); ++i) {
+    const Vector2 &inner1 = inner[i];
+    const Vector2 &inner2 = inner[(i + 1U) % inner.size()];
+
+    for (std::size_t j = 0U; j < outer.size(); ++j) {
+      const Vector2 &outer1 = outer[j];
+      const Vector2 &outer2 = outer[(j + 1U) % outer.size()];
+
+      if (leftOf(inner1, inner2, outer1) * leftOf(inner1, inner2, outer2) <
+              0.0F &&
+          leftOf(outer1, outer2, inner1) * leftOf(outer1, outer2, inner2) <
+              0.0F) {
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+/**
+ * @relates       RVOSimulator
+ * @brief         Removes near-duplicate and nearly collinear vertices from a
+ *                polygon, such that every removed vertex lies within the
+ *                tolerance of the simplified polygon.
+ * @param[in,out] vertices    The vertices of the polygon.
+ * @param[in]     toleranceSq The squared distance within which vertices are
+ *                            removed.
+ */
+void simplifyPolygon(
+    std::vector<Vector2> &vertices, /* NOLINT(runtime/references) */
+    float toleranceSq) {
+  /* Snap near-duplicate vertices, keeping the indices of the remaining
+   * vertices. */
+  std::vector<std::size_t> indices;
+
+  for (std::size_t i = 0U; i < vertices.size(); ++i) {
+    if (indices.empty() ||
+        absSq(vertices[i] - vertices[indices.back()]) > toleranceSq) {
+      indices.push_back(i);
+    }
+  }
+
+  while (indices.size() > 1U &&
+         absSq(vertices[indices.back()] - vertices[indices.front()]) <=
+             toleranceSq) {
+    indices.pop_back();
+  }
+
+  /* Merge nearly collinear edges. A vertex is removed only if every original
+   * vertex between its neighbors lies within the tolerance of the merged edge,
+   * so that the error does not accumulate over successive removals. A polygon
+   * keeps at least three vertices so that it does not become a line
+   * segment. */
+  bool isSimplified = false;
+
+  while (!isSimplified) {
+    isSimplified = true;
+
+    for (std::size_t i = 0U; i < indices.size() && indices.size() > 3U;) {
+      const std::size_t previous =
+          indices[(i + indices.size() - 1U) % indices.size()];
+      const std::size_t next = indices[(i + 1U) % indices.size()];
+      bool isRemovable = true;
+
+      for (std::size_t j = (previous + 1U) % vertices.size();
+           j != next && isRemovable; j = (j + 1U) % vertices.size()) {
+        isRemovable = distSqPointLineSegment(vertices[previous], vertices[next],
+                                             vertices[j]) <= toleranceSq;
+      }
+
+      if (isRemovable) {
+        indices.erase(indices.begin() + static_cast<std::ptrdiff_t>(i));
+        isSimplified = false;
+      } else {
+        ++i;
+      }
+    }
+  }
+
+  std::vector<Vector2> simplified;
+  simplified.reserve(indices.size());
+
+  for (std::size_t i = 0U; i < indices.size(); ++i) {
+    simplified.push_back(vertices[indices[i]]);
+  }
+
+  vertices.swap(simplified);
+}
+} /* namespace */
 
 RVOSimulator::RVOSimulator()
     : defaultAgent_(NULL),
       kdTree_(new KdTree(this)),
+      prefVelocityCallback_(NULL),
+      prefVelocityCallbackContext_(NULL),
+      agentUpdateTime_(0.0),
+      agentVelocityTime_(0.0),
+      barrierTime_(0.0),
+      stepBuildTime_(0.0),
+      stepDeadline_(std::numeric_limits<double>::infinity()),
+      stepUpdateTime_(0.0),
+      stepVelocityTime_(0.0),
+      numAgentPenetrations_(0U),
+      numDeferredAgents_(0U),
+      numObstaclePenetrations_(0U),
+      numSteps_(0U),
+      numThreads_(1U),
+      parallelUpdateThreshold_(std::numeric_limits<std::size_t>::max()),
+      parallelVelocityThreshold_(std::numeric_limits<std::size_t>::max()),
+      perturbationSeed_(0U),
       globalTime_(0.0F),
-      timeStep_(0.0F) {}
+      maxTimeStep_(0.0F),
+      minClearance_(std::numeric_limits<float>::infinity()),
+      minTimeStep_(0.0F),
+      penetrationDepth_(0.0F),
+      perturbationMagnitude_(0.0F),
+      timeStep_(0.0F),
+      isAutomaticParallelismEnabled_(true),
+      isConstraintPruningEnabled_(false),
+      isInterpolationEnabled_(false),
+      isIntrospectionEnabled_(true),
+      isQualityMetricsEnabled_(false) {}
 
 RVOSimulator::RVOSimulator(float timeStep, float neighborDist,
                            std::size_t maxNeighbors, float timeHorizon,
                            float timeHorizonObst, float radius, float maxSpeed)
     : defaultAgent_(new Agent()),
       kdTree_(new KdTree(this)),
+      prefVelocityCallback_(NULL),
+      prefVelocityCallbackContext_(NULL),
+      agentUpdateTime_(0.0),
+      agentVelocityTime_(0.0),
+      barrierTime_(0.0),
+      stepBuildTime_(0.0),
+      stepDeadline_(std::numeric_limits<double>::infinity()),
+      stepUpdateTime_(0.0),
+      stepVelocityTime_(0.0),
+      numAgentPenetrations_(0U),
+      numDeferredAgents_(0U),
+      numObstaclePenetrations_(0U),
+      numSteps_(0U),
+      numThreads_(1U),
+      parallelUpdateThreshold_(std::numeric_limits<std::size_t>::max()),
+      parallelVelocityThreshold_(std::numeric_limits<std::size_t>::max()),
+      perturbationSeed_(0U),
       globalTime_(0.0F),
-      timeStep_(timeStep) {
+      maxTimeStep_(0.0F),
+      minClearance_(std::numeric_limits<float>::infinity()),
+      minTimeStep_(0.0F),
+      penetrationDepth_(0.0F),
+      perturbationMagnitude_(0.0F),
+      timeStep_(timeStep),
+      isAutomaticParallelismEnabled_(true),
+      isConstraintPruningEnabled_(false),
+      isInterpolationEnabled_(false),
+      isIntrospectionEnabled_(true),
+      isQualityMetricsEnabled_(false) {
   defaultAgent_->maxNeighbors_ = maxNeighbors;
   defaultAgent_->maxSpeed_ = maxSpeed;
   defaultAgent_->neighborDist_ = neighborDist;
@@ -81,8 +446,35 @@ RVOSimulator::RVOSimulator(float timeStep, float neighborDist,
                            const Vector2 &velocity)
     : defaultAgent_(new Agent()),
       kdTree_(new KdTree(this)),
+      prefVelocityCallback_(NULL),
+      prefVelocityCallbackContext_(NULL),
+      agentUpdateTime_(0.0),
+      agentVelocityTime_(0.0),
+      barrierTime_(0.0),
+      stepBuildTime_(0.0),
+      stepDeadline_(std::numeric_limits<double>::infinity()),
+      stepUpdateTime_(0.0),
+      stepVelocityTime_(0.0),
+      numAgentPenetrations_(0U),
+      numDeferredAgents_(0U),
+      numObstaclePenetrations_(0U),
+      numSteps_(0U),
+      numThreads_(1U),
+      parallelUpdateThreshold_(std::numeric_limits<std::size_t>::max()),
+      parallelVelocityThreshold_(std::numeric_limits<std::size_t>::max()),
+      perturbationSeed_(0U),
       globalTime_(0.0F),
-      timeStep_(timeStep) {
+      maxTimeStep_(0.0F),
+      minClearance_(std::numeric_limits<float>::infinity()),
+      minTimeStep_(0.0F),
+      penetrationDepth_(0.0F),
+      perturbationMagnitude_(0.0F),
+      timeStep_(timeStep),
+      isAutomaticParallelismEnabled_(true),
+      isConstraintPruningEnabled_(false),
+      isInterpolationEnabled_(false),
+      isIntrospectionEnabled_(true),
+      isQualityMetricsEnabled_(false) {
   defaultAgent_->velocity_ = velocity;
   defaultAgent_->maxNeighbors_ = maxNeighbors;
   defaultAgent_->maxSpeed_ = maxSpeed;
@@ -100,8 +492,57 @@ RVOSimulator::~RVOSimulator() {
     delete agents_[i];
   }
 
-  for (std::size_t i = 0U; i < obstacles_.size(); ++i) {
-    delete obstacles_[i];
+  for (std::size_t i = 0U; i < scratchAgents_.size(); ++i) {
+    delete scratchAgents_[i];
+  }
+
+  deleteObstacles();
+}
+
+void RVOSimulator::adaptTimeStep() {
+#ifdef _OPENMP
+#pragma omp single
+#endif /* _OPENMP */
+  agentSafeTimeSteps_.resize(agents_.size());
+
+#ifdef _OPENMP
+#pragma omp for
+#endif /* _OPENMP */
+  for (int i = 0; i < static_cast<int>(agents_.size()); ++i) {
+    agentSafeTimeSteps_[i] = agents_[i]->computeSafeTimeStep();
+  }
+
+  /* Reduce serially, as OpenMP 2.0 has no min reduction. */
+#ifdef _OPENMP
+#pragma omp single
+#endif /* _OPENMP */
+  {
+    float safeTimeStep = std::numeric_limits<float>::infinity();
+    std::size_t numInfeasible = 0U;
+
+    for (std::size_t i = 0U; i < agents_.size(); ++i) {
+      safeTimeStep = std::min(safeTimeStep, agentSafeTimeSteps_[i]);
+
+      if (agents_[i]->isInfeasible_) {
+        ++numInfeasible;
+      }
+    }
+
+    if (safeTimeStep <= 0.0F) {
+      /* Agents overlap. */
+      timeStep_ *= 0.5F;
+    } else {
+      float maxTimeStep = RVO_TIME_STEP_GROWTH * timeStep_;
+
+      if (static_cast<float>(numInfeasible) >
+          RVO_MAX_INFEASIBLE_FRACTION * static_cast<float>(agents_.size())) {
+        maxTimeStep = timeStep_;
+      }
+
+      timeStep_ = std::min(maxTimeStep, RVO_TIME_STEP_SAFETY * safeTimeStep);
+    }
+
+    timeStep_ = std::max(minTimeStep_, std::min(maxTimeStep_, timeStep_));
   }
 }
 
@@ -109,6 +550,7 @@ std::size_t RVOSimulator::addAgent(const Vector2 &position) {
   if (defaultAgent_ != NULL) {
     Agent *const agent = new Agent();
     agent->position_ = position;
+    agent->previousPosition_ = position;
     agent->velocity_ = defaultAgent_->velocity_;
     agent->id_ = agents_.size();
     agent->maxNeighbors_ = defaultAgent_->maxNeighbors_;
@@ -117,6 +559,7 @@ std::size_t RVOSimulator::addAgent(const Vector2 &position) {
     agent->radius_ = defaultAgent_->radius_;
     agent->timeHorizon_ = defaultAgent_->timeHorizon_;
     agent->timeHorizonObst_ = defaultAgent_->timeHorizonObst_;
+    agent->isIntrospectionEnabled_ = isIntrospectionEnabled_;
     agents_.push_back(agent);
 
     return agents_.size() - 1U;
@@ -139,6 +582,7 @@ std::size_t RVOSimulator::addAgent(const Vector2 &position, float neighborDist,
                                    float maxSpeed, const Vector2 &velocity) {
   Agent *const agent = new Agent();
   agent->position_ = position;
+  agent->previousPosition_ = position;
   agent->velocity_ = velocity;
   agent->id_ = agents_.size();
   agent->maxNeighbors_ = maxNeighbors;
@@ -147,71 +591,447 @@ std::size_t RVOSimulator::addAgent(const Vector2 &position, float neighborDist,
   agent->radius_ = radius;
   agent->timeHorizon_ = timeHorizon;
   agent->timeHorizonObst_ = timeHorizonObst;
+  agent->isIntrospectionEnabled_ = isIntrospectionEnabled_;
   agents_.push_back(agent);
 
   return agents_.size() - 1U;
 }
 
+std::size_t RVOSimulator::addBoxObstacle(const Vector2 &minCorner,
+                                         const Vector2 &maxCorner) {
+  return addBoxObstacle(minCorner, maxCorner, 0U);
+}
+
+std::size_t RVOSimulator::addBoxObstacle(const Vector2 &minCorner,
+                                         const Vector2 &maxCorner,
+                                         std::size_t layer) {
+  if (layer < RVO_MAX_LAYERS && minCorner.x() < maxCorner.x() &&
+      minCorner.y() < maxCorner.y()) {
+    std::vector<BoxObstacle> &boxObstacles = kdTree_->boxObstacles_;
+    const std::size_t boxObstacleNo = boxObstacles.size();
+
+    if (boxObstacles.size() == boxObstacles.capacity()) {
+      /* Box obstacle neighbors refer to the box obstacles about to be
+       * reallocated. */
+      for (std::size_t i = 0U; i < agents_.size(); ++i) {
+        agents_[i]->boxObstacleNeighbors_.clear();
+      }
+    }
+
+    kdTree_->boxObstacleIndices_.push_back(boxObstacleNo);
+    boxObstacles.push_back(
+        BoxObstacle(minCorner, maxCorner, boxObstacleNo, layer));
+
+    return boxObstacleNo;
+  }
+
+  return RVO_ERROR;
+}
+
 std::size_t RVOSimulator::addObstacle(const std::vector<Vector2> &vertices) {
-  if (vertices.size() > 1U) {
+  return addObstacle(vertices, 0U);
+}
+
+std::size_t RVOSimulator::addObstacle(const std::vector<Vector2> &vertices,
+                                      std::size_t layer) {
+  if (layer < RVO_MAX_LAYERS && vertices.size() > 1U) {
     const std::size_t obstacleNo = obstacles_.size();
 
     for (std::size_t i = 0U; i < vertices.size(); ++i) {
-      Obstacle *const obstacle = new Obstacle();
-      obstacle->point_ = vertices[i];
+      obstacles_.push_back(new Obstacle());
+    }
 
-      if (i != 0U) {
-        obstacle->previous_ = obstacles_.back();
-        obstacle->previous_->next_ = obstacle;
-      }
+    setObstacleVertices(obstacleNo, vertices, layer);
+
+    return obstacleNo;
+  }
+
+  return RVO_ERROR;
+}
+
+void RVOSimulator::buildObstacleDistanceField(float cellSize, float maxRange) {
+  kdTree_->buildDistanceField(cellSize, maxRange);
+}
+
+void RVOSimulator::calibrateThreadTeams(std::size_t maxNumThreads) {
+  threadTeamBarrierTimes_.clear();
+  threadTeamForkTimes_.clear();
+  threadTeamSizes_.clear();
+
+#ifdef _OPENMP
+  std::size_t numThreads = 1U;
+
+  while (numThreads < maxNumThreads) {
+    numThreads = std::min(2U * numThreads, maxNumThreads);
 
-      if (i == vertices.size() - 1U) {
-        obstacle->next_ = obstacles_[obstacleNo];
-        obstacle->next_->previous_ = obstacle;
+    double forkTime = std::numeric_limits<double>::infinity();
+    double teamTime = std::numeric_limits<double>::infinity();
+
+    for (int i = 0; i < RVO_PARALLELISM_NUM_TRIALS; ++i) {
+      const double startTime = getMonotonicTime();
+
+#pragma omp parallel num_threads(static_cast<int>(numThreads))
+      {
       }
 
-      obstacle->direction_ = normalize(
-          vertices[(i == vertices.size() - 1U ? 0U : i + 1U)] - vertices[i]);
+      const double forkEndTime = getMonotonicTime();
 
-      if (vertices.size() == 2U) {
-        obstacle->isConvex_ = true;
-      } else {
-        obstacle->isConvex_ =
-            leftOf(vertices[i == 0U ? vertices.size() - 1U : i - 1U],
-                   vertices[i],
-                   vertices[i == vertices.size() - 1U ? 0U : i + 1U]) >= 0.0F;
+#pragma omp parallel num_threads(static_cast<int>(numThreads))
+      for (int j = 0; j < RVO_PARALLELISM_NUM_BARRIERS; ++j) {
+#pragma omp barrier
       }
 
-      obstacle->id_ = obstacles_.size();
+      const double endTime = getMonotonicTime();
 
-      obstacles_.push_back(obstacle);
+      forkTime = std::min(forkTime, forkEndTime - startTime);
+      teamTime = std::min(teamTime, endTime - forkEndTime);
     }
 
-    return obstacleNo;
+    threadTeamBarrierTimes_.push_back(
+        std::max(0.0, teamTime - forkTime) / RVO_PARALLELISM_NUM_BARRIERS);
+    threadTeamForkTimes_.push_back(forkTime);
+    threadTeamSizes_.push_back(numThreads);
   }
+#else
+  static_cast<void>(maxNumThreads);
+#endif /* _OPENMP */
+}
 
-  return RVO_ERROR;
+void RVOSimulator::computeAgentVelocity(Agent *agent) {
+  agent->isDeferred_ = !agent->isKinematic_ &&
+                      stepDeadline_ < std::numeric_limits<double>::infinity() &&
+                      getMonotonicTime() > stepDeadline_;
+
+  if (agent->isKinematic_ || agent->isDeferred_) {
+    /* Moved with the velocity set by the caller, or extrapolated. */
+    agent->newVelocity_ = agent->velocity_;
+    return;
+  }
+
+  Agent *scratchAgent = NULL;
+
+  /* The adaptive time step is computed from the neighbor lists. */
+  if (!agent->isIntrospectionEnabled_ && maxTimeStep_ <= 0.0F) {
+    /* Compute in the scratch buffers of this thread. */
+#ifdef _OPENMP
+    scratchAgent = scratchAgents_[omp_get_thread_num()];
+#else
+    scratchAgent = scratchAgents_[0];
+#endif /* _OPENMP */
+    agent->swapBuffers(scratchAgent);
+  }
+
+  Vector2 perturbation;
+
+  if (perturbationMagnitude_ > 0.0F) {
+    /* Key the generator by the agent and step, so that the perturbations do
+     * not depend on the count of threads. */
+    const std::pair<unsigned int, unsigned int> randomNumbers =
+        computePhilox(static_cast<unsigned int>(agent->id_),
+                      static_cast<unsigned int>(numSteps_), perturbationSeed_);
+    const float angle = static_cast<float>(randomNumbers.first) *
+                        (RVO_TWO_PI / 4294967296.0F);
+    const float dist = static_cast<float>(randomNumbers.second) *
+                       (perturbationMagnitude_ / 4294967296.0F);
+    perturbation = dist * Vector2(std::cos(angle), std::sin(angle));
+  }
+
+  agent->computeNeighbors(kdTree_);
+
+  if (prefVelocityCallback_ != NULL) {
+    agent->prefVelocity_ =
+        prefVelocityCallback_(this, agent->id_, prefVelocityCallbackContext_);
+  }
+
+  agent->computeNewVelocity(timeStep_, isConstraintPruningEnabled_,
+                            perturbation);
+
+  if (scratchAgent != NULL) {
+    agent->swapBuffers(scratchAgent);
+  }
 }
 
-void RVOSimulator::doStep() {
-  kdTree_->buildAgentTree();
+void RVOSimulator::computeQualityMetrics() {
+  float maxRadius = 0.0F;
 
 #ifdef _OPENMP
-#pragma omp parallel for
+#pragma omp single copyprivate(maxRadius)
 #endif /* _OPENMP */
-  for (int i = 0; i < static_cast<int>(agents_.size()); ++i) {
-    agents_[i]->computeNeighbors(kdTree_);
-    agents_[i]->computeNewVelocity(timeStep_);
+  {
+    for (std::size_t i = 0U; i < agents_.size(); ++i) {
+      maxRadius = std::max(maxRadius, agents_[i]->radius_);
+    }
+
+    agentClearances_.assign(agents_.size(),
+                            std::numeric_limits<float>::infinity());
+    agentNumPenetrations_.assign(agents_.size(), 0U);
+    agentObstacleClearances_.assign(agents_.size(),
+                                    std::numeric_limits<float>::infinity());
+    agentPenetrationDepths_.assign(agents_.size(), 0.0F);
   }
 
 #ifdef _OPENMP
-#pragma omp parallel for
+#pragma omp for
 #endif /* _OPENMP */
   for (int i = 0; i < static_cast<int>(agents_.size()); ++i) {
-    agents_[i]->update(timeStep_);
+    const Agent *const agent = agents_[i];
+
+    kdTree_->computeAgentClearance(agent, maxRadius, agentClearances_[i],
+                                   agentNumPenetrations_[i],
+                                   agentPenetrationDepths_[i]);
+
+    float distSq = std::numeric_limits<float>::infinity();
+    const Obstacle *obstacle = NULL;
+    kdTree_->computeNearestObstacle(agent->position_, agent->layer_, distSq,
+                                    obstacle);
+
+    if (distSq < std::numeric_limits<float>::infinity()) {
+      /* An agent whose center lies inside an obstacle penetrates it by more
+       * than its radius. */
+      const float dist = std::sqrt(distSq);
+      agentObstacleClearances_[i] =
+          (kdTree_->isInsideObstacle(agent->position_, agent->layer_) ? -dist
+                                                                      : dist) -
+          agent->radius_;
+    }
+
+    distSq = std::numeric_limits<float>::infinity();
+    const BoxObstacle *boxObstacle = NULL;
+    kdTree_->computeNearestBoxObstacle(agent->position_, agent->layer_,
+                                       distSq, boxObstacle);
+
+    if (distSq < std::numeric_limits<float>::infinity()) {
+      agentObstacleClearances_[i] =
+          std::min(agentObstacleClearances_[i],
+                   std::sqrt(distSq) - agent->radius_);
+    }
   }
 
-  globalTime_ += timeStep_;
+  /* Reduce serially, as OpenMP 2.0 has no min reduction. */
+#ifdef _OPENMP
+#pragma omp single
+#endif /* _OPENMP */
+  {
+    numAgentPenetrations_ = 0U;
+    numObstaclePenetrations_ = 0U;
+    minClearance_ = std::numeric_limits<float>::infinity();
+    penetrationDepth_ = 0.0F;
+
+    for (std::size_t i = 0U; i < agents_.size(); ++i) {
+      numAgentPenetrations_ += agentNumPenetrations_[i];
+      penetrationDepth_ += agentPenetrationDepths_[i];
+      minClearance_ =
+          std::min(minClearance_, std::min(agentClearances_[i],
+                                           agentObstacleClearances_[i]));
+
+      if (agentObstacleClearances_[i] < 0.0F) {
+        ++numObstaclePenetrations_;
+        penetrationDepth_ -= agentObstacleClearances_[i];
+      }
+    }
+  }
+}
+
+void RVOSimulator::deleteObstacles() {
+  for (std::size_t i = 0U; i < obstacles_.size(); ++i) {
+    if (!obstacles_[i]->isInBlock_) {
+      delete obstacles_[i];
+    }
+  }
+
+  for (std::size_t i = 0U; i < obstacleBlocks_.size(); ++i) {
+    delete[] obstacleBlocks_[i];
+  }
+
+  obstacleBlocks_.clear();
+  obstacles_.clear();
+}
+
+std::size_t RVOSimulator::doBudgetedStep(float budget) {
+  /* Choose the team of threads, which may calibrate the thread teams, before
+   * the budget starts. doSteps then chooses the same team. */
+  selectParallelism(1U);
+  stepDeadline_ = getMonotonicTime() + budget;
+
+  /* Order the agents by decreasing priority, and agents of equal priority by
+   * their numbers. */
+  std::vector<std::pair<float, std::size_t> > priorities(agents_.size());
+
+  for (std::size_t i = 0U; i < agents_.size(); ++i) {
+    priorities[i] = std::make_pair(-agents_[i]->priority_, i);
+  }
+
+  std::sort(priorities.begin(), priorities.end());
+  prioritizedAgents_.resize(agents_.size());
+
+  for (std::size_t i = 0U; i < agents_.size(); ++i) {
+    prioritizedAgents_[i] = agents_[priorities[i].second];
+  }
+
+  doSteps(1U, NULL, NULL);
+  stepDeadline_ = std::numeric_limits<double>::infinity();
+
+  return numDeferredAgents_;
+}
+
+void RVOSimulator::doStep() { doSteps(1U, NULL, NULL); }
+
+std::size_t RVOSimulator::doSteps(std::size_t numSteps, StepCallback callback,
+                                  void *context) {
+  std::size_t numStepsDone = 0U;
+  bool isRunning = numSteps > 0U;
+
+  /* Within a budget, the agents are visited in the order of their priorities
+   * so that those of lowest priority are deferred. */
+  const bool isBudgeted =
+      stepDeadline_ < std::numeric_limits<double>::infinity();
+  const std::vector<Agent *> &velocityAgents =
+      isBudgeted ? prioritizedAgents_ : agents_;
+
+  while (isRunning) {
+    const std::size_t numTeamSteps =
+        selectParallelism(numSteps - numStepsDone);
+    std::size_t numTeamStepsDone = 0U;
+    double stepStartTime = 0.0;
+    double velocityEndTime = 0.0;
+
+    /* Keep one team of threads for several steps. The implicit barriers of
+     * the work-sharing constructs separate the phases of each step, and
+     * phases run in serial are merged into the adjacent single constructs. */
+#ifdef _OPENMP
+#pragma omp parallel num_threads(static_cast<int>(numThreads_)) if ( \
+        numThreads_ > 1U)
+#endif /* _OPENMP */
+    {
+      while (isRunning && numTeamStepsDone < numTeamSteps) {
+        const bool isVelocityParallel =
+            agents_.size() >= parallelVelocityThreshold_;
+        const bool isUpdateParallel =
+            agents_.size() >= parallelUpdateThreshold_;
+
+#ifdef _OPENMP
+#pragma omp single
+#endif /* _OPENMP */
+        {
+          const double buildStartTime = getMonotonicTime();
+          kdTree_->buildAgentTree();
+
+#ifdef _OPENMP
+          const std::size_t numThreads =
+              static_cast<std::size_t>(omp_get_num_threads());
+#else
+          const std::size_t numThreads = 1U;
+#endif /* _OPENMP */
+
+          while (scratchAgents_.size() < numThreads) {
+            scratchAgents_.push_back(new Agent());
+          }
+
+          stepStartTime = getMonotonicTime();
+          stepBuildTime_ = stepStartTime - buildStartTime;
+
+          if (!isVelocityParallel) {
+            for (std::size_t i = 0U; i < velocityAgents.size(); ++i) {
+              computeAgentVelocity(velocityAgents[i]);
+            }
+          }
+        }
+
+        if (isVelocityParallel && isBudgeted) {
+          /* Deal the agents out one by one, so that all threads reach the
+           * deadline at about the same priority. */
+#ifdef _OPENMP
+#pragma omp for schedule(static, 1)
+#endif /* _OPENMP */
+          for (int i = 0; i < static_cast<int>(velocityAgents.size()); ++i) {
+            computeAgentVelocity(velocityAgents[i]);
+          }
+        } else if (isVelocityParallel) {
+#ifdef _OPENMP
+#pragma omp for
+#endif /* _OPENMP */
+          for (int i = 0; i < static_cast<int>(agents_.size()); ++i) {
+            computeAgentVelocity(agents_[i]);
+          }
+        }
+
+        if (isUpdateParallel) {
+#ifdef _OPENMP
+#pragma omp master
+#endif /* _OPENMP */
+          velocityEndTime = getMonotonicTime();
+
+#ifdef _OPENMP
+#pragma omp for
+#endif /* _OPENMP */
+          for (int i = 0; i < static_cast<int>(agents_.size()); ++i) {
+            agents_[i]->update(timeStep_, isInterpolationEnabled_);
+          }
+        }
+
+#ifdef _OPENMP
+#pragma omp single
+#endif /* _OPENMP */
+        {
+          if (!isUpdateParallel) {
+            velocityEndTime = getMonotonicTime();
+
+            for (std::size_t i = 0U; i < agents_.size(); ++i) {
+              agents_[i]->update(timeStep_, isInterpolationEnabled_);
+            }
+          }
+
+          stepUpdateTime_ = getMonotonicTime() - velocityEndTime;
+          stepVelocityTime_ = velocityEndTime - stepStartTime;
+          numDeferredAgents_ = 0U;
+
+          if (isBudgeted) {
+            for (std::size_t i = 0U; i < agents_.size(); ++i) {
+              if (agents_[i]->isDeferred_) {
+                ++numDeferredAgents_;
+              }
+            }
+          }
+
+          /* Deferred agents would make the phases seem cheaper, so the new
+           * velocities are costed per agent solved. */
+          recordPhaseTimes(stepVelocityTime_, stepUpdateTime_,
+                           agents_.size() - numDeferredAgents_,
+                           isVelocityParallel, isUpdateParallel);
+
+          /* Keep the agent k-D tree valid for the spatial queries. */
+          kdTree_->refitAgentTree();
+
+          globalTime_ += timeStep_;
+          ++numSteps_;
+        }
+
+        if (isQualityMetricsEnabled_) {
+          computeQualityMetrics();
+        }
+
+        if (maxTimeStep_ > 0.0F) {
+          adaptTimeStep();
+        }
+
+#ifdef _OPENMP
+#pragma omp single
+#endif /* _OPENMP */
+        {
+          ++numStepsDone;
+          ++numTeamStepsDone;
+          isRunning = numStepsDone < numSteps &&
+                      (callback == NULL || callback(this, context));
+        }
+      }
+    }
+  }
+
+  return numStepsDone;
+}
+
+std::size_t RVOSimulator::getAdaptiveNeighborCount() const {
+  return kdTree_->adaptiveNeighborCount_;
 }
 
 std::size_t RVOSimulator::getAgentAgentNeighbor(std::size_t agentNo,
@@ -219,6 +1039,23 @@ std::size_t RVOSimulator::getAgentAgentNeighbor(std::size_t agentNo,
   return agents_[agentNo]->agentNeighbors_[neighborNo].second->id_;
 }
 
+std::size_t RVOSimulator::getAgentBoxObstacleNeighbor(
+    std::size_t agentNo, std::size_t neighborNo) const {
+  return agents_[agentNo]->boxObstacleNeighbors_[neighborNo].second->id_;
+}
+
+unsigned int RVOSimulator::getAgentCollisionGroups(std::size_t agentNo) const {
+  return agents_[agentNo]->collisionGroups_;
+}
+
+unsigned int RVOSimulator::getAgentCollisionMask(std::size_t agentNo) const {
+  return agents_[agentNo]->collisionMask_;
+}
+
+std::size_t RVOSimulator::getAgentLayer(std::size_t agentNo) const {
+  return agents_[agentNo]->layer_;
+}
+
 std::size_t RVOSimulator::getAgentMaxNeighbors(std::size_t agentNo) const {
   return agents_[agentNo]->maxNeighbors_;
 }
@@ -235,15 +1072,40 @@ std::size_t RVOSimulator::getAgentNumAgentNeighbors(std::size_t agentNo) const {
   return agents_[agentNo]->agentNeighbors_.size();
 }
 
+std::size_t RVOSimulator::getAgentNumBoxObstacleNeighbors(
+    std::size_t agentNo) const {
+  return agents_[agentNo]->boxObstacleNeighbors_.size();
+}
+
+std::size_t RVOSimulator::getAgentNumClusterNeighbors(
+    std::size_t agentNo) const {
+  return agents_[agentNo]->clusterNeighbors_.size();
+}
+
+std::size_t RVOSimulator::getAgentNumObstacleEdgesTested(
+    std::size_t agentNo) const {
+  return agents_[agentNo]->numObstacleEdgesTested_;
+}
+
 std::size_t RVOSimulator::getAgentNumObstacleNeighbors(
     std::size_t agentNo) const {
   return agents_[agentNo]->obstacleNeighbors_.size();
 }
 
+std::size_t RVOSimulator::getAgentNumObstacleTreeNodesVisited(
+    std::size_t agentNo) const {
+  return agents_[agentNo]->numObstacleTreeNodesVisited_;
+}
+
 std::size_t RVOSimulator::getAgentNumORCALines(std::size_t agentNo) const {
   return agents_[agentNo]->orcaLines_.size();
 }
 
+std::size_t RVOSimulator::getAgentNumPrunedORCALines(
+    std::size_t agentNo) const {
+  return agents_[agentNo]->numPrunedORCALines_;
+}
+
 std::size_t RVOSimulator::getAgentObstacleNeighbor(
     std::size_t agentNo, std::size_t neighborNo) const {
   return agents_[agentNo]->obstacleNeighbors_[neighborNo].second->id_;
@@ -262,6 +1124,15 @@ const Vector2 &RVOSimulator::getAgentPrefVelocity(std::size_t agentNo) const {
   return agents_[agentNo]->prefVelocity_;
 }
 
+const Vector2 &RVOSimulator::getAgentPreviousPosition(
+    std::size_t agentNo) const {
+  return agents_[agentNo]->previousPosition_;
+}
+
+float RVOSimulator::getAgentPriority(std::size_t agentNo) const {
+  return agents_[agentNo]->priority_;
+}
+
 float RVOSimulator::getAgentRadius(std::size_t agentNo) const {
   return agents_[agentNo]->radius_;
 }
@@ -278,6 +1149,68 @@ const Vector2 &RVOSimulator::getAgentVelocity(std::size_t agentNo) const {
   return agents_[agentNo]->velocity_;
 }
 
+std::size_t RVOSimulator::getBoxObstacleLayer(
+    std::size_t boxObstacleNo) const {
+  return kdTree_->boxObstacles_[kdTree_->boxObstacleIndices_[boxObstacleNo]]
+      .layer_;
+}
+
+const Vector2 &RVOSimulator::getBoxObstacleMaxCorner(
+    std::size_t boxObstacleNo) const {
+  return kdTree_->boxObstacles_[kdTree_->boxObstacleIndices_[boxObstacleNo]]
+      .maxCorner_;
+}
+
+const Vector2 &RVOSimulator::getBoxObstacleMinCorner(
+    std::size_t boxObstacleNo) const {
+  return kdTree_->boxObstacles_[kdTree_->boxObstacleIndices_[boxObstacleNo]]
+      .minCorner_;
+}
+
+float RVOSimulator::getClusterProxyRatio() const {
+  return kdTree_->clusterProxyRatio_;
+}
+
+void RVOSimulator::getInterpolatedPositions(
+    float alpha, std::vector<Vector2> &positions) const {
+  positions.resize(agents_.size());
+
+  if (!isInterpolationEnabled_) {
+    for (std::size_t i = 0U; i < agents_.size(); ++i) {
+      positions[i] = agents_[i]->position_;
+    }
+
+    return;
+  }
+
+  for (std::size_t i = 0U; i < agents_.size(); ++i) {
+    const Agent *const agent = agents_[i];
+    positions[i] = agent->previousPosition_ +
+                   alpha * (agent->position_ - agent->previousPosition_);
+  }
+}
+
+std::size_t RVOSimulator::getNumBoxObstacles() const {
+  return kdTree_->boxObstacles_.size();
+}
+
+std::size_t RVOSimulator::getNumObstacleSplitVertices() const {
+  return kdTree_->numObstacleSplits_;
+}
+
+std::size_t RVOSimulator::getNumObstacleTreeNodes() const {
+  std::size_t numNodes;
+  std::size_t depth;
+  std::size_t sumDepth;
+  kdTree_->computeObstacleTreeStats(numNodes, depth, sumDepth);
+
+  return numNodes;
+}
+
+std::size_t RVOSimulator::getObstacleLayer(std::size_t vertexNo) const {
+  return obstacles_[vertexNo]->layer_;
+}
+
 const Vector2 &RVOSimulator::getObstacleVertex(std::size_t vertexNo) const {
   return obstacles_[vertexNo]->point_;
 }
@@ -290,16 +1223,421 @@ std::size_t RVOSimulator::getPrevObstacleVertexNo(std::size_t vertexNo) const {
   return obstacles_[vertexNo]->previous_->id_;
 }
 
-void RVOSimulator::processObstacles() { kdTree_->buildObstacleTree(); }
+std::size_t RVOSimulator::getObstacleTreeDepth() const {
+  std::size_t numNodes;
+  std::size_t depth;
+  std::size_t sumDepth;
+  kdTree_->computeObstacleTreeStats(numNodes, depth, sumDepth);
+
+  return depth;
+}
+
+float RVOSimulator::getObstacleTreeMeanDepth() const {
+  std::size_t numNodes;
+  std::size_t depth;
+  std::size_t sumDepth;
+  kdTree_->computeObstacleTreeStats(numNodes, depth, sumDepth);
+
+  return numNodes > 0U ? static_cast<float>(sumDepth) /
+                             static_cast<float>(numNodes)
+                       : 0.0F;
+}
+
+float RVOSimulator::getObstacleTreeMeanNodesVisited() const {
+  std::size_t numQueries = 0U;
+  std::size_t numNodesVisited = 0U;
+
+  /* A query using the obstacle k-D tree visits at least its root. */
+  for (std::size_t i = 0U; i < agents_.size(); ++i) {
+    if (agents_[i]->numObstacleTreeNodesVisited_ > 0U) {
+      ++numQueries;
+      numNodesVisited += agents_[i]->numObstacleTreeNodesVisited_;
+    }
+  }
+
+  return numQueries > 0U ? static_cast<float>(numNodesVisited) /
+                               static_cast<float>(numQueries)
+                         : 0.0F;
+}
+
+bool RVOSimulator::isAgentDeferred(std::size_t agentNo) const {
+  return agents_[agentNo]->isDeferred_;
+}
+
+bool RVOSimulator::isAgentIntrospectionEnabled(std::size_t agentNo) const {
+  return agents_[agentNo]->isIntrospectionEnabled_;
+}
+
+bool RVOSimulator::isAgentKinematic(std::size_t agentNo) const {
+  return agents_[agentNo]->isKinematic_;
+}
+
+std::size_t RVOSimulator::loadObstacles(const char *filename, bool process) {
+  return loadObstacles(filename, 0U, process);
+}
+
+std::size_t RVOSimulator::loadObstacles(const char *filename,
+                                        std::size_t layer, bool process) {
+  if (layer >= RVO_MAX_LAYERS) {
+    return RVO_ERROR;
+  }
+
+  const WkbReader reader(filename);
+
+  if (!reader.isValid_) {
+    return RVO_ERROR;
+  }
+
+  if (reader.numVertices_ != 0U) {
+    Obstacle *const block = new Obstacle[reader.numVertices_];
+    obstacleBlocks_.push_back(block);
+
+    /* Mark the vertices of the block so that they are deleted with the block
+     * rather than individually. */
+    for (std::size_t i = 0U; i < reader.numVertices_; ++i) {
+      block[i].isInBlock_ = true;
+    }
+
+    obstacles_.reserve(obstacles_.size() + reader.numVertices_);
+
+    /* Reuse the vertex list across rings to avoid reallocation. */
+    std::vector<Vector2> vertices;
+    std::size_t blockNo = 0U;
+
+    for (std::size_t i = 0U; i < reader.rings_.size(); ++i) {
+      reader.readRing(i, vertices);
+
+      const std::size_t obstacleNo = obstacles_.size();
+
+      for (std::size_t j = 0U; j < vertices.size(); ++j) {
+        obstacles_.push_back(block + blockNo++);
+      }
+
+      setObstacleVertices(obstacleNo, vertices, layer);
+    }
+  }
+
+  if (process) {
+    processObstacles();
+  }
+
+  return reader.rings_.size();
+}
+
+void RVOSimulator::processObstacles() {
+  kdTree_->buildObstacleTree();
+  kdTree_->buildBoxObstacleTree();
+}
+
+std::size_t RVOSimulator::queryAgentsInRange(
+    const Vector2 &point, float range,
+    std::vector<std::size_t> &agentNos) const {
+  return queryAgentsInRange(point, range, 0U, agentNos);
+}
+
+std::size_t RVOSimulator::queryAgentsInRange(
+    const Vector2 &point, float range, std::size_t layer,
+    std::vector<std::size_t> &agentNos) const {
+  std::vector<std::pair<float, std::size_t> > agents;
+  float rangeSq = range * range;
+  kdTree_->computePointNeighbors(
+      point, layer, std::numeric_limits<std::size_t>::max(), rangeSq, agents);
+
+  agentNos.resize(agents.size());
+
+  for (std::size_t i = 0U; i < agents.size(); ++i) {
+    agentNos[i] = agents[i].second;
+  }
+
+  return agentNos.size();
+}
+
+void RVOSimulator::queryAgentsInRange(
+    const std::vector<Vector2> &points, float range,
+    std::vector<std::vector<std::size_t> > &agentNos) const {
+  queryAgentsInRange(points, range, 0U, agentNos);
+}
+
+void RVOSimulator::queryAgentsInRange(
+    const std::vector<Vector2> &points, float range, std::size_t layer,
+    std::vector<std::vector<std::size_t> > &agentNos) const {
+  agentNos.resize(points.size());
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 64)
+#endif /* _OPENMP */
+  for (int i = 0; i < static_cast<int>(points.size()); ++i) {
+    queryAgentsInRange(points[i], range, layer, agentNos[i]);
+  }
+}
+
+std::size_t RVOSimulator::queryNearestAgents(
+    const Vector2 &point, std::size_t numAgents,
+    std::vector<std::size_t> &agentNos) const {
+  return queryNearestAgents(point, numAgents, 0U, agentNos);
+}
+
+std::size_t RVOSimulator::queryNearestAgents(
+    const Vector2 &point, std::size_t numAgents, std::size_t layer,
+    std::vector<std::size_t> &agentNos) const {
+  std::vector<std::pair<float, std::size_t> > agents;
+  float rangeSq = std::numeric_limits<float>::max();
+  kdTree_->computePointNeighbors(point, layer, numAgents, rangeSq, agents);
+
+  agentNos.resize(agents.size());
+
+  for (std::size_t i = 0U; i < agents.size(); ++i) {
+    agentNos[i] = agents[i].second;
+  }
+
+  return agentNos.size();
+}
+
+void RVOSimulator::queryNearestAgents(
+    const std::vector<Vector2> &points, std::size_t numAgents,
+    std::vector<std::vector<std::size_t> > &agentNos) const {
+  queryNearestAgents(points, numAgents, 0U, agentNos);
+}
+
+void RVOSimulator::queryNearestAgents(
+    const std::vector<Vector2> &points, std::size_t numAgents,
+    std::size_t layer, std::vector<std::vector<std::size_t> > &agentNos) const {
+  agentNos.resize(points.size());
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 64)
+#endif /* _OPENMP */
+  for (int i = 0; i < static_cast<int>(points.size()); ++i) {
+    queryNearestAgents(points[i], numAgents, layer, agentNos[i]);
+  }
+}
+
+float RVOSimulator::queryNearestObstacle(const Vector2 &point,
+                                         std::size_t &obstacleNo) const {
+  return queryNearestObstacle(point, 0U, obstacleNo);
+}
+
+float RVOSimulator::queryNearestObstacle(const Vector2 &point,
+                                         std::size_t layer,
+                                         std::size_t &obstacleNo) const {
+  float distSq = std::numeric_limits<float>::infinity();
+  const Obstacle *obstacle = NULL;
+  kdTree_->computeNearestObstacle(point, layer, distSq, obstacle);
+
+  obstacleNo = obstacle != NULL ? obstacle->id_ : RVO_ERROR;
+
+  return std::sqrt(distSq);
+}
+
+void RVOSimulator::queryNearestObstacle(
+    const std::vector<Vector2> &points, std::vector<float> &distances,
+    std::vector<std::size_t> &obstacleNos) const {
+  distances.resize(points.size());
+  obstacleNos.resize(points.size());
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 64)
+#endif /* _OPENMP */
+  for (int i = 0; i < static_cast<int>(points.size()); ++i) {
+    distances[i] = queryNearestObstacle(points[i], obstacleNos[i]);
+  }
+}
+
+float RVOSimulator::queryRaycast(const Vector2 &origin,
+                                 const Vector2 &direction, float maxDist,
+                                 std::size_t &obstacleNo) const {
+  return queryRaycast(origin, direction, maxDist, 0U, obstacleNo);
+}
+
+float RVOSimulator::queryRaycast(const Vector2 &origin,
+                                 const Vector2 &direction, float maxDist,
+                                 std::size_t layer,
+                                 std::size_t &obstacleNo) const {
+  float distance = maxDist;
+  const Obstacle *obstacle = NULL;
+  kdTree_->computeRaycast(origin, normalize(direction), layer, distance,
+                          obstacle);
+
+  obstacleNo = obstacle != NULL ? obstacle->id_ : RVO_ERROR;
+
+  return distance;
+}
+
+void RVOSimulator::queryRaycast(const std::vector<Vector2> &origins,
+                                const std::vector<Vector2> &directions,
+                                float maxDist, std::vector<float> &distances,
+                                std::vector<std::size_t> &obstacleNos) const {
+  distances.resize(origins.size());
+  obstacleNos.resize(origins.size());
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 64)
+#endif /* _OPENMP */
+  for (int i = 0; i < static_cast<int>(origins.size()); ++i) {
+    distances[i] =
+        queryRaycast(origins[i], directions[i], maxDist, obstacleNos[i]);
+  }
+}
 
 bool RVOSimulator::queryVisibility(const Vector2 &point1,
                                    const Vector2 &point2) const {
-  return kdTree_->queryVisibility(point1, point2, 0.0F);
+  std::size_t numNodesVisited = 0U;
+
+  return kdTree_->queryVisibility(point1, point2, 0.0F, 0U, numNodesVisited);
 }
 
 bool RVOSimulator::queryVisibility(const Vector2 &point1, const Vector2 &point2,
                                    float radius) const {
-  return kdTree_->queryVisibility(point1, point2, radius);
+  std::size_t numNodesVisited = 0U;
+
+  return kdTree_->queryVisibility(point1, point2, radius, 0U, numNodesVisited);
+}
+
+bool RVOSimulator::queryVisibility(const Vector2 &point1, const Vector2 &point2,
+                                   float radius,
+                                   std::size_t &numNodesVisited) const {
+  return queryVisibility(point1, point2, radius, 0U, numNodesVisited);
+}
+
+bool RVOSimulator::queryVisibility(const Vector2 &point1, const Vector2 &point2,
+                                   float radius, std::size_t layer,
+                                   std::size_t &numNodesVisited) const {
+  numNodesVisited = 0U;
+
+  return kdTree_->queryVisibility(point1, point2, radius, layer,
+                                  numNodesVisited);
+}
+
+void RVOSimulator::recordPhaseTimes(double velocityTime, double updateTime,
+                                    std::size_t numVelocityAgents,
+                                    bool isVelocityParallel,
+                                    bool isUpdateParallel) {
+  if (numVelocityAgents == 0U) {
+    return;
+  }
+
+  /* Remove the barriers that end each phase, and scale the phases that ran in
+   * parallel to one thread. */
+  const double numAgents = static_cast<double>(agents_.size());
+  const double numThreads = static_cast<double>(numThreads_);
+  const double agentVelocityTime =
+      std::max(0.0, velocityTime - (isVelocityParallel ? 2.0 : 1.0) *
+                                       barrierTime_) *
+      (isVelocityParallel ? numThreads : 1.0) /
+      static_cast<double>(numVelocityAgents);
+  const double agentUpdateTime =
+      std::max(0.0, updateTime - (isUpdateParallel ? barrierTime_ : 0.0)) *
+      (isUpdateParallel ? numThreads : 1.0) / numAgents;
+
+  if (agentVelocityTime_ <= 0.0) {
+    agentUpdateTime_ = agentUpdateTime;
+    agentVelocityTime_ = agentVelocityTime;
+  } else {
+    agentUpdateTime_ += RVO_PARALLELISM_SMOOTHING *
+                        (agentUpdateTime - agentUpdateTime_);
+    agentVelocityTime_ += RVO_PARALLELISM_SMOOTHING *
+                          (agentVelocityTime - agentVelocityTime_);
+  }
+}
+
+std::size_t RVOSimulator::selectParallelism(std::size_t numSteps) {
+  numThreads_ = 1U;
+  parallelUpdateThreshold_ = std::numeric_limits<std::size_t>::max();
+  parallelVelocityThreshold_ = std::numeric_limits<std::size_t>::max();
+  barrierTime_ = 0.0;
+
+#ifdef _OPENMP
+  const std::size_t maxNumThreads =
+      static_cast<std::size_t>(omp_get_max_threads());
+
+  if (!isAutomaticParallelismEnabled_) {
+    numThreads_ = maxNumThreads;
+    parallelUpdateThreshold_ = 0U;
+    parallelVelocityThreshold_ = 0U;
+
+    return numSteps;
+  }
+
+  /* Threads beyond the count of processors share them and only add to the
+   * cost of synchronization. */
+  const std::size_t maxNumUsefulThreads = std::min(
+      maxNumThreads, static_cast<std::size_t>(omp_get_num_procs()));
+
+  if (maxNumUsefulThreads <= 1U) {
+    return numSteps;
+  }
+
+  if (agentVelocityTime_ <= 0.0) {
+    /* Estimate the costs per agent on one thread first. */
+    return 1U;
+  }
+
+  if (threadTeamSizes_.empty() ||
+      threadTeamSizes_.back() != maxNumUsefulThreads) {
+    calibrateThreadTeams(maxNumUsefulThreads);
+  }
+
+  numSteps = std::min(numSteps, RVO_PARALLELISM_NUM_STEPS);
+
+  /* Each step synchronizes after building the agent k-D tree, refitting it,
+   * and calling the step callback, and three times each for the quality
+   * metrics and the adaptive time step. */
+  const double numBarriers = 3.0 + (isQualityMetricsEnabled_ ? 3.0 : 0.0) +
+                             (maxTimeStep_ > 0.0F ? 3.0 : 0.0);
+  const double numAgents = static_cast<double>(agents_.size());
+  const double velocityTime = numAgents * agentVelocityTime_;
+  const double updateTime = numAgents * agentUpdateTime_;
+  double minStepTime = velocityTime + updateTime;
+
+  for (std::size_t i = 0U; i < threadTeamSizes_.size(); ++i) {
+    const double barrierTime = threadTeamBarrierTimes_[i];
+    const double numThreads = static_cast<double>(threadTeamSizes_[i]);
+    const std::size_t velocityThreshold = computeParallelThreshold(
+        agentVelocityTime_, barrierTime, threadTeamSizes_[i]);
+    const std::size_t updateThreshold = computeParallelThreshold(
+        agentUpdateTime_, barrierTime, threadTeamSizes_[i]);
+
+    /* Starting the team is shared by the steps it performs. */
+    double stepTime = threadTeamForkTimes_[i] / static_cast<double>(numSteps) +
+                      numBarriers * barrierTime;
+    stepTime += agents_.size() >= velocityThreshold
+                    ? velocityTime / numThreads + barrierTime
+                    : velocityTime;
+    stepTime += agents_.size() >= updateThreshold
+                    ? updateTime / numThreads + barrierTime
+                    : updateTime;
+
+    if (stepTime < minStepTime) {
+      minStepTime = stepTime;
+      numThreads_ = threadTeamSizes_[i];
+      parallelUpdateThreshold_ = updateThreshold;
+      parallelVelocityThreshold_ = velocityThreshold;
+      barrierTime_ = barrierTime;
+    }
+  }
+#endif /* _OPENMP */
+
+  return numSteps;
+}
+
+void RVOSimulator::setAdaptiveNeighborCount(
+    std::size_t adaptiveNeighborCount) {
+  kdTree_->adaptiveNeighborCount_ = adaptiveNeighborCount;
+}
+
+void RVOSimulator::setAdaptiveTimeStep(float minTimeStep, float maxTimeStep) {
+  minTimeStep_ = minTimeStep;
+  maxTimeStep_ = maxTimeStep;
+}
+
+void RVOSimulator::setAgentCollisionGroups(std::size_t agentNo,
+                                           unsigned int collisionGroups) {
+  agents_[agentNo]->collisionGroups_ = collisionGroups;
+}
+
+void RVOSimulator::setAgentCollisionMask(std::size_t agentNo,
+                                         unsigned int collisionMask) {
+  agents_[agentNo]->collisionMask_ = collisionMask;
 }
 
 void RVOSimulator::setAgentDefaults(float neighborDist,
@@ -327,6 +1665,35 @@ void RVOSimulator::setAgentDefaults(float neighborDist,
   defaultAgent_->velocity_ = velocity;
 }
 
+void RVOSimulator::setAgentIntrospectionEnabled(std::size_t agentNo,
+                                                bool isIntrospectionEnabled) {
+  Agent *const agent = agents_[agentNo];
+  agent->isIntrospectionEnabled_ = isIntrospectionEnabled;
+
+  if (!isIntrospectionEnabled) {
+    /* Release the retained lists. */
+    Agent emptyAgent;
+    agent->swapBuffers(&emptyAgent);
+  }
+}
+
+void RVOSimulator::setAgentKinematic(std::size_t agentNo, bool isKinematic) {
+  Agent *const agent = agents_[agentNo];
+  agent->isKinematic_ = isKinematic;
+
+  if (isKinematic) {
+    /* Release the lists of the last solve. */
+    Agent emptyAgent;
+    agent->swapBuffers(&emptyAgent);
+    agent->numPrunedORCALines_ = 0U;
+    agent->isInfeasible_ = false;
+  }
+}
+
+void RVOSimulator::setAgentLayer(std::size_t agentNo, std::size_t layer) {
+  agents_[agentNo]->layer_ = layer;
+}
+
 void RVOSimulator::setAgentMaxNeighbors(std::size_t agentNo,
                                         std::size_t maxNeighbors) {
   agents_[agentNo]->maxNeighbors_ = maxNeighbors;
@@ -344,6 +1711,8 @@ void RVOSimulator::setAgentNeighborDist(std::size_t agentNo,
 void RVOSimulator::setAgentPosition(std::size_t agentNo,
                                     const Vector2 &position) {
   agents_[agentNo]->position_ = position;
+  agents_[agentNo]->previousPosition_ = position;
+  kdTree_->refitAgentTree();
 }
 
 void RVOSimulator::setAgentPrefVelocity(std::size_t agentNo,
@@ -351,10 +1720,27 @@ void RVOSimulator::setAgentPrefVelocity(std::size_t agentNo,
   agents_[agentNo]->prefVelocity_ = prefVelocity;
 }
 
+void RVOSimulator::setAgentPriority(std::size_t agentNo, float priority) {
+  agents_[agentNo]->priority_ = priority;
+}
+
 void RVOSimulator::setAgentRadius(std::size_t agentNo, float radius) {
   agents_[agentNo]->radius_ = radius;
 }
 
+void RVOSimulator::setAgentStates(const std::vector<std::size_t> &agentNos,
+                                  const std::vector<Vector2> &positions,
+                                  const std::vector<Vector2> &velocities) {
+  for (std::size_t i = 0U; i < agentNos.size(); ++i) {
+    Agent *const agent = agents_[agentNos[i]];
+    agent->position_ = positions[i];
+    agent->previousPosition_ = positions[i];
+    agent->velocity_ = velocities[i];
+  }
+
+  kdTree_->refitAgentTree();
+}
+
 void RVOSimulator::setAgentTimeHorizon(std::size_t agentNo, float timeHorizon) {
   agents_[agentNo]->timeHorizon_ = timeHorizon;
 }
@@ -368,4 +1754,185 @@ void RVOSimulator::setAgentVelocity(std::size_t agentNo,
                                     const Vector2 &velocity) {
   agents_[agentNo]->velocity_ = velocity;
 }
+
+void RVOSimulator::setClusterProxyRatio(float clusterProxyRatio) {
+  /* An agent must lie outside every cluster proxy that it avoids. */
+  kdTree_->clusterProxyRatio_ =
+      std::min(clusterProxyRatio, 1.0F - RVO_EPSILON);
+}
+
+void RVOSimulator::setInterpolationEnabled(bool isInterpolationEnabled) {
+  isInterpolationEnabled_ = isInterpolationEnabled;
+
+  for (std::size_t i = 0U; i < agents_.size(); ++i) {
+    agents_[i]->previousPosition_ = agents_[i]->position_;
+  }
+}
+
+void RVOSimulator::setIntrospectionEnabled(bool isIntrospectionEnabled) {
+  isIntrospectionEnabled_ = isIntrospectionEnabled;
+
+  for (std::size_t i = 0U; i < agents_.size(); ++i) {
+    setAgentIntrospectionEnabled(i, isIntrospectionEnabled);
+  }
+}
+
+void RVOSimulator::setObstacleVertices(std::size_t obstacleNo,
+                                       const std::vector<Vector2> &vertices,
+                                       std::size_t layer) {
+  for (std::size_t i = 0U; i < vertices.size(); ++i) {
+    Obstacle *const obstacle = obstacles_[obstacleNo + i];
+    obstacle->point_ = vertices[i];
+
+    if (i != 0U) {
+      obstacle->previous_ = obstacles_[obstacleNo + i - 1U];
+      obstacle->previous_->next_ = obstacle;
+    }
+
+    if (i == vertices.size() - 1U) {
+      obstacle->next_ = obstacles_[obstacleNo];
+      obstacle->next_->previous_ = obstacle;
+    }
+
+    obstacle->direction_ = normalize(
+        vertices[(i == vertices.size() - 1U ? 0U : i + 1U)] - vertices[i]);
+
+    if (vertices.size() == 2U) {
+      obstacle->isConvex_ = true;
+    } else {
+      obstacle->isConvex_ =
+          leftOf(vertices[i == 0U ? vertices.size() - 1U : i - 1U],
+                 vertices[i],
+                 vertices[i == vertices.size() - 1U ? 0U : i + 1U]) >= 0.0F;
+    }
+
+    obstacle->id_ = obstacleNo + i;
+    obstacle->layer_ = layer;
+  }
+}
+
+void RVOSimulator::setPerturbation(float perturbationMagnitude,
+                                   unsigned int perturbationSeed) {
+  perturbationMagnitude_ = perturbationMagnitude;
+  perturbationSeed_ = perturbationSeed;
+}
+
+void RVOSimulator::setPrefVelocityCallback(PrefVelocityCallback callback,
+                                           void *context) {
+  prefVelocityCallback_ = callback;
+  prefVelocityCallbackContext_ = context;
+}
+
+void RVOSimulator::setQualityMetricsEnabled(bool isQualityMetricsEnabled) {
+  isQualityMetricsEnabled_ = isQualityMetricsEnabled;
+
+  if (!isQualityMetricsEnabled_) {
+    numAgentPenetrations_ = 0U;
+    numObstaclePenetrations_ = 0U;
+    minClearance_ = std::numeric_limits<float>::infinity();
+    penetrationDepth_ = 0.0F;
+  }
+}
+
+std::size_t RVOSimulator::simplifyObstacles(float tolerance) {
+  const float toleranceSq = tolerance * tolerance;
+  std::size_t numVertices = 0U;
+
+  /* Collect and simplify the polygon of each obstacle, leaving out the
+   * vertices added by splitting obstacle edges. */
+  std::vector<std::vector<Vector2> > polygons;
+  std::vector<std::size_t> layers;
+  std::vector<std::size_t> numPolygonVertices;
+  std::vector<bool> isCollected(obstacles_.size(), false);
+
+  for (std::size_t i = 0U; i < obstacles_.size(); ++i) {
+    if (!isCollected[i]) {
+      polygons.push_back(std::vector<Vector2>());
+      layers.push_back(obstacles_[i]->layer_);
+      const Obstacle *obstacle = obstacles_[i];
+
+      do {
+        if (!obstacle->isSplit_) {
+          polygons.back().push_back(obstacle->point_);
+          ++numVertices;
+        }
+
+        isCollected[obstacle->id_] = true;
+        obstacle = obstacle->next_;
+      } while (obstacle != obstacles_[i]);
+
+      numPolygonVertices.push_back(polygons.back().size());
+      simplifyPolygon(polygons.back(), toleranceSq);
+    }
+  }
+
+  /* Remove counterclockwise obstacles inside other counterclockwise
+   * obstacles on the same layer. */
+  std::vector<float> areas(polygons.size());
+  std::vector<Vector2> minCorners(polygons.size());
+  std::vector<Vector2> maxCorners(polygons.size());
+
+  for (std::size_t i = 0U; i < polygons.size(); ++i) {
+    areas[i] = computeSignedArea(polygons[i]);
+
+    if (!polygons[i].empty()) {
+      float minX = polygons[i][0U].x();
+      float minY = polygons[i][0U].y();
+      float maxX = minX;
+      float maxY = minY;
+
+      for (std::size_t j = 1U; j < polygons[i].size(); ++j) {
+        minX = std::min(minX, polygons[i][j].x());
+        minY = std::min(minY, polygons[i][j].y());
+        maxX = std::max(maxX, polygons[i][j].x());
+        maxY = std::max(maxY, polygons[i][j].y());
+      }
+
+      minCorners[i] = Vector2(minX, minY);
+      maxCorners[i] = Vector2(maxX, maxY);
+    }
+  }
+
+  std::vector<bool> isRemoved(polygons.size(), false);
+
+  for (std::size_t i = 0U; i < polygons.size(); ++i) {
+    /* Polygons whose vertices snap to fewer than three vertices are removed
+     * rather than kept as line segments, whereas line segments remain unless
+     * their vertices snap together. */
+    isRemoved[i] = polygons[i].size() < 2U ||
+                   (polygons[i].size() < 3U && numPolygonVertices[i] > 2U);
+
+    for (std::size_t j = 0U;
+         j < polygons.size() && !isRemoved[i] && areas[i] >= 0.0F; ++j) {
+      isRemoved[i] = i != j && !isRemoved[j] && layers[j] == layers[i] &&
+                     areas[j] > 0.0F && polygons[j].size() > 2U &&
+                     minCorners[j].x() <= minCorners[i].x() &&
+                     minCorners[j].y() <= minCorners[i].y() &&
+                     maxCorners[j].x() >= maxCorners[i].x() &&
+                     maxCorners[j].y() >= maxCorners[i].y() &&
+                     isPolygonInPolygon(polygons[i], polygons[j]);
+    }
+  }
+
+  /* Replace the obstacles with the simplified obstacles. */
+  for (std::size_t i = 0U; i < agents_.size(); ++i) {
+    agents_[i]->obstacleNeighbors_.clear();
+  }
+
+  deleteObstacles();
+
+  for (std::size_t i = 0U; i < polygons.size(); ++i) {
+    if (!isRemoved[i]) {
+      addObstacle(polygons[i], layers[i]);
+    }
+  }
+
+  const std::size_t numRemoved = numVertices - obstacles_.size();
+
+  if (!kdTree_->obstacleTrees_.empty()) {
+    kdTree_->buildObstacleTree();
+  }
+
+  return numRemoved;
+}
 } /* namespace RVO */
@@ -49,6 +49,7 @@ class Agent;
 class KdTree;
 class Line;
 class Obstacle;
+class RVOSimulator;
 class Vector2;
 
 /**
@@ -58,9 +59,51 @@ class Vector2;
  */
 RVO_EXPORT extern const std::size_t RVO_ERROR;
 
+/**
+ * @relates RVOSimulator
+ * @brief   The count of layers. Layers are numbered from zero to one less than
+ *          this count, as the k-D trees index them directly.
+ */
+RVO_EXPORT extern const std::size_t RVO_MAX_LAYERS;
+
+/**
+ * @relates   RVOSimulator
+ * @brief     A function that computes the preferred velocity of an agent in a
+ *            simulation step, called by the simulator in parallel for all
+ *            agents that are not kinematic.
+ * @param[in] simulator The simulator. The function may read the positions,
+ *                      velocities, and parameters other than the preferred
+ *                      velocity of any agent, but the neighbors of the
+ *                      specified agent only, as the neighbors and preferred
+ *                      velocities of other agents are computed concurrently.
+ *                      It must not modify the simulator.
+ * @param[in] agentNo   The number of the agent.
+ * @param[in] context   The context registered with the function.
+ * @return    The preferred velocity of the agent in the simulation step.
+ */
+typedef Vector2 (*PrefVelocityCallback)(const RVOSimulator *simulator,
+                                        std::size_t agentNo, void *context);
+
+/**
+ * @relates   RVOSimulator
+ * @brief     A function called after each simulation step performed by
+ *            RVOSimulator::doSteps except the last, by one thread while the
+ *            others wait.
+ * @param[in] simulator The simulator, which the function may modify, e.g., to
+ *                      set preferred velocities for the next simulation step.
+ * @param[in] context   The context passed to RVOSimulator::doSteps.
+ * @return    True to continue with the next simulation step; false to stop.
+ */
+typedef bool (*StepCallback)(RVOSimulator *simulator, void *context);
+
 /**
  * @brief Defines the simulation. The main class of the library that contains
  *        all simulation functionality.
+ * @note  Agents and obstacles may be placed on separate layers, e.g., the
+ *        floors of a building, each with its own k-D trees. Agents only avoid
+ *        agents and obstacles on their own layer. Agents and obstacles are on
+ *        layer zero unless specified otherwise, and queries that do not take a
+ *        layer apply to layer zero.
  */
 class RVO_EXPORT RVOSimulator {
  public:
@@ -245,6 +288,34 @@ class RVO_EXPORT RVOSimulator {
                        float timeHorizonObst, float radius, float maxSpeed,
                        const Vector2 &velocity);
 
+  /**
+   * @brief     Adds a new axis-aligned box obstacle to the simulation. Box
+   *            obstacles are stored and queried separately from polygonal
+   *            obstacles, which makes them cheaper to process and to avoid.
+   * @param[in] minCorner The corner of the box with minimum coordinates.
+   * @param[in] maxCorner The corner of the box with maximum coordinates.
+   * @return    The number of the box obstacle, or RVO::RVO_ERROR when the box
+   *            is empty.
+   * @note      Box obstacles are taken into account by the visibility query,
+   *            but not by the nearest obstacle and raycast queries or the
+   *            obstacle distance field.
+   */
+  std::size_t addBoxObstacle(const Vector2 &minCorner,
+                             const Vector2 &maxCorner);
+
+  /**
+   * @brief     Adds a new axis-aligned box obstacle on a specified layer to the
+   *            simulation.
+   * @param[in] minCorner The corner of the box with minimum coordinates.
+   * @param[in] maxCorner The corner of the box with maximum coordinates.
+   * @param[in] layer     The layer of the box obstacle. Only agents on the same
+   *                      layer avoid it.
+   * @return    The number of the box obstacle, or RVO::RVO_ERROR when the box
+   *            is empty or the layer is not less than RVO::RVO_MAX_LAYERS.
+   */
+  std::size_t addBoxObstacle(const Vector2 &minCorner,
+                             const Vector2 &maxCorner, std::size_t layer);
+
   /**
    * @brief     Adds a new obstacle to the simulation.
    * @param[in] vertices List of the vertices of the polygonal obstacle in
@@ -257,12 +328,91 @@ class RVO_EXPORT RVOSimulator {
    */
   std::size_t addObstacle(const std::vector<Vector2> &vertices);
 
+  /**
+   * @brief     Adds a new obstacle on a specified layer to the simulation.
+   * @param[in] vertices List of the vertices of the polygonal obstacle in
+   *                     counterclockwise order.
+   * @param[in] layer    The layer of the obstacle. Only agents on the same
+   *                     layer avoid it.
+   * @return    The number of the first vertex of the obstacle, or
+   *            RVO::RVO_ERROR when the number of vertices is less than two or
+   *            the layer is not less than RVO::RVO_MAX_LAYERS.
+   */
+  std::size_t addObstacle(const std::vector<Vector2> &vertices,
+                          std::size_t layer);
+
+  /**
+   * @brief     Builds a coarse distance field over the processed obstacles
+   *            that accelerates the computation of obstacle neighbors. Agents
+   *            farther from every obstacle edge than their obstacle query range
+   *            skip the obstacle query entirely, and the remaining agents only
+   *            consider the obstacle edges stored with their cell.
+   * @param[in] cellSize The width and height of a cell of the distance field.
+   *                     The smaller this number, the fewer obstacle edges are
+   *                     stored with each cell, but the more memory the distance
+   *                     field uses. The distance field is removed when not
+   *                     positive.
+   * @param[in] maxRange The maximum range within which obstacle edges are
+   *                     stored with each cell. Agents whose obstacle query
+   *                     range, the product of their time horizon with respect
+   *                     to obstacles and their maximum speed plus their radius,
+   *                     exceeds this number use the obstacle k-D tree instead.
+   *                     The distance field is removed when not positive.
+   * @note      The distance field yields the same obstacle neighbors as the
+   *            obstacle k-D tree. It is rebuilt whenever the obstacles are
+   *            processed again.
+   */
+  void buildObstacleDistanceField(float cellSize, float maxRange);
+
+  /**
+   * @brief     Lets the simulator perform a simulation step within a budget of
+   *            wall clock time. The new velocities of the agents are computed
+   *            in the order of their priorities, and agents that are reached
+   *            only after the budget has elapsed are deferred: they keep their
+   *            velocity, i.e., their position is extrapolated, and the
+   *            neighbor lists and ORCA lines of their previous simulation
+   *            step.
+   * @param[in] budget The budget in seconds, measured from the start of the
+   *                   simulation step once the team of threads has been
+   *                   chosen.
+   * @return    The count of agents deferred.
+   * @note      The simulation step overruns the budget by the time of
+   *            computing the new velocity of one agent on each thread and of
+   *            updating the positions of the agents. Kinematic agents are
+   *            never deferred. See setAgentPriority.
+   */
+  std::size_t doBudgetedStep(float budget);
+
   /**
    * @brief Lets the simulator perform a simulation step and updates the
    *        two-dimensional position and two-dimensional velocity of each agent.
    */
   void doStep();
 
+  /**
+   * @brief     Lets the simulator perform simulation steps with one team of
+   *            threads, which avoids starting and joining the threads of each
+   *            step and suits small scenes. Equivalent to calling doStep and
+   *            then the function repeatedly.
+   * @param[in] numSteps The maximum count of simulation steps to perform.
+   * @param[in] callback A function called after each simulation step, or
+   *                     NULL.
+   * @param[in] context  The context passed to the function.
+   * @return    The count of simulation steps performed, which is less than the
+   *            maximum count if the function stopped the simulation.
+   * @note      The function is not called after the last simulation step, so
+   *            the caller handles the final state after doSteps returns.
+   */
+  std::size_t doSteps(std::size_t numSteps, StepCallback callback,
+                      void *context);
+
+  /**
+   * @brief  Returns the adaptive neighbor count of the simulation.
+   * @return The adaptive neighbor count, zero if neighbor limits are not
+   *         adapted to the local density.
+   */
+  std::size_t getAdaptiveNeighborCount() const;
+
   /**
    * @brief     Returns the specified agent neighbor of the specified agent.
    * @param[in] agentNo    The number of the agent whose agent neighbor is to be
@@ -273,6 +423,41 @@ class RVO_EXPORT RVOSimulator {
   std::size_t getAgentAgentNeighbor(std::size_t agentNo,
                                     std::size_t neighborNo) const;
 
+  /**
+   * @brief     Returns the specified box obstacle neighbor of the specified
+   *            agent.
+   * @param[in] agentNo    The number of the agent whose box obstacle neighbor
+   *                       is to be retrieved.
+   * @param[in] neighborNo The number of the box obstacle neighbor to be
+   *                       retrieved.
+   * @return    The number of the neighboring box obstacle.
+   */
+  std::size_t getAgentBoxObstacleNeighbor(std::size_t agentNo,
+                                          std::size_t neighborNo) const;
+
+  /**
+   * @brief     Returns the collision groups of a specified agent.
+   * @param[in] agentNo The number of the agent whose collision groups are to
+   *                    be retrieved.
+   * @return    The present collision groups of the agent as a bit set.
+   */
+  unsigned int getAgentCollisionGroups(std::size_t agentNo) const;
+
+  /**
+   * @brief     Returns the collision mask of a specified agent.
+   * @param[in] agentNo The number of the agent whose collision mask is to be
+   *                    retrieved.
+   * @return    The present collision mask of the agent as a bit set.
+   */
+  unsigned int getAgentCollisionMask(std::size_t agentNo) const;
+
+  /**
+   * @brief     Returns the layer of a specified agent.
+   * @param[in] agentNo The number of the agent whose layer is to be retrieved.
+   * @return    The present layer of the agent.
+   */
+  std::size_t getAgentLayer(std::size_t agentNo) const;
+
   /**
    * @brief     Returns the maximum neighbor count of a specified agent.
    * @param[in] agentNo The number of the agent whose maximum neighbor count is
@@ -304,9 +489,32 @@ class RVO_EXPORT RVOSimulator {
    *                    is to be retrieved.
    * @return    The count of agent neighbors taken into account to compute the
    *            current velocity for the specified agent.
+   * @note      Zero if introspection is disabled for the agent.
    */
   std::size_t getAgentNumAgentNeighbors(std::size_t agentNo) const;
 
+  /**
+   * @brief     Returns the count of box obstacle neighbors taken into account
+   *            to compute the current velocity for the specified agent.
+   * @param[in] agentNo The number of the agent whose count of box obstacle
+   *                    neighbors is to be retrieved.
+   * @return    The count of box obstacle neighbors taken into account to
+   *            compute the current velocity for the specified agent.
+   * @note      Zero if introspection is disabled for the agent.
+   */
+  std::size_t getAgentNumBoxObstacleNeighbors(std::size_t agentNo) const;
+
+  /**
+   * @brief     Returns the count of cluster proxies taken into account to
+   *            compute the current velocity for the specified agent.
+   * @param[in] agentNo The number of the agent whose count of cluster proxies
+   *                    is to be retrieved.
+   * @return    The count of cluster proxies taken into account to compute the
+   *            current velocity for the specified agent.
+   * @note      Zero if introspection is disabled for the agent.
+   */
+  std::size_t getAgentNumClusterNeighbors(std::size_t agentNo) const;
+
   /**
    * @brief     Returns the count of obstacle neighbors taken into account to
    *            compute the current velocity for the specified agent.
@@ -314,9 +522,34 @@ class RVO_EXPORT RVOSimulator {
    *                    neighbors is to be retrieved.
    * @return    The count of obstacle neighbors taken into account to compute
    *            the current velocity for the specified agent.
+   * @note      Zero if introspection is disabled for the agent.
    */
   std::size_t getAgentNumObstacleNeighbors(std::size_t agentNo) const;
 
+  /**
+   * @brief     Returns the count of obstacle edges stored with the cell of the
+   *            obstacle distance field that were tested to compute the obstacle
+   *            neighbors of the specified agent in the current simulation step.
+   * @param[in] agentNo The number of the agent whose count of obstacle edges
+   *                    tested is to be retrieved.
+   * @return    The count of obstacle edges tested, zero if the obstacle
+   *            neighbors of the agent were computed using the obstacle k-D
+   *            tree.
+   */
+  std::size_t getAgentNumObstacleEdgesTested(std::size_t agentNo) const;
+
+  /**
+   * @brief     Returns the count of obstacle k-D tree nodes visited to compute
+   *            the obstacle neighbors of the specified agent in the current
+   *            simulation step.
+   * @param[in] agentNo The number of the agent whose count of obstacle k-D tree
+   *                    nodes visited is to be retrieved.
+   * @return    The count of obstacle k-D tree nodes visited to compute the
+   *            obstacle neighbors of the specified agent, zero if they were
+   *            computed using the obstacle distance field.
+   */
+  std::size_t getAgentNumObstacleTreeNodesVisited(std::size_t agentNo) const;
+
   /**
    * @brief     Returns the count of ORCA constraints used to compute the
    *            current velocity for the specified agent.
@@ -324,9 +557,21 @@ class RVO_EXPORT RVOSimulator {
    *                    is to be retrieved.
    * @return    The count of ORCA constraints used to compute the current
    *            velocity for the specified agent.
+   * @note      Zero if introspection is disabled for the agent.
    */
   std::size_t getAgentNumORCALines(std::size_t agentNo) const;
 
+  /**
+   * @brief     Returns the count of agent ORCA constraints dropped before the
+   *            linear programs for the specified agent in the current
+   *            simulation step, as they cannot bind within its maximum speed.
+   * @param[in] agentNo The number of the agent whose count of pruned ORCA
+   *                    constraints is to be retrieved.
+   * @return    The count of pruned ORCA constraints of the specified agent, or
+   *            zero when constraint pruning is disabled.
+   */
+  std::size_t getAgentNumPrunedORCALines(std::size_t agentNo) const;
+
   /**
    * @brief     Returns the specified obstacle neighbor of the specified agent.
    * @param[in] agentNo    The number of the agent whose obstacle neighbor is to
@@ -366,6 +611,27 @@ class RVO_EXPORT RVOSimulator {
    */
   const Vector2 &getAgentPrefVelocity(std::size_t agentNo) const;
 
+  /**
+   * @brief     Returns the two-dimensional position of a specified agent
+   *            before the last simulation step.
+   * @param[in] agentNo The number of the agent whose previous two-dimensional
+   *                    position is to be retrieved.
+   * @return    The two-dimensional position of the center of the agent before
+   *            the last simulation step, or its present position if the agent
+   *            was moved by setAgentPosition or setAgentStates since.
+   * @note      Only tracked while interpolation is enabled. See
+   *            setInterpolationEnabled.
+   */
+  const Vector2 &getAgentPreviousPosition(std::size_t agentNo) const;
+
+  /**
+   * @brief     Returns the priority of a specified agent.
+   * @param[in] agentNo The number of the agent whose priority is to be
+   *                    retrieved.
+   * @return    The present priority of the agent.
+   */
+  float getAgentPriority(std::size_t agentNo) const;
+
   /**
    * @brief     Returns the radius of a specified agent.
    * @param[in] agentNo The number of the agent whose radius is to be retrieved.
@@ -399,24 +665,169 @@ class RVO_EXPORT RVOSimulator {
    */
   const Vector2 &getAgentVelocity(std::size_t agentNo) const;
 
+  /**
+   * @brief     Returns the layer of a specified box obstacle.
+   * @param[in] boxObstacleNo The number of the box obstacle whose layer is to
+   *                          be retrieved.
+   * @return    The layer of the box obstacle.
+   */
+  std::size_t getBoxObstacleLayer(std::size_t boxObstacleNo) const;
+
+  /**
+   * @brief     Returns the corner with maximum coordinates of a specified box
+   *            obstacle.
+   * @param[in] boxObstacleNo The number of the box obstacle whose corner is to
+   *                          be retrieved.
+   * @return    The corner with maximum coordinates of the box obstacle.
+   */
+  const Vector2 &getBoxObstacleMaxCorner(std::size_t boxObstacleNo) const;
+
+  /**
+   * @brief     Returns the corner with minimum coordinates of a specified box
+   *            obstacle.
+   * @param[in] boxObstacleNo The number of the box obstacle whose corner is to
+   *                          be retrieved.
+   * @return    The corner with minimum coordinates of the box obstacle.
+   */
+  const Vector2 &getBoxObstacleMinCorner(std::size_t boxObstacleNo) const;
+
+  /**
+   * @brief  Returns the ratio below which distant groups of agents are avoided
+   *         as cluster proxies.
+   * @return The cluster proxy ratio, zero if cluster proxies are disabled.
+   */
+  float getClusterProxyRatio() const;
+
   /**
    * @brief  Returns the global time of the simulation.
    * @return The present global time of the simulation (zero initially).
    */
   float getGlobalTime() const { return globalTime_; }
 
+  /**
+   * @brief      Computes the two-dimensional positions of all agents between
+   *             the last two simulation steps, e.g., to render frames at a
+   *             higher rate than the simulation steps are taken.
+   * @param[in]  alpha     The fraction of the last time step, zero for the
+   *                       positions before the last simulation step and one
+   *                       for the present positions. Values above one
+   *                       extrapolate along the present velocities.
+   * @param[out] positions For each agent, its interpolated two-dimensional
+   *                       position, or its present position if interpolation
+   *                       is disabled.
+   * @note       See setInterpolationEnabled.
+   */
+  void getInterpolatedPositions(float alpha, std::vector<Vector2> &positions)
+      const; /* NOLINT(runtime/references) */
+
+  /**
+   * @brief  Returns the maximum time step of the adaptive time step
+   *         controller.
+   * @return The maximum time step, zero if the time step is not adapted.
+   */
+  float getMaxTimeStep() const { return maxTimeStep_; }
+
+  /**
+   * @brief  Returns the minimum clearance after the last simulation step, i.e.,
+   *         the minimum distance between two agents or an agent and an
+   *         obstacle, negative if they overlap.
+   * @return The minimum clearance, or infinity when quality metrics are
+   *         disabled or there is nothing to measure it to.
+   */
+  float getMinClearance() const { return minClearance_; }
+
+  /**
+   * @brief  Returns the minimum time step of the adaptive time step
+   *         controller.
+   * @return The minimum time step.
+   */
+  float getMinTimeStep() const { return minTimeStep_; }
+
+  /**
+   * @brief  Returns the count of pairs of agents that overlap after the last
+   *         simulation step.
+   * @return The count of pairs of agents that overlap, or zero when quality
+   *         metrics are disabled.
+   */
+  std::size_t getNumAgentPenetrations() const {
+    return numAgentPenetrations_;
+  }
+
   /**
    * @brief  Returns the count of agents in the simulation.
    * @return The count of agents in the simulation.
    */
   std::size_t getNumAgents() const { return agents_.size(); }
 
+  /**
+   * @brief  Returns the count of box obstacles in the simulation.
+   * @return The count of box obstacles in the simulation.
+   */
+  std::size_t getNumBoxObstacles() const;
+
+  /**
+   * @brief  Returns the count of agents deferred in the last simulation step.
+   * @return The count of agents deferred, which is zero unless the step was
+   *         performed by doBudgetedStep.
+   */
+  std::size_t getNumDeferredAgents() const { return numDeferredAgents_; }
+
   /**
    * @brief  Returns the count of obstacle vertices in the simulation.
    * @return The count of obstacle vertices in the simulation.
    */
   std::size_t getNumObstacleVertices() const { return obstacles_.size(); }
 
+  /**
+   * @brief  Returns the count of agents that overlap an obstacle after the last
+   *         simulation step, including agents whose centers lie inside a
+   *         polygonal obstacle.
+   * @return The count of agents that overlap an obstacle, or zero when quality
+   *         metrics are disabled.
+   */
+  std::size_t getNumObstaclePenetrations() const {
+    return numObstaclePenetrations_;
+  }
+
+  /**
+   * @brief  Returns the count of obstacle vertices that have been added to the
+   *         simulation by splitting obstacle edges when the obstacles were
+   *         last processed.
+   * @return The count of obstacle vertices added by splitting obstacle edges
+   *         in the most recent build of the obstacle k-D tree.
+   */
+  std::size_t getNumObstacleSplitVertices() const;
+
+  /**
+   * @brief  Returns the count of nodes in the obstacle k-D tree.
+   * @return The count of nodes in the obstacle k-D tree, which equals the count
+   *         of obstacle edges processed.
+   */
+  std::size_t getNumObstacleTreeNodes() const;
+
+  /**
+   * @brief  Returns the count of simulation steps performed.
+   * @return The count of simulation steps performed (zero initially).
+   */
+  std::size_t getNumSteps() const { return numSteps_; }
+
+  /**
+   * @brief  Returns the count of threads of the team that performed the most
+   *         recent simulation steps.
+   * @return The count of threads, which is one before the first simulation
+   *         step and without OpenMP.
+   * @note   See setAutomaticParallelismEnabled.
+   */
+  std::size_t getNumThreads() const { return numThreads_; }
+
+  /**
+   * @brief     Returns the layer of a specified obstacle vertex.
+   * @param[in] vertexNo The number of the obstacle vertex whose layer is to be
+   *                     retrieved.
+   * @return    The layer of the obstacle to which the vertex belongs.
+   */
+  std::size_t getObstacleLayer(std::size_t vertexNo) const;
+
   /**
    * @brief     Returns the two-dimensional position of a specified obstacle
    *            vertex.
@@ -445,12 +856,189 @@ class RVO_EXPORT RVOSimulator {
    */
   std::size_t getPrevObstacleVertexNo(std::size_t vertexNo) const;
 
+  /**
+   * @brief  Returns the depth of the obstacle k-D tree.
+   * @return The count of nodes on the longest path from the root of the
+   *         obstacle k-D tree to a leaf, or zero when the obstacles have not
+   *         been processed.
+   */
+  std::size_t getObstacleTreeDepth() const;
+
+  /**
+   * @brief  Returns the mean depth of the nodes in the obstacle k-D tree.
+   * @return The mean depth of the nodes in the obstacle k-D tree, or zero when
+   *         the obstacles have not been processed. Compared to the binary
+   *         logarithm of the count of nodes, indicates the balance of the tree.
+   */
+  float getObstacleTreeMeanDepth() const;
+
+  /**
+   * @brief  Returns the mean count of obstacle k-D tree nodes visited per
+   *         obstacle neighbor query of the agents in the current simulation
+   *         step.
+   * @return The mean count of obstacle k-D tree nodes visited over the agents
+   *         whose obstacle neighbors were computed using the obstacle k-D
+   *         tree, or zero if there are none.
+   */
+  float getObstacleTreeMeanNodesVisited() const;
+
+  /**
+   * @brief  Returns the count of agents below which the positions of the agents
+   *         were updated by one thread in the most recent simulation steps.
+   * @return The count of agents, which is the maximum value of std::size_t
+   *         when the team has one thread.
+   * @note   See setAutomaticParallelismEnabled.
+   */
+  std::size_t getParallelUpdateThreshold() const {
+    return parallelUpdateThreshold_;
+  }
+
+  /**
+   * @brief  Returns the count of agents below which the new velocities of the
+   *         agents were computed by one thread in the most recent simulation
+   *         steps.
+   * @return The count of agents, which is the maximum value of std::size_t
+   *         when the team has one thread.
+   * @note   See setAutomaticParallelismEnabled.
+   */
+  std::size_t getParallelVelocityThreshold() const {
+    return parallelVelocityThreshold_;
+  }
+
+  /**
+   * @brief  Returns the total penetration depth after the last simulation
+   *         step, i.e., the sum of the overlaps of all pairs of agents and of
+   *         all agents with their nearest obstacle.
+   * @return The total penetration depth, or zero when quality metrics are
+   *         disabled.
+   */
+  float getPenetrationDepth() const { return penetrationDepth_; }
+
+  /**
+   * @brief  Returns the maximum magnitude of the random perturbation of the
+   *         preferred velocities of the agents.
+   * @return The maximum magnitude of the perturbation, or zero when the
+   *         preferred velocities are not perturbed.
+   */
+  float getPerturbationMagnitude() const { return perturbationMagnitude_; }
+
+  /**
+   * @brief  Returns the seed of the random perturbation of the preferred
+   *         velocities of the agents.
+   * @return The seed of the perturbation.
+   */
+  unsigned int getPerturbationSeed() const { return perturbationSeed_; }
+
   /**
    * @brief  Returns the time step of the simulation.
    * @return The present time step of the simulation.
    */
   float getTimeStep() const { return timeStep_; }
 
+  /**
+   * @brief     Returns whether a specified agent was deferred in the last
+   *            simulation step.
+   * @param[in] agentNo The number of the agent to be queried.
+   * @return    True if the agent kept its velocity because the budget of the
+   *            simulation step had elapsed.
+   */
+  bool isAgentDeferred(std::size_t agentNo) const;
+
+  /**
+   * @brief     Returns whether the neighbor lists and ORCA lines of a specified
+   *            agent are retained after each simulation step.
+   * @param[in] agentNo The number of the agent whose introspection is to be
+   *                    retrieved.
+   * @return    True if the neighbor lists and ORCA lines of the agent are
+   *            retained after each simulation step.
+   */
+  bool isAgentIntrospectionEnabled(std::size_t agentNo) const;
+
+  /**
+   * @brief     Returns whether a specified agent is kinematic.
+   * @param[in] agentNo The number of the agent to be queried.
+   * @return    True if the agent is kinematic.
+   */
+  bool isAgentKinematic(std::size_t agentNo) const;
+
+  /**
+   * @brief  Returns whether the count of threads and the phases of each
+   *         simulation step that run in parallel are chosen automatically.
+   * @return True if the parallelism of the simulation steps is chosen
+   *         automatically.
+   */
+  bool isAutomaticParallelismEnabled() const {
+    return isAutomaticParallelismEnabled_;
+  }
+
+  /**
+   * @brief  Returns whether agent ORCA constraints that cannot bind within the
+   *         maximum speed are pruned before the linear programs.
+   * @return True if agent ORCA constraints are pruned.
+   */
+  bool isConstraintPruningEnabled() const {
+    return isConstraintPruningEnabled_;
+  }
+
+  /**
+   * @brief  Returns whether the positions of the agents before each simulation
+   *         step are retained for interpolation.
+   * @return True if the positions of the agents before each simulation step
+   *         are retained.
+   */
+  bool isInterpolationEnabled() const { return isInterpolationEnabled_; }
+
+  /**
+   * @brief  Returns whether the neighbor lists and ORCA lines of new agents
+   *         are retained after each simulation step.
+   * @return True if the neighbor lists and ORCA lines of new agents are
+   *         retained after each simulation step.
+   */
+  bool isIntrospectionEnabled() const { return isIntrospectionEnabled_; }
+
+  /**
+   * @brief  Returns whether quality metrics are computed after each simulation
+   *         step.
+   * @return True if quality metrics are computed after each simulation step.
+   */
+  bool isQualityMetricsEnabled() const { return isQualityMetricsEnabled_; }
+
+  /**
+   * @brief     Adds the polygons of a polygon file to the simulation as
+   *            obstacles. The file is a sequence of two-dimensional well-known
+   *            binary (WKB) Polygon and MultiPolygon geometries in either byte
+   *            order, such as exported by most GIS tools. Each ring of a
+   *            polygon becomes an obstacle: the exterior ring is ordered
+   *            counterclockwise and interior rings are ordered clockwise. The
+   *            closing vertex of a ring is dropped, and rings with fewer than
+   *            two vertices are skipped.
+   * @param[in] filename The name of the polygon file.
+   * @param[in] process  True if the obstacles are to be processed after they
+   *                     have been added.
+   * @return    The count of obstacles added, or RVO::RVO_ERROR when the file
+   *            cannot be read or is not a valid polygon file, in which case no
+   *            obstacles are added.
+   * @note      The file is memory-mapped where supported, and the vertices of
+   *            all obstacles in the file are allocated at once, which is
+   *            considerably faster than adding large maps with addObstacle.
+   */
+  std::size_t loadObstacles(const char *filename, bool process);
+
+  /**
+   * @brief     Adds the polygons of a polygon file to the simulation as
+   *            obstacles on a specified layer.
+   * @param[in] filename The name of the polygon file.
+   * @param[in] layer    The layer of the obstacles.
+   * @param[in] process  True if the obstacles are to be processed after they
+   *                     have been added.
+   * @return    The count of obstacles added, or RVO::RVO_ERROR when the file
+   *            cannot be read or is not a valid polygon file or the layer is
+   *            not less than RVO::RVO_MAX_LAYERS, in which case no obstacles
+   *            are added.
+   */
+  std::size_t loadObstacles(const char *filename, std::size_t layer,
+                            bool process);
+
   /**
    * @brief Processes the obstacles that have been added so that they are
    *        accounted for in the simulation.
@@ -459,6 +1047,245 @@ class RVO_EXPORT RVOSimulator {
    */
   void processObstacles();
 
+  /**
+   * @brief      Finds the agents within a specified range of a specified point
+   *             using the agent k-D tree of the most recent simulation step.
+   * @param[in]  point    The point around which agents are to be found.
+   * @param[in]  range    The range around the point within which agents are to
+   *                      be found. Must be non-negative.
+   * @param[out] agentNos The numbers of the agents found, sorted by increasing
+   *                      distance to the point.
+   * @return     The count of agents found.
+   * @note       Agents added after the most recent simulation step are not
+   *             found.
+   */
+  std::size_t queryAgentsInRange(const Vector2 &point, float range,
+                                 std::vector<std::size_t> &agentNos)
+      const; /* NOLINT(runtime/references) */
+
+  /**
+   * @brief      Finds the agents on a specified layer within a specified range
+   *             of a specified point using the agent k-D tree of the most
+   *             recent simulation step.
+   * @param[in]  point    The point around which agents are to be found.
+   * @param[in]  range    The range around the point within which agents are to
+   *                      be found. Must be non-negative.
+   * @param[in]  layer    The layer of the agents to be found.
+   * @param[out] agentNos The numbers of the agents found, sorted by increasing
+   *                      distance to the point.
+   * @return     The count of agents found.
+   */
+  std::size_t queryAgentsInRange(const Vector2 &point, float range,
+                                 std::size_t layer,
+                                 std::vector<std::size_t> &agentNos)
+      const; /* NOLINT(runtime/references) */
+
+  /**
+   * @brief      Finds the agents within a specified range of each of the
+   *             specified points in parallel using the agent k-D tree of the
+   *             most recent simulation step.
+   * @param[in]  points   The points around which agents are to be found.
+   * @param[in]  range    The range around each point within which agents are
+   *                      to be found. Must be non-negative.
+   * @param[out] agentNos For each point, the numbers of the agents found,
+   *                      sorted by increasing distance to the point.
+   * @note       Agents added after the most recent simulation step are not
+   *             found.
+   */
+  void queryAgentsInRange(const std::vector<Vector2> &points, float range,
+                          std::vector<std::vector<std::size_t> > &agentNos)
+      const; /* NOLINT(runtime/references) */
+
+  /**
+   * @brief      Finds the agents on a specified layer within a specified range
+   *             of each of the specified points in parallel using the agent
+   *             k-D tree of the most recent simulation step.
+   * @param[in]  points   The points around which agents are to be found.
+   * @param[in]  range    The range around each point within which agents are
+   *                      to be found. Must be non-negative.
+   * @param[in]  layer    The layer of the agents to be found.
+   * @param[out] agentNos For each point, the numbers of the agents found,
+   *                      sorted by increasing distance to the point.
+   */
+  void queryAgentsInRange(const std::vector<Vector2> &points, float range,
+                          std::size_t layer,
+                          std::vector<std::vector<std::size_t> > &agentNos)
+      const; /* NOLINT(runtime/references) */
+
+  /**
+   * @brief      Finds the agents nearest to a specified point using the agent
+   *             k-D tree of the most recent simulation step.
+   * @param[in]  point     The point around which agents are to be found.
+   * @param[in]  numAgents The maximum count of agents to be found.
+   * @param[out] agentNos  The numbers of the agents found, sorted by increasing
+   *                       distance to the point.
+   * @return     The count of agents found, which is less than numAgents only
+   *             when the simulation contains fewer agents.
+   * @note       Agents added after the most recent simulation step are not
+   *             found.
+   */
+  std::size_t queryNearestAgents(const Vector2 &point, std::size_t numAgents,
+                                 std::vector<std::size_t> &agentNos)
+      const; /* NOLINT(runtime/references) */
+
+  /**
+   * @brief      Finds the agents on a specified layer nearest to a specified
+   *             point using the agent k-D tree of the most recent simulation
+   *             step.
+   * @param[in]  point     The point around which agents are to be found.
+   * @param[in]  numAgents The maximum count of agents to be found.
+   * @param[in]  layer     The layer of the agents to be found.
+   * @param[out] agentNos  The numbers of the agents found, sorted by increasing
+   *                       distance to the point.
+   * @return     The count of agents found.
+   */
+  std::size_t queryNearestAgents(const Vector2 &point, std::size_t numAgents,
+                                 std::size_t layer,
+                                 std::vector<std::size_t> &agentNos)
+      const; /* NOLINT(runtime/references) */
+
+  /**
+   * @brief      Finds the agents nearest to each of the specified points in
+   *             parallel using the agent k-D tree of the most recent
+   *             simulation step.
+   * @param[in]  points    The points around which agents are to be found.
+   * @param[in]  numAgents The maximum count of agents to be found per point.
+   * @param[out] agentNos  For each point, the numbers of the agents found,
+   *                       sorted by increasing distance to the point.
+   * @note       Agents added after the most recent simulation step are not
+   *             found.
+   */
+  void queryNearestAgents(const std::vector<Vector2> &points,
+                          std::size_t numAgents,
+                          std::vector<std::vector<std::size_t> > &agentNos)
+      const; /* NOLINT(runtime/references) */
+
+  /**
+   * @brief      Finds the agents on a specified layer nearest to each of the
+   *             specified points in parallel using the agent k-D tree of the
+   *             most recent simulation step.
+   * @param[in]  points    The points around which agents are to be found.
+   * @param[in]  numAgents The maximum count of agents to be found per point.
+   * @param[in]  layer     The layer of the agents to be found.
+   * @param[out] agentNos  For each point, the numbers of the agents found,
+   *                       sorted by increasing distance to the point.
+   */
+  void queryNearestAgents(const std::vector<Vector2> &points,
+                          std::size_t numAgents, std::size_t layer,
+                          std::vector<std::vector<std::size_t> > &agentNos)
+      const; /* NOLINT(runtime/references) */
+
+  /**
+   * @brief      Finds the obstacle edge nearest to a specified point using the
+   *             obstacle k-D tree.
+   * @param[in]  point      The point for which the nearest obstacle edge is to
+   *                        be found.
+   * @param[out] obstacleNo The number of the first vertex of the nearest
+   *                        obstacle edge, or RVO::RVO_ERROR when the obstacles
+   *                        have not been processed.
+   * @return     The distance from the point to the nearest obstacle edge, or
+   *             infinity when the obstacles have not been processed.
+   */
+  float queryNearestObstacle(const Vector2 &point,
+                             std::size_t &obstacleNo)
+      const; /* NOLINT(runtime/references) */
+
+  /**
+   * @brief      Finds the obstacle edge on a specified layer nearest to a
+   *             specified point using the obstacle k-D tree of the layer.
+   * @param[in]  point      The point for which the nearest obstacle edge is to
+   *                        be found.
+   * @param[in]  layer      The layer of the obstacle edges.
+   * @param[out] obstacleNo The number of the first vertex of the nearest
+   *                        obstacle edge, or RVO::RVO_ERROR when the layer has
+   *                        no processed obstacles.
+   * @return     The distance from the point to the nearest obstacle edge, or
+   *             infinity when the layer has no processed obstacles.
+   */
+  float queryNearestObstacle(const Vector2 &point, std::size_t layer,
+                             std::size_t &obstacleNo)
+      const; /* NOLINT(runtime/references) */
+
+  /**
+   * @brief      Finds the obstacle edge nearest to each of the specified points
+   *             in parallel using the obstacle k-D tree.
+   * @param[in]  points      The points for which the nearest obstacle edges
+   *                         are to be found.
+   * @param[out] distances   For each point, the distance to the nearest
+   *                         obstacle edge, or infinity when the obstacles have
+   *                         not been processed.
+   * @param[out] obstacleNos For each point, the number of the first vertex of
+   *                         the nearest obstacle edge, or RVO::RVO_ERROR when
+   *                         the obstacles have not been processed.
+   */
+  void queryNearestObstacle(
+      const std::vector<Vector2> &points,
+      std::vector<float> &distances, /* NOLINT(runtime/references) */
+      std::vector<std::size_t> &obstacleNos)
+      const; /* NOLINT(runtime/references) */
+
+  /**
+   * @brief      Casts a ray against the obstacles using the obstacle k-D tree.
+   * @param[in]  origin     The origin of the ray.
+   * @param[in]  direction  The direction of the ray. Must be non-zero.
+   * @param[in]  maxDist    The maximum distance along the ray within which
+   *                        obstacles are hit. Must be non-negative, and
+   *                        may be infinite.
+   * @param[out] obstacleNo The number of the first vertex of the first
+   *                        obstacle edge hit by the ray, or RVO::RVO_ERROR when
+   *                        no obstacle edge is hit.
+   * @return     The distance along the ray to the first obstacle edge hit, or
+   *             maxDist when no obstacle edge is hit.
+   * @note       Both sides of an obstacle edge are hit by the ray.
+   */
+  float queryRaycast(const Vector2 &origin, const Vector2 &direction,
+                     float maxDist, std::size_t &obstacleNo)
+      const; /* NOLINT(runtime/references) */
+
+  /**
+   * @brief      Casts a ray against the obstacles on a specified layer using
+   *             the obstacle k-D tree of the layer.
+   * @param[in]  origin     The origin of the ray.
+   * @param[in]  direction  The direction of the ray. Must be non-zero.
+   * @param[in]  maxDist    The maximum distance along the ray within which
+   *                        obstacles are hit. Must be non-negative, and
+   *                        may be infinite.
+   * @param[in]  layer      The layer of the obstacles.
+   * @param[out] obstacleNo The number of the first vertex of the first
+   *                        obstacle edge hit by the ray, or RVO::RVO_ERROR when
+   *                        no obstacle edge is hit.
+   * @return     The distance along the ray to the first obstacle edge hit, or
+   *             maxDist when no obstacle edge is hit.
+   */
+  float queryRaycast(const Vector2 &origin, const Vector2 &direction,
+                     float maxDist, std::size_t layer,
+                     std::size_t &obstacleNo)
+      const; /* NOLINT(runtime/references) */
+
+  /**
+   * @brief      Casts each of the specified rays against the obstacles in
+   *             parallel using the obstacle k-D tree.
+   * @param[in]  origins     The origins of the rays.
+   * @param[in]  directions  The directions of the rays, one for each origin.
+   *                         Must be non-zero.
+   * @param[in]  maxDist     The maximum distance along each ray within which
+   *                         obstacles are hit. Must be non-negative, and
+   *                         may be infinite.
+   * @param[out] distances   For each ray, the distance along the ray to the
+   *                         first obstacle edge hit, or maxDist when no
+   *                         obstacle edge is hit.
+   * @param[out] obstacleNos For each ray, the number of the first vertex of the
+   *                         first obstacle edge hit by the ray, or
+   *                         RVO::RVO_ERROR when no obstacle edge is hit.
+   * @note       Both sides of an obstacle edge are hit by the rays.
+   */
+  void queryRaycast(
+      const std::vector<Vector2> &origins,
+      const std::vector<Vector2> &directions, float maxDist,
+      std::vector<float> &distances, /* NOLINT(runtime/references) */
+      std::vector<std::size_t> &obstacleNos)
+      const; /* NOLINT(runtime/references) */
+
   /**
    * @brief     Performs a visibility query between the two specified points
    *            with respect to the obstacles
@@ -485,6 +1312,119 @@ class RVO_EXPORT RVOSimulator {
   bool queryVisibility(const Vector2 &point1, const Vector2 &point2,
                        float radius) const;
 
+  /**
+   * @brief      Performs a visibility query between the two specified points
+   *             with respect to the obstacles and reports its traversal cost.
+   * @param[in]  point1          The first point of the query.
+   * @param[in]  point2          The second point of the query.
+   * @param[in]  radius          The minimal distance between the line
+   *                             connecting the two points and the obstacles in
+   *                             order for the points to be mutually visible.
+   *                             Must be non-negative.
+   * @param[out] numNodesVisited The count of obstacle k-D tree nodes visited by
+   *                             the query.
+   * @return     A boolean specifying whether the two points are mutually
+   *             visible. Returns true when the obstacles have not been
+   *             processed.
+   */
+  bool queryVisibility(
+      const Vector2 &point1, const Vector2 &point2, float radius,
+      std::size_t &numNodesVisited) const; /* NOLINT(runtime/references) */
+
+  /**
+   * @brief      Performs a visibility query between the two specified points
+   *             with respect to the obstacles on a specified layer and reports
+   *             its traversal cost.
+   * @param[in]  point1          The first point of the query.
+   * @param[in]  point2          The second point of the query.
+   * @param[in]  radius          The minimal distance between the line
+   *                             connecting the two points and the obstacles in
+   *                             order for the points to be mutually visible.
+   *                             Must be non-negative.
+   * @param[in]  layer           The layer of the obstacles.
+   * @param[out] numNodesVisited The count of obstacle k-D tree nodes visited by
+   *                             the query.
+   * @return     A boolean specifying whether the two points are mutually
+   *             visible. Returns true when the layer has no processed
+   *             obstacles.
+   */
+  bool queryVisibility(
+      const Vector2 &point1, const Vector2 &point2, float radius,
+      std::size_t layer,
+      std::size_t &numNodesVisited) const; /* NOLINT(runtime/references) */
+
+  /**
+   * @brief     Sets the adaptive neighbor count of the simulation. When
+   *            positive, the count of agent neighbors of each agent is adapted
+   *            to the density of agents around it, estimated from the agent
+   *            k-D tree. Agents packed as densely as their radii allow keep
+   *            the adaptive neighbor count of neighbors, agents at half that
+   *            density twice as many, and so on, and each agent starts its
+   *            neighbor search within the range expected to hold its
+   *            neighbors. The maximum count of neighbors and the maximum
+   *            neighbor distance of each agent remain upper bounds, so agents
+   *            in open space are unaffected.
+   * @param[in] adaptiveNeighborCount The adaptive neighbor count. Neighbor
+   *                                  limits are not adapted when zero, which
+   *                                  is the default.
+   * @note      Takes effect from the next simulation step. Allows a large
+   *            maximum neighbor distance and maximum count of neighbors
+   *            without their cost in dense regions.
+   */
+  void setAdaptiveNeighborCount(std::size_t adaptiveNeighborCount);
+
+  /**
+   * @brief     Enables the adaptive time step controller, which picks the time
+   *            step of each simulation step from the state after the previous
+   *            one. The time step shrinks to half of the time within which
+   *            any agent could close its clearance to a neighbor or obstacle
+   *            at their relative speed, and grows by at most a quarter per
+   *            step otherwise. It halves when agents overlap, and does not
+   *            grow while the ORCA constraints of more than a tenth of the
+   *            agents are infeasible.
+   * @param[in] minTimeStep The minimum time step. Must be positive.
+   * @param[in] maxTimeStep The maximum time step. Must not be less than the
+   *                        minimum time step. The time step is not adapted
+   *                        when zero, which is the default.
+   * @note      The time step set by setTimeStep is used for the next
+   *            simulation step and then adapted. getTimeStep returns the time
+   *            step of the next simulation step, and getNumSteps and
+   *            getGlobalTime report the steps taken.
+   */
+  void setAdaptiveTimeStep(float minTimeStep, float maxTimeStep);
+
+  /**
+   * @brief     Sets the collision groups of a specified agent. An agent avoids
+   *            another agent only if its collision mask shares a bit with the
+   *            collision groups of the other agent. Agents belong to group 1
+   *            and avoid all groups by default.
+   * @param[in] agentNo         The number of the agent whose collision groups
+   *                            are to be modified.
+   * @param[in] collisionGroups The replacement collision groups as a bit set.
+   *                            Agents with no collision groups are avoided by
+   *                            no other agent.
+   * @note      Takes effect from the next simulation step.
+   */
+  void setAgentCollisionGroups(std::size_t agentNo,
+                               unsigned int collisionGroups);
+
+  /**
+   * @brief     Sets the collision mask of a specified agent, i.e., the
+   *            collision groups of the agents it avoids. Agents filtered out by
+   *            the mask are skipped during the neighbor search, so they take
+   *            neither a neighbor slot nor an ORCA line.
+   * @param[in] agentNo       The number of the agent whose collision mask is to
+   *                          be modified.
+   * @param[in] collisionMask The replacement collision mask as a bit set.
+   * @note      Takes effect from the next simulation step. An agent that avoids
+   *            another agent not avoiding it in return takes full
+   *            responsibility for the avoidance, as it does for kinematic
+   *            agents, whereas agents avoiding each other share it. Members of
+   *            a formation may, e.g., share a group that is excluded from the
+   *            masks of all of them.
+   */
+  void setAgentCollisionMask(std::size_t agentNo, unsigned int collisionMask);
+
   /**
    * @brief     Sets the default properties for any new agent that is added.
    * @param[in] neighborDist    The default maximum distance center-point to
@@ -561,6 +1501,51 @@ class RVO_EXPORT RVOSimulator {
                         float timeHorizon, float timeHorizonObst, float radius,
                         float maxSpeed, const Vector2 &velocity);
 
+  /**
+   * @brief     Sets whether the neighbor lists and ORCA lines of a specified
+   *            agent are retained after each simulation step, so that they may
+   *            be retrieved for debugging. Otherwise, they are computed in
+   *            scratch buffers shared by the agents of each thread and
+   *            discarded, and the agent holds no memory for them.
+   * @param[in] agentNo                The number of the agent whose
+   *                                   introspection is to be modified.
+   * @param[in] isIntrospectionEnabled Whether the neighbor lists and ORCA
+   *                                   lines of the agent are retained.
+   * @note      Takes effect from the next simulation step. All agents retain
+   *            their neighbor lists while the time step is adaptive, as the
+   *            adaptive time step is computed from them.
+   */
+  void setAgentIntrospectionEnabled(std::size_t agentNo,
+                                    bool isIntrospectionEnabled);
+
+  /**
+   * @brief     Sets whether a specified agent is kinematic. A kinematic agent
+   *            is avoided by other agents, which take full responsibility for
+   *            avoiding it, but computes no neighbors or ORCA constraints of
+   *            its own. It is moved with the velocity set by the caller, e.g.,
+   *            to replay recorded trajectories or to stand still as a target.
+   *            Agents are not kinematic by default.
+   * @param[in] agentNo     The number of the agent to be modified.
+   * @param[in] isKinematic Whether the agent is kinematic.
+   * @note      Takes effect from the next simulation step. See setAgentStates
+   *            to set the positions and velocities of many agents at once.
+   */
+  void setAgentKinematic(std::size_t agentNo, bool isKinematic);
+
+  /**
+   * @brief     Sets the layer of a specified agent. Agents only avoid and find
+   *            agents and obstacles on their own layer, so moving an agent to
+   *            another layer, e.g., on stairs between floors, is a matter of
+   *            changing its layer.
+   * @param[in] agentNo The number of the agent whose layer is to be modified.
+   * @param[in] layer   The replacement layer. Must be less than
+   *                    RVO::RVO_MAX_LAYERS.
+   * @note      Takes effect from the next simulation step. Layers should be
+   *            numbered consecutively from zero, as the k-D trees index them
+   *            directly.
+   */
+  void setAgentLayer(std::size_t agentNo, std::size_t layer);
+
   /**
    * @brief     Sets the maximum neighbor count of a specified agent.
    * @param[in] agentNo      The number of the agent whose maximum neighbor
@@ -591,6 +1576,9 @@ class RVO_EXPORT RVOSimulator {
    * @param[in] agentNo  The number of the agent whose two-dimensional position
    *                     is to be modified.
    * @param[in] position The replacement of the two-dimensional position.
+   * @note      Refits the agent k-D tree, which takes time linear in the
+   *            number of agents, so moving many agents at once is faster with
+   *            setAgentStates.
    */
   void setAgentPosition(std::size_t agentNo, const Vector2 &position);
 
@@ -604,6 +1592,18 @@ class RVO_EXPORT RVOSimulator {
    */
   void setAgentPrefVelocity(std::size_t agentNo, const Vector2 &prefVelocity);
 
+  /**
+   * @brief     Sets the priority of a specified agent. doBudgetedStep computes
+   *            the new velocities of agents with higher priority first, and of
+   *            agents with equal priority in the order of their numbers. The
+   *            priority of an agent is zero by default.
+   * @param[in] agentNo  The number of the agent whose priority is to be
+   *                     modified.
+   * @param[in] priority The replacement priority, e.g., the importance of the
+   *                     agent or the negated distance to the nearest observer.
+   */
+  void setAgentPriority(std::size_t agentNo, float priority);
+
   /**
    * @brief     Sets the radius of a specified agent.
    * @param[in] agentNo The number of the agent whose radius is to be modified.
@@ -611,6 +1611,22 @@ class RVO_EXPORT RVOSimulator {
    */
   void setAgentRadius(std::size_t agentNo, float radius);
 
+  /**
+   * @brief     Sets the two-dimensional positions and two-dimensional linear
+   *            velocities of specified agents, e.g., of kinematic agents
+   *            replaying recorded trajectories.
+   * @param[in] agentNos   The numbers of the agents to be modified.
+   * @param[in] positions  The replacement two-dimensional positions, in the
+   *                       order of the agent numbers. Must have the same size
+   *                       as the agent numbers.
+   * @param[in] velocities The replacement two-dimensional linear velocities,
+   *                       in the order of the agent numbers. Must have the
+   *                       same size as the agent numbers.
+   */
+  void setAgentStates(const std::vector<std::size_t> &agentNos,
+                      const std::vector<Vector2> &positions,
+                      const std::vector<Vector2> &velocities);
+
   /**
    * @brief     Sets the time horizon of a specified agent with respect to other
    *            agents.
@@ -639,12 +1655,171 @@ class RVO_EXPORT RVOSimulator {
    */
   void setAgentVelocity(std::size_t agentNo, const Vector2 &velocity);
 
+  /**
+   * @brief     Sets whether the count of threads and the phases of each
+   *            simulation step that run in parallel are chosen automatically.
+   *            Enabled by default. The simulator then measures the cost of
+   *            starting a team of threads and of synchronizing it once, and
+   *            estimates the cost per agent of each phase from the simulation
+   *            steps. Each call of doStep or doSteps uses the team that is
+   *            expected to be fastest, and a phase runs in parallel only if
+   *            its agents outweigh the synchronization. Teams are limited to
+   *            the count of processors. When disabled, all threads available to
+   *            OpenMP run every phase.
+   * @param[in] isAutomaticParallelismEnabled Whether the parallelism of the
+   *                                          simulation steps is chosen
+   *                                          automatically.
+   * @note      The first simulation step runs on one thread to estimate the
+   *            costs. The results do not depend on the count of threads. See
+   *            getNumThreads, getParallelUpdateThreshold, and
+   *            getParallelVelocityThreshold.
+   */
+  void setAutomaticParallelismEnabled(bool isAutomaticParallelismEnabled) {
+    isAutomaticParallelismEnabled_ = isAutomaticParallelismEnabled;
+  }
+
+  /**
+   * @brief     Sets the ratio below which distant groups of agents are avoided
+   *            as cluster proxies. A cluster proxy is a moving disk enclosing
+   *            the agents of an agent k-D tree node, with their mean position
+   *            and velocity. An agent avoids the agents of a node as a single
+   *            cluster proxy, taking full responsibility for avoiding it and
+   *            without searching the node further, if the radius of the
+   *            cluster proxy is less than the ratio times its distance from
+   *            the agent. Cluster proxies do not count towards the maximum
+   *            count of neighbors of an agent.
+   * @param[in] clusterProxyRatio The cluster proxy ratio. Must be less than
+   *                              one, and is clamped to just below one
+   *                              otherwise. Cluster proxies are disabled when
+   *                              zero, which is the default.
+   * @note      Larger ratios replace more agents by cluster proxies, which
+   *            allows larger neighbor distances for agents at the edge of
+   *            dense crowds at the cost of coarser avoidance of distant
+   *            agents. Takes effect from the next simulation step.
+   */
+  void setClusterProxyRatio(float clusterProxyRatio);
+
+  /**
+   * @brief     Sets whether agent ORCA constraints that cannot bind are pruned
+   *            before the linear programs. A constraint cannot bind if its
+   *            half-plane of permissible velocities contains the whole disc of
+   *            velocities up to the maximum speed of the agent, which is
+   *            common for distant neighbors with large neighbor distances.
+   *            Obstacle ORCA constraints are never pruned. Disabled by default.
+   * @param[in] isConstraintPruningEnabled Whether agent ORCA constraints that
+   *                                       cannot bind are pruned.
+   * @note      Pruned constraints are not reported by getAgentORCALine. The
+   *            new velocities are unchanged up to rounding.
+   */
+  void setConstraintPruningEnabled(bool isConstraintPruningEnabled) {
+    isConstraintPruningEnabled_ = isConstraintPruningEnabled;
+  }
+
+  /**
+   * @brief     Sets whether the positions of the agents before each simulation
+   *            step are retained, so that getInterpolatedPositions can compute
+   *            positions between the last two simulation steps. Disabled by
+   *            default. The previous positions of all agents are reset to
+   *            their present positions.
+   * @param[in] isInterpolationEnabled Whether the positions of the agents
+   *                                   before each simulation step are
+   *                                   retained.
+   */
+  void setInterpolationEnabled(bool isInterpolationEnabled);
+
+  /**
+   * @brief     Sets whether the neighbor lists and ORCA lines of all agents,
+   *            and of agents added later, are retained after each simulation
+   *            step. Enabled by default. Disabling introspection reduces the
+   *            memory traffic of each simulation step, and introspection may
+   *            then be enabled for chosen agents.
+   * @param[in] isIntrospectionEnabled Whether the neighbor lists and ORCA
+   *                                   lines of the agents are retained.
+   * @note      See setAgentIntrospectionEnabled.
+   */
+  void setIntrospectionEnabled(bool isIntrospectionEnabled);
+
+  /**
+   * @brief     Sets the random perturbation of the preferred velocities of the
+   *            agents, which avoids deadlocks due to perfect symmetry. In each
+   *            simulation step, the preferred velocity of each agent is offset
+   *            by a vector with a uniformly random direction and a length up
+   *            to the magnitude while its new velocity is computed, leaving the
+   *            preferred velocity set by the caller unchanged. The random
+   *            numbers are computed by a counter-based generator from the
+   *            seed, the agent number and the count of steps, so they are
+   *            reproducible and do not depend on the count of threads.
+   * @param[in] perturbationMagnitude The maximum magnitude of the perturbation.
+   *                                  Must be non-negative. The preferred
+   *                                  velocities are not perturbed when zero,
+   *                                  which is the default.
+   * @param[in] perturbationSeed      The seed of the perturbation.
+   */
+  void setPerturbation(float perturbationMagnitude,
+                       unsigned int perturbationSeed);
+
+  /**
+   * @brief     Registers a function that computes the preferred velocity of
+   *            each agent in each simulation step. The function is called in
+   *            the parallel loop of the simulation step, after the neighbors of
+   *            the agent are computed and before its new velocity, which saves
+   *            a separate pass over the agents and may use the neighbors of the
+   *            agent.
+   * @param[in] callback The function, or NULL to keep the preferred velocities
+   *                     set by setAgentPrefVelocity, which is the default.
+   * @param[in] context  The context passed to the function, e.g., the goals of
+   *                     the agents.
+   * @note      The function is called concurrently for different agents when
+   *            OpenMP is enabled, so it must be thread-safe. The preferred
+   *            velocity it returns replaces that of the agent.
+   */
+  void setPrefVelocityCallback(PrefVelocityCallback callback, void *context);
+
+  /**
+   * @brief     Sets whether quality metrics are computed after each simulation
+   *            step. A parallel pass over the agents counts the pairs of
+   *            agents and the agents and obstacles that overlap, and measures
+   *            the minimum clearance and total penetration depth, using the
+   *            k-D trees. Pairs of agents that avoid neither each other are
+   *            skipped. Disabled by default.
+   * @param[in] isQualityMetricsEnabled Whether quality metrics are computed
+   *                                    after each simulation step.
+   * @note      An agent overlaps an obstacle if it is closer than its radius to
+   *            an obstacle edge or box obstacle, or if its center is inside a
+   *            polygonal obstacle, in which case its penetration depth is its
+   *            radius plus the distance of its center to the nearest edge. An
+   *            agent whose center is inside a box obstacle only reports a
+   *            penetration depth of its radius.
+   */
+  void setQualityMetricsEnabled(bool isQualityMetricsEnabled);
+
   /**
    * @brief     Sets the time step of the simulation.
    * @param[in] timeStep The time step of the simulation. Must be positive.
    */
   void setTimeStep(float timeStep) { timeStep_ = timeStep; }
 
+  /**
+   * @brief     Simplifies the obstacles that have been added to reduce the
+   *            count of obstacle vertices. Vertices closer than the tolerance
+   *            to their predecessor are removed, as are vertices whose removal
+   *            keeps every original vertex within the tolerance of the
+   *            simplified obstacle. A polygonal obstacle keeps at least three
+   *            vertices. Polygonal obstacles left with fewer than three
+   *            vertices by removing close vertices, and counterclockwise
+   *            obstacles lying inside another counterclockwise obstacle, are
+   *            removed entirely.
+   * @param[in] tolerance The maximum distance by which a simplified obstacle
+   *                      may deviate from an original obstacle. Must be
+   *                      non-negative.
+   * @return    The count of obstacle vertices removed, not counting the
+   *            vertices added by splitting obstacle edges, which are always
+   *            removed.
+   * @note      The obstacle vertices are renumbered. If the obstacles have
+   *            already been processed, they are processed again.
+   */
+  std::size_t simplifyObstacles(float tolerance);
+
  private:
   /* Not implemented. */
   RVOSimulator(const RVOSimulator &other);
@@ -652,14 +1827,126 @@ class RVO_EXPORT RVOSimulator {
   /* Not implemented. */
   RVOSimulator &operator=(const RVOSimulator &other);
 
+  /**
+   * @brief Adapts the time step of the simulation for the next simulation step
+   *        to the state after the previous one. Called by all threads of the
+   *        team of doSteps.
+   */
+  void adaptTimeStep();
+
+  /**
+   * @brief     Measures the cost of starting a team of threads and of
+   *            synchronizing it once for teams of powers of two threads and of
+   *            the maximum count of threads.
+   * @param[in] maxNumThreads The maximum count of threads.
+   */
+  void calibrateThreadTeams(std::size_t maxNumThreads);
+
+  /**
+   * @brief     Computes the new velocity of an agent in a simulation step.
+   * @param[in] agent The agent.
+   */
+  void computeAgentVelocity(Agent *agent);
+
+  /**
+   * @brief Computes the quality metrics of the simulation for the current
+   *        positions of the agents. Called by all threads of the team of
+   *        doSteps.
+   */
+  void computeQualityMetrics();
+
+  /**
+   * @brief Deletes the obstacle vertices, including those allocated in blocks
+   *        by loadObstacles.
+   */
+  void deleteObstacles();
+
+  /**
+   * @brief     Records the duration of the phases of a simulation step to
+   *            estimate their cost per agent.
+   * @param[in] velocityTime       The duration in seconds of computing the new
+   *                               velocities.
+   * @param[in] updateTime         The duration in seconds of updating the
+   *                               positions.
+   * @param[in] numVelocityAgents  The count of agents whose new velocities
+   *                               were computed, i.e., that were not deferred.
+   * @param[in] isVelocityParallel Whether the new velocities were computed in
+   *                               parallel.
+   * @param[in] isUpdateParallel   Whether the positions were updated in
+   *                               parallel.
+   */
+  void recordPhaseTimes(double velocityTime, double updateTime,
+                        std::size_t numVelocityAgents, bool isVelocityParallel,
+                        bool isUpdateParallel);
+
+  /**
+   * @brief     Chooses the team of threads for the next simulation steps and
+   *            the phases that run in parallel.
+   * @param[in] numSteps The count of simulation steps that remain.
+   * @return    The count of simulation steps the team is to perform before it
+   *            is chosen again.
+   */
+  std::size_t selectParallelism(std::size_t numSteps);
+
+  /**
+   * @brief     Links the obstacle vertices starting at the specified number
+   *            into an obstacle with the specified vertices.
+   * @param[in] obstacleNo The number of the first obstacle vertex. The
+   *                       obstacle vertices must already be allocated.
+   * @param[in] vertices   List of the vertices of the obstacle.
+   * @param[in] layer      The layer of the obstacle.
+   */
+  void setObstacleVertices(std::size_t obstacleNo,
+                           const std::vector<Vector2> &vertices,
+                           std::size_t layer);
+
+  std::vector<float> agentClearances_;
+  std::vector<std::size_t> agentNumPenetrations_;
+  std::vector<float> agentObstacleClearances_;
+  std::vector<float> agentPenetrationDepths_;
+  std::vector<float> agentSafeTimeSteps_;
   std::vector<Agent *> agents_;
+  std::vector<Obstacle *> obstacleBlocks_;
   std::vector<Obstacle *> obstacles_;
+  std::vector<Agent *> prioritizedAgents_;
+  std::vector<Agent *> scratchAgents_;
+  std::vector<double> threadTeamBarrierTimes_;
+  std::vector<double> threadTeamForkTimes_;
+  std::vector<std::size_t> threadTeamSizes_;
   Agent *defaultAgent_;
   KdTree *kdTree_;
+  PrefVelocityCallback prefVelocityCallback_;
+  void *prefVelocityCallbackContext_;
+  double agentUpdateTime_;
+  double agentVelocityTime_;
+  double barrierTime_;
+  double stepBuildTime_;
+  double stepDeadline_;
+  double stepUpdateTime_;
+  double stepVelocityTime_;
+  std::size_t numAgentPenetrations_;
+  std::size_t numDeferredAgents_;
+  std::size_t numObstaclePenetrations_;
+  std::size_t numSteps_;
+  std::size_t numThreads_;
+  std::size_t parallelUpdateThreshold_;
+  std::size_t parallelVelocityThreshold_;
+  unsigned int perturbationSeed_;
   float globalTime_;
+  float maxTimeStep_;
+  float minClearance_;
+  float minTimeStep_;
+  float penetrationDepth_;
+  float perturbationMagnitude_;
   float timeStep_;
+  bool isAutomaticParallelismEnabled_;
+  bool isConstraintPruningEnabled_;
+  bool isInterpolationEnabled_;
+  bool isIntrospectionEnabled_;
+  bool isQualityMetricsEnabled_;
 
   friend class KdTree;
+  friend class RealTimeRunner;
 };
 } /* namespace RVO */
 
@@ -0,0 +1,169 @@
+/*
+ * RealTimeRunner.cc
+ * RVO2 Library
+ *
+ * SPDX-FileCopyrightText: 2008 University of North Carolina at Chapel Hill
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Please send all bug reports to <geom@cs.unc.edu>.
+ *
+ * The authors may be contacted via:
+ *
+ * Jur van den Berg, Stephen J. Guy, Jamie Snape, Ming C. Lin, Dinesh Manocha
+ * Dept. of Computer Science
+ * 201 S. Columbia St.
+ * Frederick P. Brooks, Jr. Computer Science Bldg.
+ * Chapel Hill, N.C. 27599-3175
+ * United States of America
+ *
+ * <https://gamma.cs.unc.edu/RVO2/>
+ */
+
+/**
+ * @file  RealTimeRunner.cc
+ * @brief Defines the RealTimeRunner class.
+ */
+
+#include "RealTimeRunner.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "LatencyHistogram.h"
+#include "MonotonicClock.h"
+
+namespace RVO {
+namespace {
+/**
+ * @relates RealTimeRunner
+ * @brief   The default maximum count of catch-up steps.
+ */
+const std::size_t RVO_DEFAULT_MAX_CATCH_UP_STEPS = 4U;
+
+/**
+ * @relates RealTimeRunner
+ * @brief   The default count of most recent ticks whose latencies are
+ *          recorded.
+ */
+const std::size_t RVO_DEFAULT_WINDOW_SIZE = 1024U;
+
+/**
+ * @relates RealTimeRunner
+ * @brief   The count of phases whose latencies are recorded.
+ */
+const std::size_t RVO_NUM_REAL_TIME_PHASES = RVO_PHASE_TICK + 1U;
+} /* namespace */
+
+RealTimeRunner::RealTimeRunner(RVOSimulator *simulator)
+    : histograms_(RVO_NUM_REAL_TIME_PHASES),
+      simulator_(simulator),
+      maxCatchUpSteps_(RVO_DEFAULT_MAX_CATCH_UP_STEPS),
+      numOverruns_(0U),
+      numSkippedTicks_(0U),
+      catchUpPolicy_(RVO_CATCH_UP_BURST) {
+  for (std::size_t i = 0U; i < histograms_.size(); ++i) {
+    histograms_[i] = new LatencyHistogram(RVO_DEFAULT_WINDOW_SIZE);
+  }
+}
+
+RealTimeRunner::RealTimeRunner(RVOSimulator *simulator,
+                               std::size_t windowSize)
+    : histograms_(RVO_NUM_REAL_TIME_PHASES),
+      simulator_(simulator),
+      maxCatchUpSteps_(RVO_DEFAULT_MAX_CATCH_UP_STEPS),
+      numOverruns_(0U),
+      numSkippedTicks_(0U),
+      catchUpPolicy_(RVO_CATCH_UP_BURST) {
+  for (std::size_t i = 0U; i < histograms_.size(); ++i) {
+    histograms_[i] = new LatencyHistogram(windowSize);
+  }
+}
+
+RealTimeRunner::~RealTimeRunner() {
+  for (std::size_t i = 0U; i < histograms_.size(); ++i) {
+    delete histograms_[i];
+  }
+}
+
+float RealTimeRunner::getLatency(RealTimePhase phase, float quantile) const {
+  return static_cast<float>(histograms_[phase]->getQuantile(quantile));
+}
+
+void RealTimeRunner::resetStatistics() {
+  for (std::size_t i = 0U; i < histograms_.size(); ++i) {
+    histograms_[i]->reset();
+  }
+
+  numOverruns_ = 0U;
+  numSkippedTicks_ = 0U;
+}
+
+std::size_t RealTimeRunner::run(std::size_t numSteps, StepCallback callback,
+                                void *context) {
+  std::size_t numStepsDone = 0U;
+  bool isRunning = numSteps > 0U;
+  double tickTime = getMonotonicTime();
+
+  while (isRunning) {
+    const double startTime = getMonotonicTime();
+    const float timeStep = simulator_->getTimeStep();
+
+    simulator_->doStep();
+    ++numStepsDone;
+
+    const double stepEndTime = getMonotonicTime();
+
+    isRunning = numStepsDone < numSteps &&
+                (callback == NULL || callback(simulator_, context));
+
+    const double endTime = getMonotonicTime();
+
+    histograms_[RVO_PHASE_LATENESS]->record(startTime - tickTime);
+    histograms_[RVO_PHASE_BUILD]->record(simulator_->stepBuildTime_);
+    histograms_[RVO_PHASE_VELOCITY]->record(simulator_->stepVelocityTime_);
+    histograms_[RVO_PHASE_UPDATE]->record(simulator_->stepUpdateTime_);
+    histograms_[RVO_PHASE_STEP]->record(stepEndTime - startTime);
+    histograms_[RVO_PHASE_CALLBACK]->record(endTime - stepEndTime);
+    histograms_[RVO_PHASE_TICK]->record(endTime - startTime);
+
+    tickTime += timeStep;
+
+    if (endTime > tickTime && timeStep > 0.0F) {
+      ++numOverruns_;
+
+      /* Drop the ticks that are due beyond those to be caught up. */
+      const double numLateTicks = std::floor((endTime - tickTime) / timeStep);
+      const double numDroppedTicks =
+          catchUpPolicy_ == RVO_CATCH_UP_SKIP
+              ? numLateTicks
+              : std::max(0.0, numLateTicks -
+                                  static_cast<double>(maxCatchUpSteps_));
+
+      tickTime += numDroppedTicks * timeStep;
+      numSkippedTicks_ += static_cast<std::size_t>(numDroppedTicks);
+    } else if (isRunning) {
+      sleepUntil(tickTime);
+    }
+  }
+
+  return numStepsDone;
+}
+
+void RealTimeRunner::setCatchUpPolicy(CatchUpPolicy catchUpPolicy,
+                                      std::size_t maxCatchUpSteps) {
+  catchUpPolicy_ = catchUpPolicy;
+  maxCatchUpSteps_ = maxCatchUpSteps;
+}
+} /* namespace RVO */
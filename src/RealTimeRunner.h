@@ -0,0 +1,229 @@
+/*
+ * RealTimeRunner.h
+ * RVO2 Library
+ *
+ * SPDX-FileCopyrightText: 2008 University of North Carolina at Chapel Hill
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Please send all bug reports to <geom@cs.unc.edu>.
+ *
+ * The authors may be contacted via:
+ *
+ * Jur van den Berg, Stephen J. Guy, Jamie Snape, Ming C. Lin, Dinesh Manocha
+ * Dept. of Computer Science
+ * 201 S. Columbia St.
+ * Frederick P. Brooks, Jr. Computer Science Bldg.
+ * Chapel Hill, N.C. 27599-3175
+ * United States of America
+ *
+ * <https://gamma.cs.unc.edu/RVO2/>
+ */
+
+#ifndef RVO_REAL_TIME_RUNNER_H_
+#define RVO_REAL_TIME_RUNNER_H_
+
+/**
+ * @file  RealTimeRunner.h
+ * @brief Declares and defines the RealTimeRunner class.
+ */
+
+#include <cstddef>
+#include <vector>
+
+#include "Export.h"
+#include "RVOSimulator.h"
+
+namespace RVO {
+class LatencyHistogram;
+
+/**
+ * @brief Defines how a real-time runner catches up with the wall clock after
+ *        a tick has overrun into the next.
+ */
+enum CatchUpPolicy {
+  /**
+   * @brief Performs the simulation steps of the ticks that are due back to
+   *        back, dropping the ticks beyond the maximum count of catch-up
+   *        steps.
+   */
+  RVO_CATCH_UP_BURST,
+
+  /**
+   * @brief Performs the simulation step of the next tick at once and drops
+   *        the ticks that are due after it, so that the simulation falls
+   *        behind the wall clock.
+   */
+  RVO_CATCH_UP_SKIP
+};
+
+/**
+ * @brief The phases of a tick of a real-time runner whose latencies are
+ *        recorded.
+ */
+enum RealTimePhase {
+  /**
+   * @brief The delay of the start of the tick after its scheduled time.
+   */
+  RVO_PHASE_LATENESS,
+
+  /**
+   * @brief Building the agent k-D tree.
+   */
+  RVO_PHASE_BUILD,
+
+  /**
+   * @brief Computing the new velocities of the agents.
+   */
+  RVO_PHASE_VELOCITY,
+
+  /**
+   * @brief Updating the positions and velocities of the agents.
+   */
+  RVO_PHASE_UPDATE,
+
+  /**
+   * @brief The whole simulation step.
+   */
+  RVO_PHASE_STEP,
+
+  /**
+   * @brief The step callback.
+   */
+  RVO_PHASE_CALLBACK,
+
+  /**
+   * @brief The whole tick, i.e., the simulation step and the step callback.
+   */
+  RVO_PHASE_TICK
+};
+
+/**
+ * @brief Defines a runner that performs the simulation steps of a simulator
+ *        at the pace of the wall clock, i.e., one simulation step for each
+ *        time step of the simulation, and records the latencies of the
+ *        phases of each tick in histograms of the most recent ticks.
+ */
+class RVO_EXPORT RealTimeRunner {
+ public:
+  /**
+   * @brief     Constructs a real-time runner instance that records the
+   *            latencies of the most recent 1024 ticks.
+   * @param[in] simulator The simulator whose simulation steps are performed.
+   */
+  explicit RealTimeRunner(RVOSimulator *simulator);
+
+  /**
+   * @brief     Constructs a real-time runner instance.
+   * @param[in] simulator  The simulator whose simulation steps are performed.
+   * @param[in] windowSize The count of most recent ticks whose latencies are
+   *                       recorded. Must be positive.
+   */
+  RealTimeRunner(RVOSimulator *simulator, std::size_t windowSize);
+
+  /**
+   * @brief Destroys this real-time runner instance.
+   */
+  ~RealTimeRunner();
+
+  /**
+   * @brief  Returns the policy of catching up after an overrun.
+   * @return The policy of catching up after an overrun.
+   */
+  CatchUpPolicy getCatchUpPolicy() const { return catchUpPolicy_; }
+
+  /**
+   * @brief     Returns the latency of a phase at a specified quantile of the
+   *            most recent ticks, e.g., 0.5 for the median, 0.99 for the 99th
+   *            percentile, and 1 for the maximum.
+   * @param[in] phase    The phase whose latency is to be retrieved.
+   * @param[in] quantile The quantile, between zero and one.
+   * @return    The latency in seconds, rounded up by at most 1/32 of itself, or
+   *            zero before the first tick.
+   * @note      All phases are timed with the same monotonic clock, so the
+   *            latencies of the phases of a simulation step are comparable
+   *            with each other and with that of the whole simulation step.
+   */
+  float getLatency(RealTimePhase phase, float quantile) const;
+
+  /**
+   * @brief  Returns the maximum count of ticks that are due that are caught up
+   *         back to back.
+   * @return The maximum count of catch-up steps.
+   */
+  std::size_t getMaxCatchUpSteps() const { return maxCatchUpSteps_; }
+
+  /**
+   * @brief  Returns the count of ticks that ended after the next tick was due.
+   * @return The count of overruns.
+   */
+  std::size_t getNumOverruns() const { return numOverruns_; }
+
+  /**
+   * @brief  Returns the count of ticks that were dropped to catch up with the
+   *         wall clock.
+   * @return The count of skipped ticks.
+   */
+  std::size_t getNumSkippedTicks() const { return numSkippedTicks_; }
+
+  /**
+   * @brief Removes the recorded latencies and resets the counts of overruns
+   *        and skipped ticks.
+   */
+  void resetStatistics();
+
+  /**
+   * @brief     Performs simulation steps at the pace of the wall clock. Each
+   *            tick performs a simulation step, calls the function, and then
+   *            sleeps until the next tick is due, which is the time step of
+   *            the simulation step after the tick was due.
+   * @param[in] numSteps The maximum count of simulation steps to perform.
+   * @param[in] callback A function called after each simulation step, or
+   *                     NULL. It may query the latencies.
+   * @param[in] context  The context passed to the function.
+   * @return    The count of simulation steps performed, which is less than the
+   *            maximum count if the function stopped the simulation.
+   * @note      As with RVOSimulator::doSteps, the function is not called after
+   *            the last simulation step.
+   */
+  std::size_t run(std::size_t numSteps, StepCallback callback, void *context);
+
+  /**
+   * @brief     Sets the policy of catching up after an overrun. The default is
+   *            RVO_CATCH_UP_BURST with at most four catch-up steps.
+   * @param[in] catchUpPolicy   The policy of catching up after an overrun.
+   * @param[in] maxCatchUpSteps The maximum count of ticks that are due that are
+   *                            caught up back to back. Ignored by
+   *                            RVO_CATCH_UP_SKIP.
+   */
+  void setCatchUpPolicy(CatchUpPolicy catchUpPolicy,
+                        std::size_t maxCatchUpSteps);
+
+ private:
+  /* Not implemented. */
+  RealTimeRunner(const RealTimeRunner &other);
+
+  /* Not implemented. */
+  RealTimeRunner &operator=(const RealTimeRunner &other);
+
+  std::vector<LatencyHistogram *> histograms_;
+  RVOSimulator *simulator_;
+  std::size_t maxCatchUpSteps_;
+  std::size_t numOverruns_;
+  std::size_t numSkippedTicks_;
+  CatchUpPolicy catchUpPolicy_;
+};
+} /* namespace RVO */
+
+#endif /* RVO_REAL_TIME_RUNNER_H_ */
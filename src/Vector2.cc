@@ -38,6 +38,7 @@
 
 #include "Vector2.h"
 
+#include <algorithm>
 #include <cmath>
 #include <ostream>
 
@@ -127,6 +128,82 @@ float det(const Vector2 &vector1, const Vector2 &vector2) {
   return vector1.x() * vector2.y() - vector1.y() * vector2.x();
 }
 
+float distSqBoxLineSegment(const Vector2 &minCorner, const Vector2 &maxCorner,
+                           const Vector2 &vector1, const Vector2 &vector2) {
+  /* Clip the line segment against the box. */
+  const Vector2 segment = vector2 - vector1;
+  const float deltas[4] = {-segment.x(), segment.x(), -segment.y(),
+                           segment.y()};
+  const float offsets[4] = {
+      vector1.x() - minCorner.x(), maxCorner.x() - vector1.x(),
+      vector1.y() - minCorner.y(), maxCorner.y() - vector1.y()};
+  float tMin = 0.0F;
+  float tMax = 1.0F;
+  bool intersects = true;
+
+  for (std::size_t i = 0U; i < 4U && intersects; ++i) {
+    if (deltas[i] == 0.0F) {
+      intersects = offsets[i] >= 0.0F;
+    } else {
+      const float t = offsets[i] / deltas[i];
+
+      if (deltas[i] < 0.0F) {
+        tMin = std::max(tMin, t);
+      } else {
+        tMax = std::min(tMax, t);
+      }
+
+      intersects = tMin <= tMax;
+    }
+  }
+
+  if (intersects) {
+    return 0.0F;
+  }
+
+  /* Disjoint, so the distance is attained at a vertex of either. */
+  float distSq = std::min(distSqBoxPoint(minCorner, maxCorner, vector1),
+                          distSqBoxPoint(minCorner, maxCorner, vector2));
+  distSq =
+      std::min(distSq, distSqPointLineSegment(vector1, vector2, minCorner));
+  distSq =
+      std::min(distSq, distSqPointLineSegment(vector1, vector2, maxCorner));
+  distSq = std::min(
+      distSq, distSqPointLineSegment(vector1, vector2,
+                                     Vector2(minCorner.x(), maxCorner.y())));
+  distSq = std::min(
+      distSq, distSqPointLineSegment(vector1, vector2,
+                                     Vector2(maxCorner.x(), minCorner.y())));
+
+  return distSq;
+}
+
+float distSqBoxPoint(const Vector2 &minCorner, const Vector2 &maxCorner,
+                     const Vector2 &point) {
+  const float distX = std::max(
+      0.0F, std::max(minCorner.x() - point.x(), point.x() - maxCorner.x()));
+  const float distY = std::max(
+      0.0F, std::max(minCorner.y() - point.y(), point.y() - maxCorner.y()));
+
+  return distX * distX + distY * distY;
+}
+
+float distSqPointLineSegment(const Vector2 &vector1, const Vector2 &vector2,
+                             const Vector2 &vector3) {
+  const float r = ((vector3 - vector1) * (vector2 - vector1)) /
+                  absSq(vector2 - vector1);
+
+  if (r < 0.0F) {
+    return absSq(vector3 - vector1);
+  }
+
+  if (r > 1.0F) {
+    return absSq(vector3 - vector2);
+  }
+
+  return absSq(vector3 - (vector1 + r * (vector2 - vector1)));
+}
+
 float leftOf(const Vector2 &vector1, const Vector2 &vector2,
              const Vector2 &vector3) {
   return det(vector1 - vector3, vector2 - vector1);
@@ -248,6 +248,50 @@ RVO_EXPORT float absSq(const Vector2 &vector);
  */
 RVO_EXPORT float det(const Vector2 &vector1, const Vector2 &vector2);
 
+/**
+ * @relates   Vector2
+ * @brief     Computes the squared distance from an axis-aligned box to a
+ *            specified line segment.
+ * @param[in] minCorner The corner of the box with minimum coordinates.
+ * @param[in] maxCorner The corner of the box with maximum coordinates.
+ * @param[in] vector1   The first endpoint of the line segment.
+ * @param[in] vector2   The second endpoint of the line segment.
+ * @return    The squared distance from the box to the line segment, which is
+ *            zero when they intersect.
+ */
+RVO_EXPORT float distSqBoxLineSegment(const Vector2 &minCorner,
+                                      const Vector2 &maxCorner,
+                                      const Vector2 &vector1,
+                                      const Vector2 &vector2);
+
+/**
+ * @relates   Vector2
+ * @brief     Computes the squared distance from an axis-aligned box to a
+ *            specified point.
+ * @param[in] minCorner The corner of the box with minimum coordinates.
+ * @param[in] maxCorner The corner of the box with maximum coordinates.
+ * @param[in] point     The point to which the squared distance is to be
+ *                      calculated.
+ * @return    The squared distance from the box to the point, which is zero
+ *            when the point lies inside the box.
+ */
+RVO_EXPORT float distSqBoxPoint(const Vector2 &minCorner,
+                                const Vector2 &maxCorner, const Vector2 &point);
+
+/**
+ * @relates   Vector2
+ * @brief     Computes the squared distance from a line segment with the
+ *            specified endpoints to a specified point.
+ * @param[in] vector1 The first endpoint of the line segment.
+ * @param[in] vector2 The second endpoint of the line segment.
+ * @param[in] vector3 The point to which the squared distance is to be
+ *                    calculated.
+ * @return    The squared distance from the line segment to the point.
+ */
+RVO_EXPORT float distSqPointLineSegment(const Vector2 &vector1,
+                                        const Vector2 &vector2,
+                                        const Vector2 &vector3);
+
 /**
  * @brief     Computes the signed distance from a line connecting th specified
  *            points to a specified point.
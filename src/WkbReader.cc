@@ -0,0 +1,305 @@
+/*
+ * WkbReader.cc
+ * RVO2 Library
+ *
+ * SPDX-FileCopyrightText: 2008 University of North Carolina at Chapel Hill
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Please send all bug reports to <geom@cs.unc.edu>.
+ *
+ * The authors may be contacted via:
+ *
+ * Jur van den Berg, Stephen J. Guy, Jamie Snape, Ming C. Lin, Dinesh Manocha
+ * Dept. of Computer Science
+ * 201 S. Columbia St.
+ * Frederick P. Brooks, Jr. Computer Science Bldg.
+ * Chapel Hill, N.C. 27599-3175
+ * United States of America
+ *
+ * <https://gamma.cs.unc.edu/RVO2/>
+ */
+
+/**
+ * @file  WkbReader.cc
+ * @brief Defines the WkbReader class.
+ */
+
+#include "WkbReader.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "Vector2.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define RVO_WKB_MMAP 1
+#else
+#include <fstream>
+#define RVO_WKB_MMAP 0
+#endif /* __unix__ || __APPLE__ */
+
+namespace RVO {
+namespace {
+/**
+ * @relates WkbReader
+ * @brief   The size in bytes of the byte order and type of a geometry.
+ */
+const std::size_t RVO_WKB_HEADER_SIZE = 5U;
+
+/**
+ * @relates WkbReader
+ * @brief   The WKB type of a polygon.
+ */
+const std::size_t RVO_WKB_POLYGON = 3U;
+
+/**
+ * @relates WkbReader
+ * @brief   The WKB type of a multipolygon.
+ */
+const std::size_t RVO_WKB_MULTI_POLYGON = 6U;
+
+/**
+ * @relates WkbReader
+ * @brief   The size in bytes of a two-dimensional point.
+ */
+const std::size_t RVO_WKB_POINT_SIZE = 16U;
+
+/**
+ * @relates WkbReader
+ * @brief   Determines whether the host is little-endian.
+ * @return  True if the host is little-endian.
+ */
+bool isHostLittleEndian() {
+  const unsigned int one = 1U;
+  unsigned char byte = 0U;
+  std::memcpy(&byte, &one, 1U);
+
+  return byte == 1U;
+}
+} /* namespace */
+
+WkbReader::Ring::Ring()
+    : numVertices(0U), offset(0U), isExterior(false), isLittleEndian(false) {}
+
+WkbReader::WkbReader(const char *filename)
+    : data_(NULL),
+      mapping_(NULL),
+      numVertices_(0U),
+      size_(0U),
+      isValid_(false) {
+#if RVO_WKB_MMAP
+  const int file = open(filename, O_RDONLY);
+
+  if (file == -1) {
+    return;
+  }
+
+  struct stat status;
+
+  if (fstat(file, &status) == 0) {
+    size_ = static_cast<std::size_t>(status.st_size);
+
+    if (size_ == 0U) {
+      isValid_ = true;
+    } else {
+      void *const mapping = mmap(NULL, size_, PROT_READ, MAP_PRIVATE, file, 0);
+
+      if (mapping != MAP_FAILED) {
+        mapping_ = mapping;
+        data_ = static_cast<const unsigned char *>(mapping);
+        isValid_ = true;
+      }
+    }
+  }
+
+  close(file);
+#else
+  std::ifstream file(filename, std::ios::binary);
+
+  if (!file) {
+    return;
+  }
+
+  file.seekg(0, std::ios::end);
+  const std::streamoff size = file.tellg();
+  file.seekg(0, std::ios::beg);
+
+  if (size < 0) {
+    return;
+  }
+
+  size_ = static_cast<std::size_t>(size);
+  buffer_.resize(size_);
+
+  if (size_ != 0U &&
+      !file.read(reinterpret_cast<char *>(&buffer_[0]),
+                 static_cast<std::streamsize>(size_))) {
+    return;
+  }
+
+  data_ = size_ == 0U ? NULL : &buffer_[0];
+  isValid_ = true;
+#endif /* RVO_WKB_MMAP */
+
+  std::size_t offset = 0U;
+
+  while (isValid_ && offset < size_) {
+    if (size_ - offset < RVO_WKB_HEADER_SIZE || data_[offset] > 1U) {
+      isValid_ = false;
+      break;
+    }
+
+    const bool isLittleEndian = data_[offset] == 1U;
+    const std::size_t type = readUInt32(offset + 1U, isLittleEndian);
+
+    if (type == RVO_WKB_POLYGON) {
+      isValid_ = indexPolygon(offset);
+    } else if (type == RVO_WKB_MULTI_POLYGON &&
+               size_ - offset >= RVO_WKB_HEADER_SIZE + 4U) {
+      const std::size_t numPolygons =
+          readUInt32(offset + RVO_WKB_HEADER_SIZE, isLittleEndian);
+      offset += RVO_WKB_HEADER_SIZE + 4U;
+
+      for (std::size_t i = 0U; isValid_ && i < numPolygons; ++i) {
+        isValid_ = size_ - offset >= RVO_WKB_HEADER_SIZE &&
+                   data_[offset] <= 1U &&
+                   readUInt32(offset + 1U, data_[offset] == 1U) ==
+                       RVO_WKB_POLYGON &&
+                   indexPolygon(offset);
+      }
+    } else {
+      isValid_ = false;
+    }
+  }
+}
+
+WkbReader::~WkbReader() {
+#if RVO_WKB_MMAP
+  if (mapping_ != NULL) {
+    munmap(mapping_, size_);
+  }
+#endif /* RVO_WKB_MMAP */
+}
+
+bool WkbReader::indexPolygon(std::size_t &offset) {
+  /* Byte order and type were checked by the caller. */
+  const bool isLittleEndian = data_[offset] == 1U;
+  offset += RVO_WKB_HEADER_SIZE;
+
+  if (size_ - offset < 4U) {
+    return false;
+  }
+
+  const std::size_t numRings = readUInt32(offset, isLittleEndian);
+  offset += 4U;
+
+  for (std::size_t i = 0U; i < numRings; ++i) {
+    if (size_ - offset < 4U) {
+      return false;
+    }
+
+    const std::size_t numPoints = readUInt32(offset, isLittleEndian);
+    offset += 4U;
+
+    if (numPoints > (size_ - offset) / RVO_WKB_POINT_SIZE) {
+      return false;
+    }
+
+    Ring ring;
+    ring.numVertices = numPoints;
+    ring.offset = offset;
+    ring.isExterior = i == 0U;
+    ring.isLittleEndian = isLittleEndian;
+
+    offset += numPoints * RVO_WKB_POINT_SIZE;
+
+    if (numPoints > 1U &&
+        std::memcmp(data_ + ring.offset,
+                    data_ + offset - RVO_WKB_POINT_SIZE,
+                    RVO_WKB_POINT_SIZE) == 0) {
+      /* Drop the closing vertex. */
+      --ring.numVertices;
+    }
+
+    if (ring.numVertices > 1U) {
+      numVertices_ += ring.numVertices;
+      rings_.push_back(ring);
+    }
+  }
+
+  return true;
+}
+
+double WkbReader::readDouble(std::size_t offset, bool isLittleEndian) const {
+  unsigned char bytes[sizeof(double)];
+  std::memcpy(bytes, data_ + offset, sizeof(double));
+
+  if (isLittleEndian != isHostLittleEndian()) {
+    std::reverse(bytes, bytes + sizeof(double));
+  }
+
+  double value = 0.0;
+  std::memcpy(&value, bytes, sizeof(double));
+
+  return value;
+}
+
+void WkbReader::readRing(std::size_t ringNo,
+                         std::vector<Vector2> &vertices) const {
+  const Ring &ring = rings_[ringNo];
+  vertices.resize(ring.numVertices);
+
+  float signedArea = 0.0F;
+
+  for (std::size_t i = 0U; i < ring.numVertices; ++i) {
+    const std::size_t offset = ring.offset + i * RVO_WKB_POINT_SIZE;
+    vertices[i] = Vector2(
+        static_cast<float>(readDouble(offset, ring.isLittleEndian)),
+        static_cast<float>(readDouble(offset + 8U, ring.isLittleEndian)));
+
+    if (i != 0U) {
+      signedArea += det(vertices[i - 1U], vertices[i]);
+    }
+  }
+
+  signedArea += det(vertices.back(), vertices.front());
+
+  /* Exterior rings are counterclockwise and interior rings are clockwise. */
+  if (ring.isExterior ? signedArea < 0.0F : signedArea > 0.0F) {
+    std::reverse(vertices.begin(), vertices.end());
+  }
+}
+
+std::size_t WkbReader::readUInt32(std::size_t offset,
+                                  bool isLittleEndian) const {
+  const unsigned char *const bytes = data_ + offset;
+
+  if (isLittleEndian) {
+    return static_cast<std::size_t>(bytes[0]) |
+           static_cast<std::size_t>(bytes[1]) << 8U |
+           static_cast<std::size_t>(bytes[2]) << 16U |
+           static_cast<std::size_t>(bytes[3]) << 24U;
+  }
+
+  return static_cast<std::size_t>(bytes[0]) << 24U |
+         static_cast<std::size_t>(bytes[1]) << 16U |
+         static_cast<std::size_t>(bytes[2]) << 8U |
+         static_cast<std::size_t>(bytes[3]);
+}
+} /* namespace RVO */
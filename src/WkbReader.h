@@ -0,0 +1,154 @@
+/*
+ * WkbReader.h
+ * RVO2 Library
+ *
+ * SPDX-FileCopyrightText: 2008 University of North Carolina at Chapel Hill
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Please send all bug reports to <geom@cs.unc.edu>.
+ *
+ * The authors may be contacted via:
+ *
+ * Jur van den Berg, Stephen J. Guy, Jamie Snape, Ming C. Lin, Dinesh Manocha
+ * Dept. of Computer Science
+ * 201 S. Columbia St.
+ * Frederick P. Brooks, Jr. Computer Science Bldg.
+ * Chapel Hill, N.C. 27599-3175
+ * United States of America
+ *
+ * <https://gamma.cs.unc.edu/RVO2/>
+ */
+
+#ifndef RVO_WKB_READER_H_
+#define RVO_WKB_READER_H_
+
+/**
+ * @file  WkbReader.h
+ * @brief Declares the WkbReader class.
+ */
+
+#include <cstddef>
+#include <vector>
+
+namespace RVO {
+class Vector2;
+
+/**
+ * @brief Defines a reader of polygon files consisting of a sequence of
+ *        well-known binary (WKB) Polygon and MultiPolygon geometries in either
+ *        byte order.
+ */
+class WkbReader {
+ private:
+  class Ring;
+
+  /**
+   * @brief     Constructs a WKB reader instance that maps the specified file
+   *            into memory and indexes its rings.
+   * @param[in] filename The name of the file to be read.
+   */
+  explicit WkbReader(const char *filename);
+
+  /**
+   * @brief Destroys this WKB reader instance and unmaps its file.
+   */
+  ~WkbReader();
+
+  /**
+   * @brief          Indexes the rings of the polygon at the specified offset.
+   * @param[in, out] offset The offset of the polygon in the file, advanced past
+   *                        the polygon.
+   * @return         True if the polygon is well-formed; false otherwise.
+   */
+  bool indexPolygon(std::size_t &offset); /* NOLINT(runtime/references) */
+
+  /**
+   * @brief      Reads the vertices of the specified ring, with the exterior
+   *             ring of a polygon in counterclockwise order and its interior
+   *             rings in clockwise order.
+   * @param[in]  ringNo   The number of the ring to be read.
+   * @param[out] vertices The vertices of the ring without its closing vertex.
+   */
+  void readRing(std::size_t ringNo,
+                std::vector<Vector2> &vertices) /* NOLINT(runtime/references) */
+      const;
+
+  /**
+   * @brief     Reads an unsigned 32-bit integer at the specified offset.
+   * @param[in] offset         The offset of the integer in the file.
+   * @param[in] isLittleEndian True if the integer is little-endian.
+   * @return    The integer.
+   */
+  std::size_t readUInt32(std::size_t offset, bool isLittleEndian) const;
+
+  /**
+   * @brief     Reads a double-precision floating-point number at the
+   *            specified offset.
+   * @param[in] offset         The offset of the number in the file.
+   * @param[in] isLittleEndian True if the number is little-endian.
+   * @return    The number.
+   */
+  double readDouble(std::size_t offset, bool isLittleEndian) const;
+
+  /* Not implemented. */
+  WkbReader(const WkbReader &other);
+
+  /* Not implemented. */
+  WkbReader &operator=(const WkbReader &other);
+
+  std::vector<unsigned char> buffer_;
+  std::vector<Ring> rings_;
+  const unsigned char *data_;
+  void *mapping_;
+  std::size_t numVertices_;
+  std::size_t size_;
+  bool isValid_;
+
+  friend class RVOSimulator;
+};
+
+/**
+ * @brief Defines a ring of a polygon in a WKB file.
+ */
+class WkbReader::Ring {
+ public:
+  /**
+   * @brief Constructs a WKB ring instance.
+   */
+  Ring();
+
+  /**
+   * @brief The number of vertices without the closing vertex.
+   */
+  std::size_t numVertices;
+
+  /**
+   * @brief The offset of the first vertex in the file.
+   */
+  std::size_t offset;
+
+  /**
+   * @brief True if the ring is the exterior ring of its polygon.
+   */
+  bool isExterior;
+
+  /**
+   * @brief True if the coordinates of the ring are little-endian.
+   */
+  bool isLittleEndian;
+};
+} /* namespace RVO */
+
+#endif /* RVO_WKB_READER_H_ */